@@ -0,0 +1,98 @@
+/*
+********************************************************************************
+* @file    airtime_test.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host table test of airtime.c against time on air values from the
+*          Semtech LoRa calculator. The parameters are filled in the way
+*          rfm96_time_on_air does, with low data rate optimization switched
+*          on by airtime_ldro_required, so the table also checks where LDRO
+*          starts. Exits with 1 on a mismatch.
+*
+*          Build: cc -std=gnu99 -iquote ../Inc -o airtime_test airtime_test.c
+*                    ../Src/airtime.c
+*          Use:   ./airtime_test
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include "airtime.h"
+
+/* Private types -------------------------------------------------------------*/
+struct airtime_case
+{
+	uint8_t spreading_factor;
+	uint32_t bandwidth;        // Hz
+	uint8_t coding_rate;       // denominator
+	uint16_t preamble_length;
+	uint8_t implicit_header;
+	uint8_t crc_on;
+	uint8_t payload_length;
+	uint8_t ldro;              // expected low data rate optimization
+	uint32_t payload_symbols;  // expected, header included
+	uint32_t time_on_air_us;   // expected, calculator ms truncated to us
+};
+
+/* Private variables ---------------------------------------------------------*/
+static const struct airtime_case cases[] =
+{
+	/* SF  BW      CR  pre IH CRC  PL  LDRO sym  us */
+	{  7, 125000,  5,  8, 0, 1,  10, 0,  28,    41216 },
+	{  7, 250000,  5,  8, 0, 1,   2, 0,  18,    15488 }, // fast profile
+	{  9, 125000,  5,  8, 0, 1,   2, 0,  13,   103424 }, // balanced profile
+	{ 12, 125000,  8,  8, 0, 1,   2, 1,  16,   925696 }, // long range profile
+	{ 12, 125000,  5,  8, 0, 1,  10, 1,  18,   991232 },
+	{  7, 125000,  5,  8, 0, 1, 255, 0, 378,   399616 },
+	{  8, 500000,  6,  8, 0, 0,  20, 0,  38,    25728 },
+	{ 10, 125000,  5,  8, 0, 1,  51, 0,  63,   616448 },
+	{ 11, 125000,  5,  8, 0, 1,  51, 1,  68,  1314816 }, // 16.4 ms symbols
+	{ 11, 250000,  5,  8, 0, 1,  51, 0,  58,   575488 },
+	{ 12, 250000,  5,  8, 0, 1,  51, 1,  63,  1232896 },
+	{ 10,  62500,  7,  8, 0, 1,  16, 1,  43,   905216 },
+	{  9,  62500,  5,  8, 0, 1,  16, 0,  28,   329728 },
+	{  6, 125000,  5, 12, 1, 0,   8, 0,  18,    17536 }, // implicit header
+	{ 12, 125000,  8, 16, 1, 0, 255, 1, 408, 14032896 },
+	{ 10,  41700,  5,  8, 0, 1,  10, 1,  23,   865611 },
+	{  7,   7800,  5,  8, 0, 1,  10, 1,  33,   742564 },
+};
+
+/* Function definitions ------------------------------------------------------*/
+int main(void)
+{
+	struct airtime_params params;
+	const struct airtime_case* c;
+	uint32_t failures = 0;
+	uint32_t symbols;
+	uint32_t time_on_air;
+
+	printf("sf,bw,cr,pl,ldro,symbols,time_on_air_us,expected_us\n");
+	for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		c = &cases[i];
+		params.spreading_factor = c->spreading_factor;
+		params.bandwidth = c->bandwidth;
+		params.coding_rate = c->coding_rate;
+		params.preamble_length = c->preamble_length;
+		params.implicit_header = c->implicit_header;
+		params.crc_on = c->crc_on;
+		params.low_data_rate_opt = airtime_ldro_required(c->spreading_factor, c->bandwidth);
+		params.payload_length = c->payload_length;
+
+		symbols = airtime_payload_symbols(&params);
+		time_on_air = airtime_time_on_air_us(&params);
+		printf("%u,%u,4/%u,%u,%u,%u,%u,%u\n", c->spreading_factor, c->bandwidth,
+			c->coding_rate, c->payload_length, params.low_data_rate_opt, symbols,
+			time_on_air, c->time_on_air_us);
+
+		if(params.low_data_rate_opt != c->ldro || symbols != c->payload_symbols
+			|| time_on_air != c->time_on_air_us)
+		{
+			printf("FAIL case %u\n", (unsigned)i);
+			failures++;
+		}
+	}
+
+	printf("%u failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,308 @@
+/*
+********************************************************************************
+* @file    button_test.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host table test of the press classification in button.c on a
+*          simulated SysTick. Every press and release bounces, three edges
+*          over 3 ms, and each case lists the events the main loop must
+*          take and the tick they must be queued on. Covers short, long
+*          and double presses, the edges of the long press and double
+*          press windows, a spike that settles back, a button held through
+*          boot and a full event queue. After each case the STOP lock must
+*          be released. Exits with 1 on a mismatch.
+*
+*          Build: cc -std=gnu99 -DSTM32L152xC -DUSE_HAL_DRIVER
+*                    -iquote ../Inc -I../Drivers/STM32L1xx_HAL_Driver/Inc
+*                    -I../Drivers/CMSIS/Include
+*                    -I../Drivers/CMSIS/Device/ST/STM32L1xx/Include
+*                    -o button_test button_test.c
+*          Use:   ./button_test
+*
+*          The driver source is included so the EXTI registers and the
+*          Cortex-M intrinsics it uses can be replaced
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include "button.h"
+
+/* Only the EXTI and SysTick interrupts are simulated, one at a time */
+#define __get_PRIMASK()        0
+#define __set_PRIMASK(primask) ((void)(primask))
+#define __disable_irq()
+#undef EXTI
+#define EXTI                   (&test_exti)
+
+static EXTI_TypeDef test_exti;
+
+#include "../Src/button.c"
+
+/* Private defines -----------------------------------------------------------*/
+#define PRESSES                4
+#define EVENTS                 8
+#define BASE_TICK              1000
+#define CASE_TIME              2000  // ms simulated per case
+
+/* Private types -------------------------------------------------------------*/
+/* Ticks after BASE_TICK, a spike has up == down */
+struct press
+{
+	uint32_t down;
+	uint32_t up;
+};
+
+struct event_at
+{
+	uint32_t tick;             // after BASE_TICK
+	enum button_event event;
+};
+
+struct button_case
+{
+	const char* name;
+	struct press presses[PRESSES];
+	uint8_t press_count;
+	struct event_at events[EVENTS];
+	uint8_t event_count;
+};
+
+/* Private variables ---------------------------------------------------------*/
+static const struct button_case cases[] =
+{
+	{ "short",         { {0, 100} }, 1,              { {350, BUTTON_SHORT} }, 1 },
+	{ "long",          { {0, 700} }, 1,              { {500, BUTTON_LONG} }, 1 },
+	{ "just long",     { {0, 500} }, 1,              { {500, BUTTON_LONG} }, 1 },
+	{ "just short",    { {0, 499} }, 1,              { {749, BUTTON_SHORT} }, 1 },
+	{ "double",        { {0, 100}, {200, 300} }, 2,  { {223, BUTTON_DOUBLE} }, 1 },
+	{ "just double",   { {0, 100}, {349, 450} }, 2,  { {372, BUTTON_DOUBLE} }, 1 },
+	{ "two short",     { {0, 100}, {350, 450} }, 2,  { {350, BUTTON_SHORT}, {700, BUTTON_SHORT} }, 2 },
+	{ "long, short",   { {0, 600}, {700, 800} }, 2,  { {500, BUTTON_LONG}, {1050, BUTTON_SHORT} }, 2 },
+	{ "double held",   { {0, 100}, {200, 1200} }, 2, { {223, BUTTON_DOUBLE} }, 1 },
+	{ "spike",         { {0, 0} }, 1,                { {0} }, 0 },
+	{ "spike in hold", { {0, 300}, {100, 100} }, 2,  { {550, BUTTON_SHORT} }, 1 },
+};
+
+static uint32_t now;
+static uint8_t level;              // the pin, 1 while down
+static int32_t locks;              // power STOP locks held
+static uint32_t publishes;
+static uint32_t failures;
+
+/* Private function prototypes -----------------------------------------------*/
+static void check(int ok, const char* what, const char* name);
+static void start(uint8_t down);
+static void edge(uint8_t down);
+static void tick_ms(void);
+static void bounce(uint8_t down);
+static void press_edges(const struct press* press, uint32_t tick);
+static void run_case(const struct button_case* c);
+static void test_held_through_boot(void);
+static void test_full_queue(void);
+
+/* Function definitions ------------------------------------------------------*/
+int main(void)
+{
+	for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		run_case(&cases[i]);
+	}
+	test_held_through_boot();
+	test_full_queue();
+
+	printf("%u failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
+
+uint32_t HAL_GetTick(void)
+{
+	return now;
+}
+
+void BSP_PB_Init(Button_TypeDef Button, ButtonMode_TypeDef Mode)
+{
+}
+
+uint32_t BSP_PB_GetState(Button_TypeDef Button)
+{
+	return level;
+}
+
+void power_stop_lock(void)
+{
+	locks++;
+}
+
+void power_stop_unlock(void)
+{
+	locks--;
+}
+
+void sched_publish(uint32_t events)
+{
+	publishes++;
+}
+
+/* Private function definitions ----------------------------------------------*/
+static void check(int ok, const char* what, const char* name)
+{
+	if(!ok)
+	{
+		printf("FAIL %s: %s\n", name, what);
+		failures++;
+	}
+}
+
+static void start(uint8_t down)
+{
+	now = BASE_TICK;
+	level = down;
+	locks = 0;
+	publishes = 0;
+	test_exti.FTSR = 0;
+	button_init();
+}
+
+static void edge(uint8_t down)
+{
+	level = down;
+	button_exti_irq_handler();
+}
+
+static void tick_ms(void)
+{
+	now++;
+	button_tick();
+}
+
+/*
+ * brief : the edges of one press or release, on the tick it is called on
+ *         and 1 and 3 ms later. Returns on the tick of the last edge
+ */
+static void bounce(uint8_t down)
+{
+	edge(down);
+	tick_ms();
+	edge(!down);
+	tick_ms();
+	tick_ms();
+	edge(down);
+}
+
+/*
+ * brief : the edge a press of the case makes on a tick, see bounce. A
+ *         spike flips the level and flips it back 1 ms later
+ */
+static void press_edges(const struct press* press, uint32_t tick)
+{
+	if(press->up == press->down)
+	{
+		if(tick == press->down || tick == press->down + 1)
+		{
+			edge(!level);
+		}
+		return;
+	}
+
+	if(tick == press->down || tick == press->down + 3 || tick == press->up + 1)
+	{
+		edge(1);
+	}
+	else if(tick == press->up || tick == press->up + 3 || tick == press->down + 1)
+	{
+		edge(0);
+	}
+}
+
+/*
+ * brief : SysTick runs every ms, the main loop takes the events in
+ *         between and each one is matched against the case
+ */
+static void run_case(const struct button_case* c)
+{
+	enum button_event event;
+	uint8_t taken = 0;
+	int match = 1;
+
+	start(0);
+	check(test_exti.FTSR & USER_BUTTON_PIN, "falling edges enabled", c->name);
+	for(; now < BASE_TICK + CASE_TIME; now++)
+	{
+		for(uint8_t p = 0; p < c->press_count; p++)
+		{
+			press_edges(&c->presses[p], now - BASE_TICK);
+		}
+		button_tick();
+
+		while((event = button_get_event()) != BUTTON_NONE)
+		{
+			match &= taken < c->event_count && c->events[taken].event == event
+				&& c->events[taken].tick == now - BASE_TICK;
+			if(taken >= c->event_count || c->events[taken].event != event)
+			{
+				printf("  %s: event %d at %u\n", c->name, event, now - BASE_TICK);
+			}
+			taken++;
+		}
+	}
+
+	check(match && taken == c->event_count, "events and their ticks", c->name);
+	check(publishes == c->event_count, "one publish per event", c->name);
+	check(locks == 0 && !locked, "STOP lock released", c->name);
+}
+
+/*
+ * brief : a button down at boot gives no event when let go
+ */
+static void test_held_through_boot(void)
+{
+	start(1);
+	check(locks == 1, "STOP lock while held at boot", "held through boot");
+	while(now < BASE_TICK + 100)
+	{
+		tick_ms();
+	}
+	bounce(0);
+	while(now < BASE_TICK + CASE_TIME)
+	{
+		tick_ms();
+	}
+	check(button_get_event() == BUTTON_NONE, "no event for the boot press", "held through boot");
+	check(locks == 0, "STOP lock released", "held through boot");
+}
+
+/*
+ * brief : presses the main loop does not take are dropped once the queue
+ *         is full, the ones kept come out in order
+ */
+static void test_full_queue(void)
+{
+	uint8_t count = 0;
+
+	start(0);
+	for(uint32_t p = 0; p < 2 * BUTTON_QUEUE_SIZE; p++)
+	{
+		bounce(1);
+		for(uint32_t ms = 0; ms < 600; ms++)
+		{
+			tick_ms();
+		}
+		bounce(0);
+		for(uint32_t ms = 0; ms < 100; ms++)
+		{
+			tick_ms();
+		}
+	}
+	check(publishes == 2 * BUTTON_QUEUE_SIZE, "every event published", "full queue");
+	while(button_get_event() == BUTTON_LONG)
+	{
+		count++;
+	}
+	check(count == BUTTON_QUEUE_SIZE - 1, "queue keeps BUTTON_QUEUE_SIZE - 1 events", "full queue");
+	check(button_get_event() == BUTTON_NONE, "queue empty after", "full queue");
+
+	button_clear();
+	check(button_get_event() == BUTTON_NONE, "nothing after a clear", "full queue");
+	check(locks == 0, "STOP lock released", "full queue");
+}
@@ -0,0 +1,286 @@
+/*
+********************************************************************************
+* @file    fake_rfm96.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host model of the RFM96 (SX1276) on SPI1, for testing lora.c on
+*          Linux. Replaces spi.c and the HAL calls the driver makes. Decodes
+*          each NSS framed burst the way the chip does: an address byte with
+*          the write bit, then data bytes to consecutive registers, or to the
+*          256 byte FIFO at REG_FIFO_ADDR_PTR. Counts NSS assertions and the
+*          bytes clocked, so the tests can check the bus traffic. Bursts
+*          made outside the DIO0 interrupt while it is unmasked are counted,
+*          the interrupt's FIFO drain could split them on the target
+********************************************************************************
+*/
+
+#include "fake_rfm96.h"
+
+/* Variables -----------------------------------------------------------------*/
+struct fake_rfm96 fake_rfm96;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t fake_rfm96_clock(uint8_t mosi);
+static void fake_rfm96_write_reg(uint8_t address, uint8_t value);
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief : power on state, registers cleared apart from the version
+ */
+void fake_rfm96_reset(void)
+{
+	memset(&fake_rfm96, 0, sizeof(fake_rfm96));
+	fake_rfm96.regs[REG_VERSION] = RFM96_VERSION;
+}
+
+/*
+ * brief    : a packet arrives over the air. It is written to the FIFO after
+ *            the previous one and RX done is flagged, as in continuous receive
+ * rssi_reg : REG_PKT_RSSI_VALUE
+ * snr_reg  : REG_PKT_SNR_VALUE, quarter dB
+ */
+void fake_rfm96_receive(const uint8_t* payload, uint8_t length, uint8_t rssi_reg, uint8_t snr_reg)
+{
+	uint8_t addr = fake_rfm96.rx_addr;
+
+	for(uint8_t i = 0; i < length; i++)
+	{
+		fake_rfm96.fifo[(uint8_t)(addr + i)] = payload[i];
+	}
+	fake_rfm96.rx_addr = (uint8_t)(addr + length);
+
+	fake_rfm96.regs[REG_FIFO_RX_CURRENT_ADDR] = addr;
+	fake_rfm96.regs[REG_RX_NB_BYTES] = length;
+	fake_rfm96.regs[REG_PKT_RSSI_VALUE] = rssi_reg;
+	fake_rfm96.regs[REG_PKT_SNR_VALUE] = snr_reg;
+	fake_rfm96.regs[REG_IRQ_FLAGS] |= IRQ_RX_DONE_MASK;
+}
+
+/*
+ * brief : a packet that lands right after the driver next clears the IRQ 
+ *         flags, while its handler is still running
+ */
+void fake_rfm96_receive_on_clear(const uint8_t* payload, uint8_t length, uint8_t rssi_reg, uint8_t snr_reg)
+{
+	memcpy(fake_rfm96.staged_payload, payload, length);
+	fake_rfm96.staged_length = length;
+	fake_rfm96.staged_rssi_reg = rssi_reg;
+	fake_rfm96.staged_snr_reg = snr_reg;
+	fake_rfm96.staged = 1;
+}
+
+/*
+ * brief : a DIO0 edge, the handler runs now or once the line is unmasked
+ */
+void fake_rfm96_dio0_irq(void)
+{
+	if(fake_rfm96.dio0_masked)
+	{
+		fake_rfm96.dio0_pending = 1;
+		return;
+	}
+
+	fake_rfm96.in_irq = 1;
+	rfm96_dio0_irq_handler();
+	fake_rfm96.in_irq = 0;
+}
+
+/* SPI1 and NSS --------------------------------------------------------------*/
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+	if(GPIOx != RFM96_NSS_PORT || GPIO_Pin != RFM96_NSS_PIN)
+	{
+		return;
+	}
+
+	if(PinState == GPIO_PIN_RESET && !fake_rfm96.selected)
+	{
+		fake_rfm96.selected = 1;
+		fake_rfm96.have_address = 0;
+		fake_rfm96.burst_bytes = 0;
+		fake_rfm96.nss_assertions++;
+		if(!fake_rfm96.in_irq && !fake_rfm96.dio0_masked)
+		{
+			fake_rfm96.unguarded_bursts++;
+		}
+	}
+	else if(PinState == GPIO_PIN_SET)
+	{
+		fake_rfm96.selected = 0;
+	}
+}
+
+void spi_transmit(uint8_t* tx_data, size_t num_bytes)
+{
+	for(size_t i = 0; i < num_bytes; i++)
+	{
+		fake_rfm96_clock(tx_data[i]);
+	}
+}
+
+void spi_receive(uint8_t* rx_data, size_t num_bytes)
+{
+	for(size_t i = 0; i < num_bytes; i++)
+	{
+		rx_data[i] = fake_rfm96_clock(0x00);
+	}
+}
+
+void spi_transmit_receive(uint8_t* tx_data, uint8_t* rx_data, size_t num_bytes)
+{
+	for(size_t i = 0; i < num_bytes; i++)
+	{
+		rx_data[i] = fake_rfm96_clock(tx_data[i]);
+	}
+}
+
+void spi_set_prescaler(uint32_t prescaler)
+{
+}
+
+uint32_t spi_get_clock(void)
+{
+	return RFM96_SPI_MAX_CLOCK;
+}
+
+/* The rest of the board lora.c calls into -----------------------------------*/
+void HAL_Delay(uint32_t Delay)
+{
+}
+
+uint32_t HAL_GetTick(void)
+{
+	return 0;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+	if(IRQn != RFM96_DIO0_EXTI_IRQn)
+	{
+		return;
+	}
+
+	fake_rfm96.dio0_masked = 0;
+	if(fake_rfm96.dio0_pending)
+	{
+		fake_rfm96.dio0_pending = 0;
+		fake_rfm96_dio0_irq();
+	}
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+	if(IRQn == RFM96_DIO0_EXTI_IRQn)
+	{
+		fake_rfm96.dio0_masked = 1;
+	}
+}
+
+void timer_init(struct timer* timer, timer_callback callback, void* arg)
+{
+}
+
+void timer_start(struct timer* timer, uint32_t delay, uint32_t period)
+{
+}
+
+void timer_stop(struct timer* timer)
+{
+}
+
+void sched_publish(uint32_t events)
+{
+}
+
+void power_wait(uint32_t timeout)
+{
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief  : one byte on the bus, MISO is shifted out while MOSI is shifted in
+ * retval : the MISO byte
+ */
+static uint8_t fake_rfm96_clock(uint8_t mosi)
+{
+	uint8_t miso = 0x00;
+	uint8_t ptr;
+
+	if(!fake_rfm96.selected)
+	{
+		fake_rfm96.stray_bytes++;
+		return miso;
+	}
+	fake_rfm96.bus_bytes++;
+	fake_rfm96.burst_bytes++;
+
+	if(!fake_rfm96.have_address)
+	{
+		fake_rfm96.address = mosi & WNR_READ_ACCESS;
+		fake_rfm96.write = (mosi & WNR_WRITE_ACCESS) != 0;
+		fake_rfm96.have_address = 1;
+		return miso;
+	}
+
+	/* The FIFO stays at its address, the pointer moves instead */
+	if(fake_rfm96.address == REG_FIFO)
+	{
+		ptr = fake_rfm96.regs[REG_FIFO_ADDR_PTR];
+		if(fake_rfm96.write)
+		{
+			fake_rfm96.fifo[ptr] = mosi;
+		}
+		else
+		{
+			miso = fake_rfm96.fifo[ptr];
+		}
+		fake_rfm96.regs[REG_FIFO_ADDR_PTR] = (uint8_t)(ptr + 1);
+		return miso;
+	}
+
+	if(fake_rfm96.write)
+	{
+		fake_rfm96_write_reg(fake_rfm96.address, mosi);
+	}
+	else
+	{
+		miso = fake_rfm96.regs[fake_rfm96.address];
+	}
+	fake_rfm96.address = (fake_rfm96.address + 1) % RFM96_NUM_REGS;
+	return miso;
+}
+
+static void fake_rfm96_write_reg(uint8_t address, uint8_t value)
+{
+	switch(address)
+	{
+		/* Flags are cleared by writing ones */
+		case REG_IRQ_FLAGS:
+			fake_rfm96.regs[address] &= ~value;
+			if(fake_rfm96.staged)
+			{
+				fake_rfm96.staged = 0;
+				fake_rfm96_receive(fake_rfm96.staged_payload, fake_rfm96.staged_length,
+					fake_rfm96.staged_rssi_reg, fake_rfm96.staged_snr_reg);
+			}
+			break;
+
+		/* Entering continuous receive restarts at the RX base address */
+		case REG_OP_MODE:
+			if(value == (MODE_LONG_RANGE_MODE | MODE_RX_CONTINUOUS)
+				&& fake_rfm96.regs[address] != value)
+			{
+				fake_rfm96.rx_addr = fake_rfm96.regs[REG_FIFO_RX_BASE_ADDR];
+			}
+			fake_rfm96.regs[address] = value;
+			break;
+
+		case REG_VERSION:
+			break;
+
+		default:
+			fake_rfm96.regs[address] = value;
+			break;
+	}
+}
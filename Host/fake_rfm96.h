@@ -0,0 +1,60 @@
+/*
+********************************************************************************
+* @file    fake_rfm96.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for fake_rfm96.c. Include it before ../Src/lora.c, it
+*          replaces the Cortex-M intrinsics the driver uses
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __fake_rfm96_H
+#define __fake_rfm96_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "lora.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define FAKE_RFM96_FIFO_SIZE   256
+
+/* Only the DIO0 interrupt is simulated, by fake_rfm96_dio0_irq */
+#define __get_PRIMASK()        0
+#define __set_PRIMASK(primask) ((void)(primask))
+#define __disable_irq()
+
+/* Structs -------------------------------------------------------------------*/
+struct fake_rfm96
+{
+	uint8_t regs[RFM96_NUM_REGS];
+	uint8_t fifo[FAKE_RFM96_FIFO_SIZE];
+	uint8_t rx_addr;             // where the next received packet is written
+	uint8_t selected;            // NSS is low
+	uint8_t address;             // register of the next data byte
+	uint8_t write;               // the burst writes
+	uint8_t have_address;        // first byte of the burst was clocked
+	uint32_t nss_assertions;     // NSS falling edges
+	uint32_t burst_bytes;        // bytes clocked in the current burst
+	uint32_t bus_bytes;          // bytes clocked with NSS low
+	uint32_t stray_bytes;        // bytes clocked with NSS high
+	uint8_t dio0_masked;         // HAL_NVIC_DisableIRQ on the DIO0 line
+	uint8_t dio0_pending;        // an edge came while masked
+	uint8_t in_irq;              // the DIO0 handler is running
+	uint32_t unguarded_bursts;   // main context bursts with DIO0 unmasked
+	uint8_t staged;              // a packet lands when the flags are cleared
+	uint8_t staged_payload[FAKE_RFM96_FIFO_SIZE];
+	uint8_t staged_length;
+	uint8_t staged_rssi_reg;
+	uint8_t staged_snr_reg;
+};
+
+/* External variables --------------------------------------------------------*/
+extern struct fake_rfm96 fake_rfm96;
+
+/* Function declarations -----------------------------------------------------*/
+void fake_rfm96_reset(void);
+void fake_rfm96_receive(const uint8_t* payload, uint8_t length, uint8_t rssi_reg, uint8_t snr_reg);
+void fake_rfm96_receive_on_clear(const uint8_t* payload, uint8_t length, uint8_t rssi_reg, uint8_t snr_reg);
+void fake_rfm96_dio0_irq(void);
+
+#endif // __fake_rfm96_H
@@ -0,0 +1,382 @@
+/*
+********************************************************************************
+* @file    glass_lcd_test.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host test of the glyph tables in stm32l152c_discovery_glass_lcd.c.
+*          Draws every character code at every digit position, with and 
+*          without the point and the colon, through the table driven 
+*          BSP_LCD_GLASS_DisplayChar and through the Convert based path it 
+*          replaced, kept below as the reference. Both start from the same 
+*          random LCD RAM contents and must leave it bit for bit equal. 
+*          Exits with 1 on a mismatch.
+*
+*          Build: cc -funsigned-char -std=gnu99 -DSTM32L152xC -DUSE_HAL_DRIVER
+*                    -iquote ../Inc -I../Drivers/STM32L1xx_HAL_Driver/Inc
+*                    -I../Drivers/CMSIS/Include
+*                    -I../Drivers/CMSIS/Device/ST/STM32L1xx/Include
+*                    -o glass_lcd_test glass_lcd_test.c
+*          Use:   ./glass_lcd_test
+*
+*          The driver source is included so its static frame shadow can be 
+*          read. Plain char is unsigned as with IAR, the reference compares
+*          against Latin-1 codes
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include "stm32l1xx_hal.h"
+
+/* HAL calls the driver makes, none of them reach hardware here */
+static HAL_StatusTypeDef test_lcd_init(LCD_HandleTypeDef* hlcd) { return HAL_OK; }
+static HAL_StatusTypeDef test_lcd_deinit(LCD_HandleTypeDef* hlcd) { return HAL_OK; }
+static void test_gpio_init(GPIO_TypeDef* port, GPIO_InitTypeDef* init) { }
+static void test_gpio_deinit(GPIO_TypeDef* port, uint32_t pin) { }
+static uint32_t test_get_tick(void) { return 0; }
+static void test_delay(uint32_t delay) { }
+HAL_StatusTypeDef LCD_WaitForSynchro(LCD_HandleTypeDef* hlcd) { return HAL_OK; }
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef* init) { return HAL_OK; }
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef* init) { return HAL_OK; }
+
+#define HAL_LCD_Init           test_lcd_init
+#define HAL_LCD_DeInit         test_lcd_deinit
+#define HAL_GPIO_Init          test_gpio_init
+#define HAL_GPIO_DeInit        test_gpio_deinit
+#define HAL_GetTick            test_get_tick
+#define HAL_Delay              test_delay
+
+#include "../Src/stm32l152c_discovery_glass_lcd.c"
+
+/* Private defines -----------------------------------------------------------*/
+#define ASCII_CHAR_0                  0x30  /* 0 */
+#define ASCII_CHAR_AT_SYMBOL          0x40  /* @ */
+#define ASCII_CHAR_LEFT_OPEN_BRACKET  0x5B  /* [ */
+#define ASCII_CHAR_APOSTROPHE         0x60  /* ` */
+#define ASCII_CHAR_LEFT_OPEN_BRACE    0x7B  /* ( */
+
+/* Private variables ---------------------------------------------------------*/
+static LCD_TypeDef test_lcd;
+static uint32_t RefFrame[LCD_RAM_REGISTER15 + 1];
+
+/* Reference: the drawing path before the glyph tables, unchanged apart from
+ * the names and writing to RefFrame ------------------------------------------*/
+static void RefFrameWrite(uint32_t RAMRegisterIndex, uint32_t RAMRegisterMask, uint32_t Data)
+{
+  RefFrame[RAMRegisterIndex] = (RefFrame[RAMRegisterIndex] & RAMRegisterMask) | Data;
+}
+
+static const uint16_t RefCapLetterMap[26]=
+    {
+        /* A      B      C      D      E      F      G      H      I  */
+        0xFE00, 0x6714, 0x1D00, 0x4714, 0x9D00, 0x9C00, 0x3F00, 0xFA00, 0x0014,
+        /* J      K      L      M      N      O      P      Q      R  */
+        0x5300, 0x9841, 0x1900, 0x5A48, 0x5A09, 0x5F00, 0xFC00, 0x5F01, 0xFC01,
+        /* S      T      U      V      W      X      Y      Z  */
+        0xAF00, 0x0414, 0x5b00, 0x18C0, 0x5A81, 0x00C9, 0x0058, 0x05C0
+    };
+
+/* Constant table for number '0' --> '9' */
+static const uint16_t RefNumberMap[10]=
+    {
+        /* 0      1      2      3      4      5      6      7      8      9  */
+        0x5F00,0x4200,0xF500,0x6700,0xEa00,0xAF00,0xBF00,0x04600,0xFF00,0xEF00
+    };
+
+static uint32_t RefDigit[4];     /* Digit frame buffer */
+
+static void RefConvert(uint8_t* Char, Point_Typedef Point, DoublePoint_Typedef DoublePoint)
+{
+  uint16_t ch = 0 ;
+  uint8_t loop = 0, index = 0;
+  
+  switch (*Char)
+    {
+    case ' ' :
+      ch = 0x00;
+      break;
+
+    case '*':
+      ch = C_STAR;
+      break;
+
+    case '(' :
+      ch = C_OPENPARMAP;
+      break;
+
+    case ')' :
+      ch = C_CLOSEPARMAP;
+      break;
+      
+    case 'm' :
+      ch = C_MMAP;
+      break;
+    
+    case 'n' :
+      ch = C_NMAP;
+      break;
+
+    case 0xB5 : /* micro sign */
+      ch = C_UMAP;
+      break;
+
+    case '-' :
+      ch = C_MINUS;
+      break;
+
+    case '/' :
+      ch = C_SLATCH;
+      break;  
+      
+    case 0xB0 : /* degree sign */
+      ch = C_PERCENT_1;
+      break;  
+    case '%' :
+      ch = C_PERCENT_2; 
+      break;
+    case 255 :
+      ch = C_FULL;
+      break ;
+    
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':      
+      ch = RefNumberMap[*Char - ASCII_CHAR_0];    
+      break;
+          
+    default:
+      /* The character Char is one letter in upper case*/
+      if ( (*Char < ASCII_CHAR_LEFT_OPEN_BRACKET) && (*Char > ASCII_CHAR_AT_SYMBOL) )
+      {
+        ch = RefCapLetterMap[*Char - 'A'];
+      }
+      /* The character Char is one letter in lower case*/
+      if ( (*Char < ASCII_CHAR_LEFT_OPEN_BRACE) && ( *Char > ASCII_CHAR_APOSTROPHE) )
+      {
+        ch = RefCapLetterMap[*Char - 'a'];
+      }
+      break;
+  }
+       
+  /* Set the digital point can be displayed if the point is on */
+  if (Point == POINT_ON)
+  {
+    ch |= 0x0002;
+  }
+
+  /* Set the "COL" segment in the character that can be displayed if the column is on */
+  if (DoublePoint == DOUBLEPOINT_ON)
+  {
+    ch |= 0x0020;
+  }    
+
+  for (loop = 12,index=0 ;index < 4; loop -= 4,index++)
+  {
+    RefDigit[index] = (ch >> loop) & 0x0f; /*To isolate the less signifiant dibit */
+  }
+}
+
+static void RefDisplayChar(uint8_t* ch, Point_Typedef Point, DoublePoint_Typedef Column, DigitPosition_Typedef Position)
+{
+  uint32_t data =0x00;
+  /* To convert displayed character in segment in array digit */
+  RefConvert(ch, (Point_Typedef)Point, (DoublePoint_Typedef)Column);
+
+  switch (Position)
+  {
+    /* Position 1 on LCD (Digit1)*/
+    case LCD_DIGIT_POSITION_1:
+      data = ((RefDigit[0] & 0x1) << LCD_SEG0_SHIFT) | (((RefDigit[0] & 0x2) >> 1) << LCD_SEG1_SHIFT)
+          | (((RefDigit[0] & 0x4) >> 2) << LCD_SEG22_SHIFT) | (((RefDigit[0] & 0x8) >> 3) << LCD_SEG23_SHIFT);
+      RefFrameWrite(LCD_DIGIT1_COM0, LCD_DIGIT1_COM0_SEG_MASK, data); /* 1G 1B 1M 1E */
+      
+      data = ((RefDigit[1] & 0x1) << LCD_SEG0_SHIFT) | (((RefDigit[1] & 0x2) >> 1) << LCD_SEG1_SHIFT)
+          | (((RefDigit[1] & 0x4) >> 2) << LCD_SEG22_SHIFT) | (((RefDigit[1] & 0x8) >> 3) << LCD_SEG23_SHIFT);
+      RefFrameWrite(LCD_DIGIT1_COM1, LCD_DIGIT1_COM1_SEG_MASK, data) ; /* 1F 1A 1C 1D  */
+      
+      data = ((RefDigit[2] & 0x1) << LCD_SEG0_SHIFT) | (((RefDigit[2] & 0x2) >> 1) << LCD_SEG1_SHIFT)
+          | (((RefDigit[2] & 0x4) >> 2) << LCD_SEG22_SHIFT) | (((RefDigit[2] & 0x8) >> 3) << LCD_SEG23_SHIFT);
+      RefFrameWrite(LCD_DIGIT1_COM2, LCD_DIGIT1_COM2_SEG_MASK, data) ; /* 1Q 1K 1Col 1P  */
+      
+      data = ((RefDigit[3] & 0x1) << LCD_SEG0_SHIFT) | (((RefDigit[3] & 0x2) >> 1) << LCD_SEG1_SHIFT)
+          | (((RefDigit[3] & 0x4) >> 2) << LCD_SEG22_SHIFT) | (((RefDigit[3] & 0x8) >> 3) << LCD_SEG23_SHIFT);
+      RefFrameWrite(LCD_DIGIT1_COM3, LCD_DIGIT1_COM3_SEG_MASK, data) ; /* 1H 1J 1DP 1N  */
+      break;
+
+    /* Position 2 on LCD (Digit2)*/
+    case LCD_DIGIT_POSITION_2:
+      data = ((RefDigit[0] & 0x1) << LCD_SEG2_SHIFT) | (((RefDigit[0] & 0x2) >> 1) << LCD_SEG3_SHIFT)
+          | (((RefDigit[0] & 0x4) >> 2) << LCD_SEG20_SHIFT) | (((RefDigit[0] & 0x8) >> 3) << LCD_SEG21_SHIFT);
+      RefFrameWrite(LCD_DIGIT2_COM0, LCD_DIGIT2_COM0_SEG_MASK, data); /* 2G 2B 2M 2E */
+      
+      data = ((RefDigit[1] & 0x1) << LCD_SEG2_SHIFT) | (((RefDigit[1] & 0x2) >> 1) << LCD_SEG3_SHIFT)
+          | (((RefDigit[1] & 0x4) >> 2) << LCD_SEG20_SHIFT) | (((RefDigit[1] & 0x8) >> 3) << LCD_SEG21_SHIFT);
+      RefFrameWrite(LCD_DIGIT2_COM1, LCD_DIGIT2_COM1_SEG_MASK, data) ; /* 2F 2A 2C 2D  */
+      
+      data = ((RefDigit[2] & 0x1) << LCD_SEG2_SHIFT) | (((RefDigit[2] & 0x2) >> 1) << LCD_SEG3_SHIFT)
+          | (((RefDigit[2] & 0x4) >> 2) << LCD_SEG20_SHIFT) | (((RefDigit[2] & 0x8) >> 3) << LCD_SEG21_SHIFT);
+      RefFrameWrite(LCD_DIGIT2_COM2, LCD_DIGIT2_COM2_SEG_MASK, data) ; /* 2Q 2K 2Col 2P  */
+      
+      data = ((RefDigit[3] & 0x1) << LCD_SEG2_SHIFT) | (((RefDigit[3] & 0x2) >> 1) << LCD_SEG3_SHIFT)
+          | (((RefDigit[3] & 0x4) >> 2) << LCD_SEG20_SHIFT) | (((RefDigit[3] & 0x8) >> 3) << LCD_SEG21_SHIFT);
+      RefFrameWrite(LCD_DIGIT2_COM3, LCD_DIGIT2_COM3_SEG_MASK, data) ; /* 2H 2J 2DP 2N  */
+      break;
+    
+    /* Position 3 on LCD (Digit3)*/
+    case LCD_DIGIT_POSITION_3:
+      data = ((RefDigit[0] & 0x1) << LCD_SEG4_SHIFT) | (((RefDigit[0] & 0x2) >> 1) << LCD_SEG5_SHIFT)
+          | (((RefDigit[0] & 0x4) >> 2) << LCD_SEG18_SHIFT) | (((RefDigit[0] & 0x8) >> 3) << LCD_SEG19_SHIFT);
+      RefFrameWrite(LCD_DIGIT3_COM0, LCD_DIGIT3_COM0_SEG_MASK, data); /* 3G 3B 3M 3E */
+      
+      data = ((RefDigit[1] & 0x1) << LCD_SEG4_SHIFT) | (((RefDigit[1] & 0x2) >> 1) << LCD_SEG5_SHIFT)
+          | (((RefDigit[1] & 0x4) >> 2) << LCD_SEG18_SHIFT) | (((RefDigit[1] & 0x8) >> 3) << LCD_SEG19_SHIFT);
+      RefFrameWrite(LCD_DIGIT3_COM1, LCD_DIGIT3_COM1_SEG_MASK, data) ; /* 3F 3A 3C 3D  */
+      
+      data = ((RefDigit[2] & 0x1) << LCD_SEG4_SHIFT) | (((RefDigit[2] & 0x2) >> 1) << LCD_SEG5_SHIFT)
+          | (((RefDigit[2] & 0x4) >> 2) << LCD_SEG18_SHIFT) | (((RefDigit[2] & 0x8) >> 3) << LCD_SEG19_SHIFT);
+      RefFrameWrite(LCD_DIGIT3_COM2, LCD_DIGIT3_COM2_SEG_MASK, data) ; /* 3Q 3K 3Col 3P  */
+      
+      data = ((RefDigit[3] & 0x1) << LCD_SEG4_SHIFT) | (((RefDigit[3] & 0x2) >> 1) << LCD_SEG5_SHIFT)
+          | (((RefDigit[3] & 0x4) >> 2) << LCD_SEG18_SHIFT) | (((RefDigit[3] & 0x8) >> 3) << LCD_SEG19_SHIFT);
+      RefFrameWrite(LCD_DIGIT3_COM3, LCD_DIGIT3_COM3_SEG_MASK, data) ; /* 3H 3J 3DP 3N  */
+      break;
+    
+    /* Position 4 on LCD (Digit4)*/
+    case LCD_DIGIT_POSITION_4:
+      data = ((RefDigit[0] & 0x1) << LCD_SEG6_SHIFT) | (((RefDigit[0] & 0x8) >> 3) << LCD_SEG17_SHIFT);
+      RefFrameWrite(LCD_DIGIT4_COM0, LCD_DIGIT4_COM0_SEG_MASK, data); /* 4G 4B 4M 4E */
+      
+      data = (((RefDigit[0] & 0x2) >> 1) << LCD_SEG7_SHIFT) | (((RefDigit[0] & 0x4) >> 2) << LCD_SEG16_SHIFT);
+      RefFrameWrite(LCD_DIGIT4_COM0_1, LCD_DIGIT4_COM0_1_SEG_MASK, data); /* 4G 4B 4M 4E */
+      
+      data = ((RefDigit[1] & 0x1) << LCD_SEG6_SHIFT) | (((RefDigit[1] & 0x8) >> 3) << LCD_SEG17_SHIFT);
+      RefFrameWrite(LCD_DIGIT4_COM1, LCD_DIGIT4_COM1_SEG_MASK, data) ; /* 4F 4A 4C 4D  */
+      
+      data = (((RefDigit[1] & 0x2) >> 1) << LCD_SEG7_SHIFT) | (((RefDigit[1] & 0x4) >> 2) << LCD_SEG16_SHIFT);
+      RefFrameWrite(LCD_DIGIT4_COM1_1, LCD_DIGIT4_COM1_1_SEG_MASK, data) ; /* 4F 4A 4C 4D  */
+      
+      data = ((RefDigit[2] & 0x1) << LCD_SEG6_SHIFT) | (((RefDigit[2] & 0x8) >> 3) << LCD_SEG17_SHIFT);
+      RefFrameWrite(LCD_DIGIT4_COM2, LCD_DIGIT4_COM2_SEG_MASK, data) ; /* 4Q 4K 4Col 4P  */
+      
+      data = (((RefDigit[2] & 0x2) >> 1) << LCD_SEG7_SHIFT) | (((RefDigit[2] & 0x4) >> 2) << LCD_SEG16_SHIFT);
+      RefFrameWrite(LCD_DIGIT4_COM2_1, LCD_DIGIT4_COM2_1_SEG_MASK, data) ; /* 4Q 4K 4Col 4P  */
+      
+      data = ((RefDigit[3] & 0x1) << LCD_SEG6_SHIFT) | (((RefDigit[3] & 0x8) >> 3) << LCD_SEG17_SHIFT);
+      RefFrameWrite(LCD_DIGIT4_COM3, LCD_DIGIT4_COM3_SEG_MASK, data) ; /* 4H 4J 4DP 4N  */
+      
+      data = (((RefDigit[3] & 0x2) >> 1) << LCD_SEG7_SHIFT) | (((RefDigit[3] & 0x4) >> 2) << LCD_SEG16_SHIFT);
+      RefFrameWrite(LCD_DIGIT4_COM3_1, LCD_DIGIT4_COM3_1_SEG_MASK, data) ; /* 4H 4J 4DP 4N  */
+      break;
+    
+    /* Position 5 on LCD (Digit5)*/
+    case LCD_DIGIT_POSITION_5:
+       data = (((RefDigit[0] & 0x2) >> 1) << LCD_SEG9_SHIFT) | (((RefDigit[0] & 0x4) >> 2) << LCD_SEG14_SHIFT);
+      RefFrameWrite(LCD_DIGIT5_COM0, LCD_DIGIT5_COM0_SEG_MASK, data); /* 5G 5B 5M 5E */
+      
+      data = ((RefDigit[0] & 0x1) << LCD_SEG8_SHIFT) | (((RefDigit[0] & 0x8) >> 3) << LCD_SEG15_SHIFT);
+      RefFrameWrite(LCD_DIGIT5_COM0_1, LCD_DIGIT5_COM0_1_SEG_MASK, data); /* 5G 5B 5M 5E */
+      
+      data = (((RefDigit[1] & 0x2) >> 1) << LCD_SEG9_SHIFT) | (((RefDigit[1] & 0x4) >> 2) << LCD_SEG14_SHIFT);
+      RefFrameWrite(LCD_DIGIT5_COM1, LCD_DIGIT5_COM1_SEG_MASK, data) ; /* 5F 5A 5C 5D */
+      
+       data = ((RefDigit[1] & 0x1) << LCD_SEG8_SHIFT) | (((RefDigit[1] & 0x8) >> 3) << LCD_SEG15_SHIFT);
+      RefFrameWrite(LCD_DIGIT5_COM1_1, LCD_DIGIT5_COM1_1_SEG_MASK, data) ; /* 5F 5A 5C 5D */
+      
+      data = (((RefDigit[2] & 0x2) >> 1) << LCD_SEG9_SHIFT) | (((RefDigit[2] & 0x4) >> 2) << LCD_SEG14_SHIFT);
+      RefFrameWrite(LCD_DIGIT5_COM2, LCD_DIGIT5_COM2_SEG_MASK, data) ; /* 5Q 5K 5P */
+      
+      data = ((RefDigit[2] & 0x1) << LCD_SEG8_SHIFT) | (((RefDigit[2] & 0x8) >> 3) << LCD_SEG15_SHIFT);
+      RefFrameWrite(LCD_DIGIT5_COM2_1, LCD_DIGIT5_COM2_1_SEG_MASK, data) ; /* 5Q 5K 5P */
+      
+      data = (((RefDigit[3] & 0x2) >> 1) << LCD_SEG9_SHIFT) | (((RefDigit[3] & 0x4) >> 2) << LCD_SEG14_SHIFT);
+      RefFrameWrite(LCD_DIGIT5_COM3, LCD_DIGIT5_COM3_SEG_MASK, data) ; /* 5H 5J 5N */
+      
+      data = ((RefDigit[3] & 0x1) << LCD_SEG8_SHIFT) | (((RefDigit[3] & 0x8) >> 3) << LCD_SEG15_SHIFT);
+      RefFrameWrite(LCD_DIGIT5_COM3_1, LCD_DIGIT5_COM3_1_SEG_MASK, data) ; /* 5H 5J 5N */
+      break;
+    
+    /* Position 6 on LCD (Digit6)*/
+    case LCD_DIGIT_POSITION_6:
+      data = ((RefDigit[0] & 0x1) << LCD_SEG10_SHIFT) | (((RefDigit[0] & 0x2) >> 1) << LCD_SEG11_SHIFT)
+          | (((RefDigit[0] & 0x4) >> 2) << LCD_SEG12_SHIFT) | (((RefDigit[0] & 0x8) >> 3) << LCD_SEG13_SHIFT);
+      RefFrameWrite(LCD_DIGIT6_COM0, LCD_DIGIT6_COM0_SEG_MASK, data); /* 6G 6B 6M 6E */
+      
+      data = ((RefDigit[1] & 0x1) << LCD_SEG10_SHIFT) | (((RefDigit[1] & 0x2) >> 1) << LCD_SEG11_SHIFT)
+          | (((RefDigit[1] & 0x4) >> 2) << LCD_SEG12_SHIFT) | (((RefDigit[1] & 0x8) >> 3) << LCD_SEG13_SHIFT);
+      RefFrameWrite(LCD_DIGIT6_COM1, LCD_DIGIT6_COM1_SEG_MASK, data) ; /* 6G 6B 6M 6E */
+      
+      data = ((RefDigit[2] & 0x1) << LCD_SEG10_SHIFT) | (((RefDigit[2] & 0x2) >> 1) << LCD_SEG11_SHIFT)
+          | (((RefDigit[2] & 0x4) >> 2) << LCD_SEG12_SHIFT) | (((RefDigit[2] & 0x8) >> 3) << LCD_SEG13_SHIFT);
+      RefFrameWrite(LCD_DIGIT6_COM2, LCD_DIGIT6_COM2_SEG_MASK, data) ; /* 6Q 6K 6P */
+      
+      data = ((RefDigit[3] & 0x1) << LCD_SEG10_SHIFT) | (((RefDigit[3] & 0x2) >> 1) << LCD_SEG11_SHIFT)
+          | (((RefDigit[3] & 0x4) >> 2) << LCD_SEG12_SHIFT) | (((RefDigit[3] & 0x8) >> 3) << LCD_SEG13_SHIFT);
+      RefFrameWrite(LCD_DIGIT6_COM3, LCD_DIGIT6_COM3_SEG_MASK, data) ; /* 6Q 6K 6P */
+      break;
+    
+     default:
+      break;
+  }
+}
+
+/* Test ----------------------------------------------------------------------*/
+int main(void)
+{
+	uint32_t seed = 1;
+	unsigned long cases = 0;
+	unsigned long failures = 0;
+	uint8_t ch;
+
+	LCDHandle.Instance = &test_lcd;
+
+	for(int code = 0; code < 256; code++)
+	{
+		for(int position = LCD_DIGIT_POSITION_1; position <= LCD_DIGIT_POSITION_6; position++)
+		{
+			for(int point = POINT_OFF; point <= POINT_ON; point++)
+			{
+				for(int colon = DOUBLEPOINT_OFF; colon <= DOUBLEPOINT_ON; colon++)
+				{
+					/* Random neighbours show that other segments are kept */
+					for(int i = 0; i <= LCD_RAM_REGISTER15; i++)
+					{
+						seed = seed * 1103515245 + 12345;
+						LCDFrame[i] = seed ^ (seed << 7);
+						RefFrame[i] = LCDFrame[i];
+					}
+					test_lcd.SR = 0;
+
+					ch = (uint8_t)code;
+					BSP_LCD_GLASS_DisplayChar(&ch, (Point_Typedef)point,
+						(DoublePoint_Typedef)colon, (DigitPosition_Typedef)position);
+					ch = (uint8_t)code;
+					RefDisplayChar(&ch, (Point_Typedef)point,
+						(DoublePoint_Typedef)colon, (DigitPosition_Typedef)position);
+
+					cases++;
+					for(int i = 0; i <= LCD_RAM_REGISTER15; i++)
+					{
+						if(LCDFrame[i] != RefFrame[i])
+						{
+							printf("code 0x%02X position %d point %d colon %d: RAM%d %08lX, expected %08lX\n",
+								code, position, point, colon, i, 
+								(unsigned long)LCDFrame[i], (unsigned long)RefFrame[i]);
+							failures++;
+							break;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	printf("%lu cases, %lu mismatches\n", cases, failures);
+	return failures == 0 ? 0 : 1;
+}
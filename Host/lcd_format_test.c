@@ -0,0 +1,194 @@
+/*
+********************************************************************************
+* @file    lcd_format_test.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host table test of lcd_format.c. Each case is written out the way
+*          the glass shows it, with a '.' after the character whose decimal
+*          point is lit and 'o' for the degree glyph of the percent sign.
+*          Covers saturation at both ends, rounding away decimals that do
+*          not fit, values that round to zero, pure fractions, NaN and the
+*          labels built with lcd_format_append_int. Exits with 1 on a
+*          mismatch.
+*
+*          Build: cc -std=gnu99 -iquote ../Inc -o lcd_format_test
+*                    lcd_format_test.c ../Src/lcd_format.c
+*          Use:   ./lcd_format_test
+********************************************************************************
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "lcd_format.h"
+
+/* Private types -------------------------------------------------------------*/
+enum format_kind
+{
+	FORMAT_INT,
+	FORMAT_FIXED,
+	FORMAT_PERCENT
+};
+
+struct int_case
+{
+	enum format_kind kind;
+	int32_t value;
+	uint8_t decimals;
+	const char* shown;
+};
+
+struct float_case
+{
+	float value;
+	const char* shown;
+};
+
+struct label_case
+{
+	const char* prefix;
+	int32_t value;
+	const char* suffix;
+	const char* shown;
+};
+
+/* Private variables ---------------------------------------------------------*/
+static const struct int_case int_cases[] =
+{
+	{ FORMAT_INT,     0,          0, "0" },
+	{ FORMAT_INT,     -5,         0, "-5" },
+	{ FORMAT_INT,     999999,     0, "999999" },
+	{ FORMAT_INT,     1000000,    0, "999999" },   // saturates
+	{ FORMAT_INT,     -99999,     0, "-99999" },
+	{ FORMAT_INT,     -100000,    0, "-99999" },
+	{ FORMAT_INT,     INT32_MIN,  0, "-99999" },
+	{ FORMAT_INT,     INT32_MAX,  0, "999999" },
+	{ FORMAT_FIXED,   5,          2, "0.05" },     // pure fraction is padded
+	{ FORMAT_FIXED,   -1234,      2, "-12.34" },
+	{ FORMAT_FIXED,   1234567,    3, "1234.57" },  // rounds a decimal away
+	{ FORMAT_FIXED,   -1234567,   3, "-1234.6" },  // the sign takes one more
+	{ FORMAT_FIXED,   9999995,    3, "10000.0" },  // rounding carries
+	{ FORMAT_FIXED,   -4,         2, "-0.04" },
+	{ FORMAT_FIXED,   -4,         9, "0.0000" },   // rounds to zero, no sign
+	{ FORMAT_FIXED,   123456789,  2, "999999" },   // no decimals left, saturates
+	{ FORMAT_PERCENT, 1000,       1, "100o/%" },
+	{ FORMAT_PERCENT, 995,        1, "99.5o/%" },
+	{ FORMAT_PERCENT, 9996,       2, "100o/%" },
+	{ FORMAT_PERCENT, 0,          1, "0.0o/%" },
+	{ FORMAT_PERCENT, 5,          1, "0.5o/%" },
+	{ FORMAT_PERCENT, -5,         1, "-0.5o/%" },
+	{ FORMAT_PERCENT, 9999,       1, "999o/%" },
+	{ FORMAT_PERCENT, 10000,      1, "999o/%" },
+};
+
+static const struct float_case float_cases[] =
+{
+	{ -85.3f,     "-85.300" },
+	{ -120.456f,  "-120.46" },
+	{ 7.25f,      "7.25000" },
+	{ 0.0f,       "0.00000" },
+	{ -0.00001f,  "0.0000" },   // rounds to zero, no sign
+	{ 9.999996f,  "10.0000" },
+	{ 99999.9f,   "99999.9" },
+	{ 999999.6f,  "999999" },
+	{ -99999.6f,  "-99999" },
+	{ 1e12f,      "999999" },
+	{ -1e12f,     "-99999" },
+	{ -0.05f,     "-0.0500" },
+};
+
+static const struct label_case label_cases[] =
+{
+	{ "P",     5,     "",  "P5" },
+	{ "P",     95,    "",  "P95" },
+	{ "",      1,     "",  "1" },
+	{ "9-",    16,    "",  "9-16" },
+	{ "",      33,    "+", "33+" },
+	{ "ABCD",  12345, "",  "ABCD99" },  // saturates to the room left
+	{ "ABCDE", -7,    "",  "ABCDE-" },  // only room for the sign
+	{ "ABCDEF", 1,    "",  "ABCDEF" },  // no room at all
+};
+
+static uint32_t failures;
+
+/* Private function prototypes -----------------------------------------------*/
+static void shown(const struct lcd_text* text, char* out);
+static void compare(const struct lcd_text* text, const char* expected, const char* what, int index);
+
+/* Function definitions ------------------------------------------------------*/
+int main(void)
+{
+	struct lcd_text text;
+	uint8_t pos;
+
+	for(int i = 0; i < (int)(sizeof(int_cases) / sizeof(int_cases[0])); i++)
+	{
+		switch(int_cases[i].kind)
+		{
+			case FORMAT_INT:
+				lcd_format_int(int_cases[i].value, &text);
+				break;
+
+			case FORMAT_FIXED:
+				lcd_format_fixed(int_cases[i].value, int_cases[i].decimals, &text);
+				break;
+
+			case FORMAT_PERCENT:
+			default:
+				lcd_format_percent(int_cases[i].value, int_cases[i].decimals, &text);
+				break;
+		}
+		compare(&text, int_cases[i].shown, "int", i);
+	}
+
+	for(int i = 0; i < (int)(sizeof(float_cases) / sizeof(float_cases[0])); i++)
+	{
+		lcd_format_float(float_cases[i].value, &text);
+		compare(&text, float_cases[i].shown, "float", i);
+	}
+	lcd_format_float(NAN, &text);
+	compare(&text, "NAN", "float NaN", 0);
+	lcd_format_ratio(0.9951f, &text);
+	compare(&text, "99.5o/%", "ratio", 0);
+
+	for(int i = 0; i < (int)(sizeof(label_cases) / sizeof(label_cases[0])); i++)
+	{
+		strcpy((char*)text.chars, label_cases[i].prefix);
+		pos = lcd_format_append_int(label_cases[i].value, (uint8_t)strlen(label_cases[i].prefix), &text);
+		strcpy((char*)text.chars + pos, label_cases[i].suffix);
+		compare(&text, label_cases[i].shown, "label", i);
+	}
+
+	printf("%u failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief : the text as the glass shows it
+ */
+static void shown(const struct lcd_text* text, char* out)
+{
+	for(int i = 0; i <= LCD_FORMAT_WIDTH && text->chars[i] != 0; i++)
+	{
+		*out++ = text->chars[i] == 0xB0 ? 'o' : (char)text->chars[i];
+		if(i == text->point)
+		{
+			*out++ = '.';
+		}
+	}
+	*out = 0;
+}
+
+static void compare(const struct lcd_text* text, const char* expected, const char* what, int index)
+{
+	char out[2 * LCD_FORMAT_WIDTH + 2];
+
+	shown(text, out);
+	if(strcmp(out, expected) != 0)
+	{
+		printf("FAIL %s case %d: \"%s\", expected \"%s\"\n", what, index, out, expected);
+		failures++;
+	}
+}
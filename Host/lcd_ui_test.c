@@ -0,0 +1,239 @@
+/*
+********************************************************************************
+* @file    lcd_ui_test.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host test of the screen queue in lcd_ui.c on a simulated tick.
+*          The timer wheel is serviced once per ms and every screen put on
+*          the glass is logged with its tick. Checks that timed screens
+*          follow each other on time, that a scroll steps one character per
+*          step and then gives way, that held live values replace each
+*          other instead of piling up, and the full queue, clear and idle
+*          cases. Exits with 1 on a failed check.
+*
+*          Build: cc -std=gnu99 -DSTM32L152xC -DUSE_HAL_DRIVER
+*                    -iquote ../Inc -I../Drivers/STM32L1xx_HAL_Driver/Inc
+*                    -I../Drivers/CMSIS/Include
+*                    -I../Drivers/CMSIS/Device/ST/STM32L1xx/Include
+*                    -o lcd_ui_test lcd_ui_test.c ../Src/lcd_ui.c
+*                    ../Src/lcd_format.c ../Src/timer_wheel.c
+*          Use:   ./lcd_ui_test
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "lcd_ui.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define LOG_SIZE               64
+
+/* Private types -------------------------------------------------------------*/
+struct frame
+{
+	uint32_t tick;
+	char chars[LCD_FORMAT_WIDTH + 1];
+};
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t now;
+static struct frame frames[LOG_SIZE];
+static uint32_t frame_count;
+static uint32_t failures;
+
+/* Private function prototypes -----------------------------------------------*/
+static void check(int ok, const char* what);
+static void start(void);
+static void run_until(uint32_t tick);
+static int shown(uint32_t index, uint32_t tick, const char* chars);
+static void test_timed_screens(void);
+static void test_scroll(void);
+static void test_held_values(void);
+static void test_full_queue(void);
+static void test_clear(void);
+
+/* Function definitions ------------------------------------------------------*/
+int main(void)
+{
+	test_timed_screens();
+	test_scroll();
+	test_held_values();
+	test_full_queue();
+	test_clear();
+
+	printf("%u failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
+
+uint32_t HAL_GetTick(void)
+{
+	return now;
+}
+
+/*
+ * brief : the glass, logs what is shown and when
+ */
+void lcd_display_text(const struct lcd_text* text)
+{
+	if(frame_count < LOG_SIZE)
+	{
+		frames[frame_count].tick = now;
+		strcpy(frames[frame_count].chars, (const char*)text->chars);
+	}
+	frame_count++;
+}
+
+/* Private function definitions ----------------------------------------------*/
+static void check(int ok, const char* what)
+{
+	if(!ok)
+	{
+		printf("FAIL %s\n", what);
+		for(uint32_t i = 0; i < frame_count && i < LOG_SIZE; i++)
+		{
+			printf("  %6u [%s]\n", frames[i].tick, frames[i].chars);
+		}
+		failures++;
+	}
+}
+
+static void start(void)
+{
+	now = 1000;
+	frame_count = 0;
+	timer_wheel_init();
+	lcd_ui_init();
+}
+
+/*
+ * brief : the main loop, services the timers every ms up to and with tick
+ */
+static void run_until(uint32_t tick)
+{
+	while((int32_t)(tick - now) >= 0)
+	{
+		timer_wheel_process();
+		now++;
+	}
+	now--;
+}
+
+static int shown(uint32_t index, uint32_t tick, const char* chars)
+{
+	return index < frame_count && frames[index].tick == tick && strcmp(frames[index].chars, chars) == 0;
+}
+
+/*
+ * brief : a label for 800 ms, then a held value until the next screen
+ */
+static void test_timed_screens(void)
+{
+	start();
+	lcd_ui_show_str((const uint8_t*)"RSSI", 800);
+	lcd_ui_show_int(-85, LCD_UI_HOLD);
+	check(!lcd_ui_idle(), "busy with screens queued");
+
+	run_until(5000);
+	check(frame_count == 2 && shown(0, 1000, "RSSI") && shown(1, 1800, "-85"), "timed screens on time");
+	check(lcd_ui_idle(), "idle on a held screen");
+
+	/* The wheel has done tick 5000, the new screen goes up on the next */
+	lcd_ui_show_float(-85.5f, 500);
+	run_until(5001);
+	check(frame_count == 3 && shown(2, 5001, "-85500"), "new screen replaces a held one at once");
+	run_until(6000);
+	check(frame_count == 3 && lcd_ui_idle(), "idle after the last timed screen");
+}
+
+/*
+ * brief : one character per step, the gap between passes, then the next
+ *         screen once the passes are done
+ */
+static void test_scroll(void)
+{
+	static const char sentence[] = "CHOOSE NUM PKTS";
+	uint32_t steps = sizeof(sentence) - 1 + LCD_UI_SCROLL_GAP;
+	char window[LCD_FORMAT_WIDTH + 1];
+	uint32_t index;
+	int same = 1;
+
+	start();
+	lcd_ui_show_scroll((const uint8_t*)sentence, 200, 2);
+	lcd_ui_show_int(10, LCD_UI_HOLD);
+	run_until(1000 + 2 * steps * 200 + 1000);
+
+	check(frame_count == 2 * steps + 1, "one frame per scroll step");
+	for(uint32_t i = 0; i < 2 * steps; i++)
+	{
+		for(uint32_t c = 0; c < LCD_FORMAT_WIDTH; c++)
+		{
+			index = (i + c) % steps;
+			window[c] = index < sizeof(sentence) - 1 ? sentence[index] : ' ';
+		}
+		window[LCD_FORMAT_WIDTH] = 0;
+		same &= shown(i, 1000 + i * 200, window);
+	}
+	check(same, "scroll frames and timing");
+	check(shown(2 * steps, 1000 + 2 * steps * 200, "10"), "next screen after the scroll");
+
+	check(lcd_ui_show_scroll((const uint8_t*)"", 200, 1) && lcd_ui_idle(), "empty scroll is skipped");
+}
+
+/*
+ * brief : live values queued behind a label collapse into the newest
+ */
+static void test_held_values(void)
+{
+	start();
+	lcd_ui_show_str((const uint8_t*)"LIVE", 800);
+	for(int32_t value = 1; value <= 50; value++)
+	{
+		check(lcd_ui_show_int(value, LCD_UI_HOLD), "held value queued");
+	}
+	run_until(2000);
+	check(frame_count == 2 && shown(0, 1000, "LIVE") && shown(1, 1800, "50"), "only the newest held value shown");
+
+	lcd_ui_show_int(51, LCD_UI_HOLD);
+	lcd_ui_show_int(52, LCD_UI_HOLD);
+	run_until(2001);
+	check(frame_count == 3 && shown(2, 2001, "52"), "held value replaces a shown one");
+}
+
+/*
+ * brief : the queue takes LCD_UI_QUEUE_SIZE - 1 screens
+ */
+static void test_full_queue(void)
+{
+	start();
+	for(int i = 0; i < LCD_UI_QUEUE_SIZE - 1; i++)
+	{
+		check(lcd_ui_show_int(i, 100), "screen queued");
+	}
+	check(!lcd_ui_show_int(99, 100), "full queue refuses a screen");
+
+	run_until(1000 + LCD_UI_QUEUE_SIZE * 100);
+	check(frame_count == LCD_UI_QUEUE_SIZE - 1 && shown(LCD_UI_QUEUE_SIZE - 2, 1000 + (LCD_UI_QUEUE_SIZE - 2) * 100, "6"),
+		"queued screens all shown");
+}
+
+/*
+ * brief : clearing drops the queue and stops the current screen's timer
+ */
+static void test_clear(void)
+{
+	start();
+	lcd_ui_show_scroll((const uint8_t*)"SCROLLING ON", 100, 3);
+	lcd_ui_show_str((const uint8_t*)"NEXT", 500);
+	run_until(1250);
+	check(frame_count == 3, "scrolled before the clear");
+
+	lcd_ui_clear();
+	check(lcd_ui_idle(), "idle after a clear");
+	run_until(10000);
+	check(frame_count == 3, "nothing shown after a clear");
+
+	lcd_ui_show_str((const uint8_t*)"AFTER", LCD_UI_HOLD);
+	run_until(10001);
+	check(frame_count == 4 && shown(3, 10001, "AFTER"), "shown again after a clear");
+}
@@ -0,0 +1,191 @@
+/*
+********************************************************************************
+* @file    lora_burst_test.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host test of the burst register and FIFO access in lora.c against
+*          the register and FIFO model in fake_rfm96.c. Every burst must
+*          assert NSS once and clock the address byte plus one byte per data
+*          byte, for sizes from 1 to a full frame, with the DIO0 interrupt
+*          masked. Prints the bus cost of a full frame next to writing it 
+*          one register access per byte. Exits with 1 on a failed check.
+*
+*          Build: cc -std=gnu99 -DSTM32L152xC -DUSE_HAL_DRIVER
+*                    "-DPKT_QUEUE_BARRIER()=__sync_synchronize()"
+*                    -iquote ../Inc -I../Drivers/STM32L1xx_HAL_Driver/Inc
+*                    -I../Drivers/CMSIS/Include
+*                    -I../Drivers/CMSIS/Device/ST/STM32L1xx/Include
+*                    -o lora_burst_test lora_burst_test.c fake_rfm96.c
+*                    ../Src/airtime.c ../Src/pkt_queue.c
+*          Use:   ./lora_burst_test
+*
+*          The driver source is included for its static receive functions
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include "fake_rfm96.h"
+#include "../Src/lora.c"
+
+/* Private variables ---------------------------------------------------------*/
+static const size_t sizes[] = { 1, 2, 3, 7, 8, 9, 64, 128, 255 };
+static uint32_t failures;
+
+/* Private function prototypes -----------------------------------------------*/
+static void check(int ok, const char* what, size_t size);
+static void test_burst_write(size_t size);
+static void test_burst_read(size_t size);
+static void test_register_burst(void);
+static void test_write_packet(void);
+
+/* Function definitions ------------------------------------------------------*/
+int main(void)
+{
+	uint32_t assertions;
+	uint32_t bytes;
+	uint8_t frame[MAX_PKT_LENGTH];
+
+	for(size_t i = 0; i < COUNTOF(sizes); i++)
+	{
+		test_burst_write(sizes[i]);
+		test_burst_read(sizes[i]);
+	}
+	test_register_burst();
+	test_write_packet();
+
+	/* A full frame one byte at a time, as the driver used to write it */
+	fake_rfm96_reset();
+	memset(frame, 0x5A, sizeof(frame));
+	for(size_t i = 0; i < sizeof(frame); i++)
+	{
+		rfm96_write_reg(REG_FIFO, frame[i]);
+	}
+	assertions = fake_rfm96.nss_assertions;
+	bytes = fake_rfm96.bus_bytes;
+
+	fake_rfm96_reset();
+	rfm96_write_fifo(frame, sizeof(frame));
+	printf("%u byte frame: %u NSS assertions and %u bus bytes per register, "
+		"%u and %u as a burst\n", (unsigned)sizeof(frame), assertions, bytes,
+		fake_rfm96.nss_assertions, fake_rfm96.bus_bytes);
+
+	printf("%u failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
+
+/* Private function definitions ----------------------------------------------*/
+static void check(int ok, const char* what, size_t size)
+{
+	if(!ok)
+	{
+		printf("FAIL %s, %u bytes\n", what, (unsigned)size);
+		failures++;
+	}
+}
+
+/*
+ * brief : writes the FIFO from the middle, so the pointer wraps for large
+ *         sizes the same way it does in the chip
+ */
+static void test_burst_write(size_t size)
+{
+	uint8_t data[FAKE_RFM96_FIFO_SIZE];
+	uint8_t start = 0xC0;
+	int same = 1;
+
+	fake_rfm96_reset();
+	fake_rfm96.regs[REG_FIFO_ADDR_PTR] = start;
+	for(size_t i = 0; i < size; i++)
+	{
+		data[i] = (uint8_t)(i * 7 + 1);
+	}
+
+	rfm96_burst_write(REG_FIFO, data, size);
+
+	for(size_t i = 0; i < size; i++)
+	{
+		same &= fake_rfm96.fifo[(uint8_t)(start + i)] == data[i];
+	}
+	check(fake_rfm96.nss_assertions == 1, "burst write asserts NSS once", size);
+	check(fake_rfm96.bus_bytes == size + 1, "burst write clocks address and data", size);
+	check(fake_rfm96.stray_bytes == 0 && !fake_rfm96.selected, "burst write releases NSS", size);
+	check(fake_rfm96.unguarded_bursts == 0 && !fake_rfm96.dio0_masked, "burst write masks DIO0", size);
+	check(same, "burst write fills the FIFO", size);
+	check(fake_rfm96.regs[REG_FIFO_ADDR_PTR] == (uint8_t)(start + size), "burst write moves the pointer", size);
+}
+
+static void test_burst_read(size_t size)
+{
+	uint8_t data[FAKE_RFM96_FIFO_SIZE];
+	uint8_t start = 0xC0;
+	int same = 1;
+
+	fake_rfm96_reset();
+	for(int i = 0; i < FAKE_RFM96_FIFO_SIZE; i++)
+	{
+		fake_rfm96.fifo[i] = (uint8_t)(i ^ 0xA5);
+	}
+	fake_rfm96.regs[REG_FIFO_ADDR_PTR] = start;
+
+	rfm96_burst_read(REG_FIFO, data, size);
+
+	for(size_t i = 0; i < size; i++)
+	{
+		same &= data[i] == fake_rfm96.fifo[(uint8_t)(start + i)];
+	}
+	check(fake_rfm96.nss_assertions == 1, "burst read asserts NSS once", size);
+	check(fake_rfm96.bus_bytes == size + 1, "burst read clocks address and data", size);
+	check(fake_rfm96.stray_bytes == 0 && !fake_rfm96.selected, "burst read releases NSS", size);
+	check(fake_rfm96.unguarded_bursts == 0 && !fake_rfm96.dio0_masked, "burst read masks DIO0", size);
+	check(same, "burst read returns the FIFO", size);
+	check(fake_rfm96.regs[REG_FIFO_ADDR_PTR] == (uint8_t)(start + size), "burst read moves the pointer", size);
+}
+
+/*
+ * brief : outside the FIFO a burst walks consecutive registers, as the
+ *         frequency error read does
+ */
+static void test_register_burst(void)
+{
+	uint8_t data[3];
+
+	fake_rfm96_reset();
+	fake_rfm96.regs[REG_FREQ_ERROR_MSB] = 0x0F;
+	fake_rfm96.regs[REG_FREQ_ERROR_MID] = 0x12;
+	fake_rfm96.regs[REG_FREQ_ERROR_LSB] = 0x34;
+
+	rfm96_burst_read(REG_FREQ_ERROR_MSB, data, sizeof(data));
+
+	check(fake_rfm96.nss_assertions == 1 && fake_rfm96.bus_bytes == 4, "register burst read", sizeof(data));
+	check(data[0] == 0x0F && data[1] == 0x12 && data[2] == 0x34, "register burst reads consecutive registers", sizeof(data));
+}
+
+/*
+ * brief : a full packet costs one FIFO burst and the payload length write,
+ *         the length read is served by the shadow cache
+ */
+static void test_write_packet(void)
+{
+	uint8_t payload[MAX_PKT_LENGTH];
+	uint32_t assertions;
+	uint32_t bytes;
+
+	fake_rfm96_reset();
+	rfm96_cache_invalidate();
+	for(size_t i = 0; i < sizeof(payload); i++)
+	{
+		payload[i] = (uint8_t)(0xFF - i);
+	}
+
+	rfm96_begin_packet();
+	assertions = fake_rfm96.nss_assertions;
+	bytes = fake_rfm96.bus_bytes;
+	check(rfm96_write_packet(payload, sizeof(payload)) == sizeof(payload), "write packet takes the payload", sizeof(payload));
+
+	check(fake_rfm96.nss_assertions - assertions == 2, "write packet asserts NSS twice", sizeof(payload));
+	check(fake_rfm96.bus_bytes - bytes == sizeof(payload) + 3, "write packet bus bytes", sizeof(payload));
+	check(memcmp(fake_rfm96.fifo, payload, sizeof(payload)) == 0, "write packet fills the FIFO", sizeof(payload));
+	check(fake_rfm96.regs[REG_PAYLOAD_LENGTH] == sizeof(payload), "write packet sets the length", sizeof(payload));
+	check(fake_rfm96.unguarded_bursts == 0, "write packet masks DIO0", sizeof(payload));
+}
@@ -0,0 +1,337 @@
+/*
+********************************************************************************
+* @file    lora_rx_test.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host test of the continuous receive path in lora.c against the
+*          radio model in fake_rfm96.c. Every packet carries its number,
+*          a length and signal quality of its own, so a packet that reaches
+*          the queue with another one's data or metadata is caught. Runs
+*          through several wraps of the 256 byte FIFO with packets arriving
+*          one per interrupt and landing while the interrupt drains the
+*          last one. Two packets landing before the flags are cleared merge
+*          into one flag, the older one must be counted as an overrun and
+*          not read out, also when it has a CRC error. Also checks that an
+*          edge during main context SPI use is drained once it ends. Exits
+*          with 1 on a failed check.
+*
+*          Build: cc -std=gnu99 -DSTM32L152xC -DUSE_HAL_DRIVER
+*                    "-DPKT_QUEUE_BARRIER()=__sync_synchronize()"
+*                    -iquote ../Inc -I../Drivers/STM32L1xx_HAL_Driver/Inc
+*                    -I../Drivers/CMSIS/Include
+*                    -I../Drivers/CMSIS/Device/ST/STM32L1xx/Include
+*                    -o lora_rx_test lora_rx_test.c fake_rfm96.c
+*                    ../Src/airtime.c ../Src/pkt_queue.c
+*          Use:   ./lora_rx_test
+*
+*          The driver source is included for its static receive functions
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include "fake_rfm96.h"
+#include "../Src/lora.c"
+
+/* Private defines -----------------------------------------------------------*/
+#define ROUNDS                 100
+
+/* Private variables ---------------------------------------------------------*/
+static uint16_t sent;                  // number of the next packet
+static uint32_t received;
+static int32_t last_received;          // number of the newest packet taken
+static uint32_t failures;
+
+/* Private function prototypes -----------------------------------------------*/
+static void check(int ok, const char* what);
+static uint8_t packet_length(uint16_t number);
+static uint8_t packet_byte(uint16_t number, uint8_t i);
+static uint8_t rssi_reg(uint16_t number);
+static uint8_t snr_reg(uint16_t number);
+static void start_receiver(void);
+static void send(void);
+static void send_on_clear(void);
+static void receive_all(void);
+static void test_one_per_interrupt(void);
+static void test_landing_during_drain(void);
+static void test_merged_flag(void);
+static void test_crc_error(void);
+static void test_crc_error_in_gap(void);
+static void test_arrival_while_locked(void);
+
+/* Function definitions ------------------------------------------------------*/
+int main(void)
+{
+	test_one_per_interrupt();
+	test_landing_during_drain();
+	test_merged_flag();
+	test_crc_error();
+	test_crc_error_in_gap();
+	test_arrival_while_locked();
+
+	printf("%u failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
+
+/* Private function definitions ----------------------------------------------*/
+static void check(int ok, const char* what)
+{
+	if(!ok)
+	{
+		printf("FAIL %s\n", what);
+		failures++;
+	}
+}
+
+/*
+ * brief : lengths from 2 to 61 bytes, so packets sit at uneven FIFO 
+ *         addresses and no gap is a multiple of the next packet
+ */
+static uint8_t packet_length(uint16_t number)
+{
+	return (uint8_t)(2 + number * 7 % 60);
+}
+
+/*
+ * brief : the number in the first two bytes, then a pattern from it
+ */
+static uint8_t packet_byte(uint16_t number, uint8_t i)
+{
+	if(i < 2)
+	{
+		return (uint8_t)(number >> (8 * i));
+	}
+	return (uint8_t)(number * 13 + i);
+}
+
+/*
+ * brief : REG_PKT_RSSI_VALUE, -137 to -38 dBm
+ */
+static uint8_t rssi_reg(uint16_t number)
+{
+	return (uint8_t)(20 + number % 100);
+}
+
+/*
+ * brief : REG_PKT_SNR_VALUE in quarter dB, -20 to 20 dB
+ */
+static uint8_t snr_reg(uint16_t number)
+{
+	return (uint8_t)(4 * ((int)(number % 41) - 20));
+}
+
+static void start_receiver(void)
+{
+	fake_rfm96_reset();
+	rfm96_init();
+	rfm96_rx_check(0);
+	received = 0;
+	last_received = -1;
+}
+
+/*
+ * brief : the next packet arrives over the air
+ */
+static void send(void)
+{
+	uint8_t payload[PKT_QUEUE_PAYLOAD_SIZE];
+	uint8_t length = packet_length(sent);
+
+	for(uint8_t i = 0; i < length; i++)
+	{
+		payload[i] = packet_byte(sent, i);
+	}
+	fake_rfm96_receive(payload, length, rssi_reg(sent), snr_reg(sent));
+	sent++;
+}
+
+/*
+ * brief : the next packet arrives just after the interrupt clears the flags
+ */
+static void send_on_clear(void)
+{
+	uint8_t payload[PKT_QUEUE_PAYLOAD_SIZE];
+	uint8_t length = packet_length(sent);
+
+	for(uint8_t i = 0; i < length; i++)
+	{
+		payload[i] = packet_byte(sent, i);
+	}
+	fake_rfm96_receive_on_clear(payload, length, rssi_reg(sent), snr_reg(sent));
+	sent++;
+}
+
+/*
+ * brief : the main loop, takes the queued packets and checks that each is 
+ *         a packet that was sent, newer than the last, and carries its own
+ *         length, payload and signal quality
+ */
+static void receive_all(void)
+{
+	const struct pkt_desc* packet;
+	uint16_t number;
+	int same;
+
+	while((packet = pkt_queue_peek(rfm96_rx_queue())) != 0)
+	{
+		number = packet->length >= 2 ? packet->payload[0] | (packet->payload[1] << 8) : 0;
+		same = packet->length >= 2 && packet->length == packet_length(number)
+			&& (int32_t)number > last_received;
+		for(uint8_t i = 0; same && i < packet->length; i++)
+		{
+			same &= packet->payload[i] == packet_byte(number, i);
+		}
+		if(!same || packet->rssi != RFM96_RSSI_OFFSET + rssi_reg(number)
+			|| packet->snr != (int8_t)snr_reg(number) / 4)
+		{
+			printf("packet %u: length %u rssi %d snr %d\n", number, packet->length,
+				packet->rssi, packet->snr);
+			check(0, "packet contents");
+		}
+		last_received = number;
+		received++;
+		pkt_queue_release(rfm96_rx_queue());
+	}
+}
+
+/*
+ * brief : one packet per interrupt, the write address wraps the FIFO many 
+ *         times over
+ */
+static void test_one_per_interrupt(void)
+{
+	struct rfm96_rx_stats stats;
+	start_receiver();
+	for(int round = 0; round < ROUNDS; round++)
+	{
+		send();
+		fake_rfm96_dio0_irq();
+		receive_all();
+	}
+
+	rfm96_rx_get_stats(&stats);
+	check(received == ROUNDS && last_received == sent - 1 && stats.packets == ROUNDS, "every packet received");
+	check(stats.fifo_overruns == 0 && stats.queue_drops == 0 && stats.crc_errors == 0, "no drops");
+	check(fake_rfm96.regs[REG_IRQ_FLAGS] == 0, "flags cleared");
+	check(fake_rfm96.unguarded_bursts == 0, "main context SPI masks DIO0");
+}
+
+/*
+ * brief : a packet landing after the flags are cleared sets RX done again 
+ *         while the interrupt is still running, it is read in the same 
+ *         interrupt with its own metadata
+ */
+static void test_landing_during_drain(void)
+{
+	struct rfm96_rx_stats stats;
+
+	start_receiver();
+	for(int round = 0; round < ROUNDS; round++)
+	{
+		send();
+		send_on_clear();
+		fake_rfm96_dio0_irq();
+		receive_all();
+	}
+
+	rfm96_rx_get_stats(&stats);
+	printf("landing during drain: %u received, %u overruns\n", received, stats.fifo_overruns);
+	check(received == 2 * ROUNDS && last_received == sent - 1, "packets landing during the drain received");
+	check(stats.fifo_overruns == 0 && stats.queue_drops == 0, "no drops during the drain");
+	check(fake_rfm96.regs[REG_IRQ_FLAGS] == 0 && !fake_rfm96.staged, "flags cleared after the drain");
+}
+
+/*
+ * brief : two packets landing before the flags are cleared share one flag 
+ *         and the radio only describes the newer. The older is counted as 
+ *         an overrun and the newer read with its own metadata
+ */
+static void test_merged_flag(void)
+{
+	struct rfm96_rx_stats stats;
+
+	start_receiver();
+	for(int round = 0; round < ROUNDS; round++)
+	{
+		send();
+		send();
+		fake_rfm96_dio0_irq();
+		receive_all();
+		check(last_received == sent - 1, "newest of a merged pair received");
+	}
+
+	rfm96_rx_get_stats(&stats);
+	printf("merged flag: %u sent, %u received, %u overruns\n", 2 * ROUNDS, received,
+		stats.fifo_overruns);
+	check(received == ROUNDS && stats.fifo_overruns == ROUNDS, "older of a merged pair counted");
+}
+
+/*
+ * brief : a packet with a bad CRC is counted and skipped, the next one is
+ *         still read from the right address
+ */
+static void test_crc_error(void)
+{
+	struct rfm96_rx_stats stats;
+
+	start_receiver();
+	send();
+	fake_rfm96.regs[REG_IRQ_FLAGS] |= IRQ_PAYLOAD_CRC_ERROR_MASK;
+	fake_rfm96_dio0_irq();
+
+	send();
+	fake_rfm96_dio0_irq();
+	receive_all();
+
+	rfm96_rx_get_stats(&stats);
+	check(stats.crc_errors == 1 && stats.packets == 1 && received == 1 && last_received == sent - 1,
+		"CRC error skipped");
+	check(stats.fifo_overruns == 0, "CRC error is no overrun");
+}
+
+/*
+ * brief : a packet with a bad CRC followed by a good one before the flags 
+ *         are cleared. The error flag stays set for the pair, so neither 
+ *         may be read out, and the receiver goes on with the next packet
+ */
+static void test_crc_error_in_gap(void)
+{
+	struct rfm96_rx_stats stats;
+	uint16_t corrupt;
+
+	start_receiver();
+	send();
+	fake_rfm96_dio0_irq();
+
+	corrupt = sent;
+	send();
+	fake_rfm96.regs[REG_IRQ_FLAGS] |= IRQ_PAYLOAD_CRC_ERROR_MASK;
+	send();
+	fake_rfm96_dio0_irq();
+	receive_all();
+	check(received == 1 && last_received == corrupt - 1, "nothing read from a gap with a CRC error");
+
+	send();
+	fake_rfm96_dio0_irq();
+	receive_all();
+
+	rfm96_rx_get_stats(&stats);
+	check(received == 2 && last_received == sent - 1, "next packet after a CRC error gap");
+	check(stats.fifo_overruns == 1 && stats.crc_errors == 1 && stats.packets == 2, "CRC error gap counted");
+}
+
+/*
+ * brief : an edge while the main loop holds the bus is taken when it lets go
+ */
+static void test_arrival_while_locked(void)
+{
+	start_receiver();
+	rfm96_dio0_lock();
+	send();
+	fake_rfm96_dio0_irq();
+	check(pkt_queue_count(rfm96_rx_queue()) == 0, "no drain while locked");
+	rfm96_dio0_unlock();
+	receive_all();
+
+	check(received == 1 && !fake_rfm96.dio0_masked, "drained after unlock");
+}
@@ -0,0 +1,148 @@
+/*
+********************************************************************************
+* @file    pkt_queue_stress.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host stress test of pkt_queue.c with a producer thread and a
+*          consumer thread, standing in for the radio interrupt and the main
+*          loop. Every packet is filled from its sequence number, so the
+*          consumer can check that packets come out in order and that no
+*          field or payload byte is seen before it was committed or after it
+*          was reused. Exits with 1 on a mismatch.
+*
+*          Build: cc -O2 -DSTM32L152xC
+*                    "-DPKT_QUEUE_BARRIER()=__sync_synchronize()"
+*                    -iquote ../Inc -I../Drivers/CMSIS/Include
+*                    -I../Drivers/CMSIS/Device/ST/STM32L1xx/Include
+*                    -o pkt_queue_stress pkt_queue_stress.c
+*                    ../Src/pkt_queue.c -lpthread
+*          Use:   ./pkt_queue_stress [packets]
+********************************************************************************
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "pkt_queue.h"
+
+/* Private variables ---------------------------------------------------------*/
+static struct pkt_queue queue;
+static uint32_t packets;
+static uint32_t full_spins;
+static uint32_t empty_spins;
+
+/* Private function prototypes -----------------------------------------------*/
+static void* producer(void* arg);
+static void* consumer(void* arg);
+static uint8_t packet_length(uint32_t seq);
+static uint8_t packet_byte(uint32_t seq, uint32_t i);
+
+/* Function definitions ------------------------------------------------------*/
+int main(int argc, char** argv)
+{
+	pthread_t producer_thread;
+	pthread_t consumer_thread;
+	struct timespec start;
+	struct timespec end;
+	void* mismatches;
+	double seconds;
+
+	packets = argc > 1 ? strtoul(argv[1], NULL, 0) : 2000000;
+	pkt_queue_init(&queue);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pthread_create(&consumer_thread, NULL, consumer, NULL);
+	pthread_create(&producer_thread, NULL, producer, NULL);
+	pthread_join(producer_thread, NULL);
+	pthread_join(consumer_thread, &mismatches);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("%u packets in %.2f s, %u full and %u empty spins, %u mismatches\n",
+		packets, seconds, full_spins, empty_spins, (uint32_t)(uintptr_t)mismatches);
+	return mismatches == 0 && pkt_queue_count(&queue) == 0 ? 0 : 1;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief : the radio interrupt, yields while the queue is full so a single
+ *         core host keeps going
+ */
+static void* producer(void* arg)
+{
+	struct pkt_desc* packet;
+
+	for(uint32_t seq = 0; seq < packets; seq++)
+	{
+		while((packet = pkt_queue_reserve(&queue)) == 0)
+		{
+			full_spins++;
+			sched_yield();
+		}
+
+		packet->tick = seq;
+		packet->freq_error = -(int32_t)seq;
+		packet->rssi = (int16_t)(-(int32_t)(seq % 140));
+		packet->snr = (int8_t)(seq % 32 - 20);
+		packet->length = packet_length(seq);
+		for(uint32_t i = 0; i < PKT_QUEUE_PAYLOAD_SIZE; i++)
+		{
+			packet->payload[i] = packet_byte(seq, i);
+		}
+		pkt_queue_commit(&queue);
+	}
+	return NULL;
+}
+
+/*
+ * brief  : the main loop, checks every packet and counts the bad ones,
+ *          yields while the queue is empty
+ * retval : number of mismatching packets
+ */
+static void* consumer(void* arg)
+{
+	const struct pkt_desc* packet;
+	uintptr_t mismatches = 0;
+	int ok;
+
+	for(uint32_t seq = 0; seq < packets; seq++)
+	{
+		while((packet = pkt_queue_peek(&queue)) == 0)
+		{
+			empty_spins++;
+			sched_yield();
+		}
+
+		ok = packet->tick == seq && packet->freq_error == -(int32_t)seq
+			&& packet->rssi == (int16_t)(-(int32_t)(seq % 140))
+			&& packet->snr == (int8_t)(seq % 32 - 20)
+			&& packet->length == packet_length(seq);
+		for(uint32_t i = 0; i < PKT_QUEUE_PAYLOAD_SIZE; i++)
+		{
+			ok &= packet->payload[i] == packet_byte(seq, i);
+		}
+		if(!ok)
+		{
+			if(mismatches == 0)
+			{
+				printf("packet %u: tick %u length %u\n", seq, packet->tick, packet->length);
+			}
+			mismatches++;
+		}
+		pkt_queue_release(&queue);
+	}
+	return (void*)mismatches;
+}
+
+static uint8_t packet_length(uint32_t seq)
+{
+	return (uint8_t)(seq % PKT_QUEUE_PAYLOAD_SIZE + 1);
+}
+
+static uint8_t packet_byte(uint32_t seq, uint32_t i)
+{
+	return (uint8_t)(seq * 31 + i);
+}
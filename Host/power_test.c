@@ -0,0 +1,329 @@
+/*
+********************************************************************************
+* @file    power_test.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host test of power.c on a simulated RTC calendar. STOP mode lasts
+*          until the wakeup timer period or an earlier EXTI interrupt, sleep
+*          mode until the next SysTick. Checks the reading of the calendar,
+*          the choice between sleep and STOP with and without locks, the
+*          wakeup timer setting and its clamp, a power_wake before the wait,
+*          the tick credited for STOP time also across midnight, the wakeup
+*          latency and HAL_Delay on top of it. Exits with 1 on a failed
+*          check.
+*
+*          Build: cc -std=gnu99 -DSTM32L152xC -DUSE_HAL_DRIVER
+*                    -iquote ../Inc -I../Drivers/STM32L1xx_HAL_Driver/Inc
+*                    -I../Drivers/CMSIS/Include
+*                    -I../Drivers/CMSIS/Device/ST/STM32L1xx/Include
+*                    -o power_test power_test.c
+*          Use:   ./power_test
+*
+*          The driver source is included so the RTC registers and the
+*          Cortex-M intrinsics it uses can be replaced. HAL_RTC_MspInit is
+*          compiled but never run
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include "power.h"
+
+/* Interrupts only end waits here */
+#define __get_PRIMASK()        0
+#define __set_PRIMASK(primask) ((void)(primask))
+#define __disable_irq()
+#define __enable_irq()
+#define __RBIT(value)          0   // only in the RTC MSP bit-band address
+#undef RTC
+#define RTC                    (&test_rtc)
+
+static RTC_TypeDef test_rtc;
+
+#include "../Src/power.c"
+
+/* Private defines -----------------------------------------------------------*/
+#define RTC_TICKS_PER_DAY      (86400UL * POWER_RTC_SYNCH_DIV)
+#define MSI_HZ                 2000000
+#define WAKE_CYCLES            300     // MSI cycles to restart the PLL, 150 us
+#define NO_INTERRUPT           0xFFFFFFFF
+
+/* Private variables ---------------------------------------------------------*/
+__IO uint32_t uwTick;
+
+static uint32_t rtc_ticks;             // 1/POWER_RTC_SYNCH_DIV s since midnight
+static uint32_t cycles;
+static uint8_t wakeup_armed;
+static uint32_t wakeup_counter;
+static uint32_t interrupt_ms;          // ms into a wait an EXTI line fires
+static uint32_t sleep_calls;
+static uint32_t stop_calls;
+static uint32_t last_stop_ms;          // simulated length of the last STOP
+static uint32_t failures;
+
+/* Private function prototypes -----------------------------------------------*/
+static void check(int ok, const char* what);
+static void set_rtc(uint32_t hours, uint32_t minutes, uint32_t seconds, uint32_t ticks);
+static void update_rtc(void);
+static void test_calendar(void);
+static void test_wait_modes(void);
+static void test_stop_time(void);
+static void test_delay(void);
+
+/* Function definitions ------------------------------------------------------*/
+int main(void)
+{
+	test_calendar();
+	test_wait_modes();
+	test_stop_time();
+	test_delay();
+
+	printf("%u failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
+
+uint32_t HAL_GetTick(void)
+{
+	return uwTick;
+}
+
+void HAL_PWR_EnableBkUpAccess(void)
+{
+}
+
+HAL_StatusTypeDef HAL_RTC_Init(RTC_HandleTypeDef* hrtc)
+{
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTCEx_EnableBypassShadow(RTC_HandleTypeDef* hrtc)
+{
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTCEx_SetWakeUpTimer_IT(RTC_HandleTypeDef* hrtc, uint32_t WakeUpCounter, uint32_t WakeUpClock)
+{
+	check(WakeUpClock == RTC_WAKEUPCLOCK_RTCCLK_DIV16, "wakeup timer clocked at POWER_WAKEUP_CLOCK_HZ");
+	wakeup_armed = 1;
+	wakeup_counter = WakeUpCounter;
+	return HAL_OK;
+}
+
+uint32_t HAL_RTCEx_DeactivateWakeUpTimer(RTC_HandleTypeDef* hrtc)
+{
+	wakeup_armed = 0;
+	return HAL_OK;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+}
+
+void HAL_SuspendTick(void)
+{
+}
+
+void HAL_ResumeTick(void)
+{
+}
+
+uint32_t HAL_RCC_GetSysClockFreq(void)
+{
+	return MSI_HZ;
+}
+
+void SystemClock_Config(void)
+{
+	cycles += WAKE_CYCLES;
+}
+
+void cycle_counter_init(void)
+{
+}
+
+uint32_t cycle_counter_read(void)
+{
+	return cycles;
+}
+
+void Error_Handler(void)
+{
+	check(0, "Error_Handler called");
+}
+
+/*
+ * brief : SysTick ends the sleep within a ms
+ */
+void HAL_PWR_EnterSLEEPMode(uint32_t Regulator, uint8_t SLEEPEntry)
+{
+	sleep_calls++;
+	uwTick++;
+}
+
+/*
+ * brief : the calendar runs on, the HAL tick does not, until the wakeup
+ *         timer or an earlier interrupt
+ */
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry)
+{
+	uint32_t ms = interrupt_ms;
+
+	check(Regulator == PWR_LOWPOWERREGULATOR_ON, "low power regulator in STOP");
+	if(wakeup_armed && (wakeup_counter + 1) * 1000 / POWER_WAKEUP_CLOCK_HZ < ms)
+	{
+		ms = (wakeup_counter + 1) * 1000 / POWER_WAKEUP_CLOCK_HZ;
+	}
+	check(ms != NO_INTERRUPT, "STOP mode ends");
+
+	stop_calls++;
+	last_stop_ms = ms;
+	rtc_ticks = (rtc_ticks + ms * POWER_RTC_SYNCH_DIV / 1000) % RTC_TICKS_PER_DAY;
+	update_rtc();
+}
+
+/* Private function definitions ----------------------------------------------*/
+static void check(int ok, const char* what)
+{
+	if(!ok)
+	{
+		printf("FAIL %s\n", what);
+		failures++;
+	}
+}
+
+static void set_rtc(uint32_t hours, uint32_t minutes, uint32_t seconds, uint32_t ticks)
+{
+	rtc_ticks = ((hours * 60 + minutes) * 60 + seconds) * POWER_RTC_SYNCH_DIV + ticks;
+	update_rtc();
+}
+
+/*
+ * brief : BCD time of day in TR, the subsecond counter counts down in SSR
+ */
+static void update_rtc(void)
+{
+	uint32_t seconds = rtc_ticks / POWER_RTC_SYNCH_DIV;
+	uint32_t hours = seconds / 3600;
+	uint32_t minutes = seconds / 60 % 60;
+
+	seconds %= 60;
+	test_rtc.TR = (hours / 10) << RTC_TR_HT_Pos | (hours % 10) << RTC_TR_HU_Pos
+		| (minutes / 10) << RTC_TR_MNT_Pos | (minutes % 10) << RTC_TR_MNU_Pos
+		| (seconds / 10) << RTC_TR_ST_Pos | (seconds % 10) << RTC_TR_SU_Pos;
+	test_rtc.SSR = POWER_RTC_SYNCH_DIV - 1 - rtc_ticks % POWER_RTC_SYNCH_DIV;
+}
+
+static void test_calendar(void)
+{
+	set_rtc(0, 0, 0, 0);
+	check(power_rtc_ms() == 0, "midnight");
+	set_rtc(12, 34, 56, 128);
+	check(power_rtc_ms() == 45296500, "12:34:56.5");
+	set_rtc(23, 59, 59, 255);
+	check(power_rtc_ms() == 86399996, "last subsecond of the day");
+	set_rtc(19, 8, 7, 64);
+	check(power_rtc_ms() == 68887250, "19:08:07.25");
+}
+
+/*
+ * brief : STOP for waits of POWER_STOP_MIN_TIME and more while unlocked,
+ *         sleep otherwise, and the wakeup timer only around a timed STOP
+ */
+static void test_wait_modes(void)
+{
+	struct power_stats stats;
+
+	set_rtc(10, 0, 0, 0);
+	interrupt_ms = NO_INTERRUPT;
+	power_init();
+	check(stop_locks == 0, "unlocked after power_init");
+
+	power_wait(0);
+	check(sleep_calls == 0 && stop_calls == 0, "no wait for a 0 timeout");
+
+	power_wait(POWER_STOP_MIN_TIME - 1);
+	check(sleep_calls == 1 && stop_calls == 0, "sleep for a short wait");
+
+	power_wait(100);
+	check(stop_calls == 1 && wakeup_counter == 100 * POWER_WAKEUP_CLOCK_HZ / 1000 - 1, "STOP for 100 ms");
+	check(!wakeup_armed, "wakeup timer off after the wait");
+
+	power_wait(60000);
+	check(stop_calls == 2 && last_stop_ms == POWER_STOP_MAX_TIME, "wakeup timer clamped");
+
+	interrupt_ms = 250;
+	power_wait(POWER_WAIT_FOREVER);
+	check(stop_calls == 3 && last_stop_ms == 250, "STOP until the interrupt");
+
+	power_stop_lock();
+	power_wait(1000);
+	check(stop_calls == 3 && sleep_calls == 2 && !wakeup_armed, "sleep while locked");
+	power_stop_unlock();
+
+	power_wake();
+	power_wait(1000);
+	check(stop_calls == 3 && sleep_calls == 2, "no wait after power_wake");
+	power_wait(1000);
+	check(stop_calls == 4, "power_wake only ends one wait");
+
+	power_get_stats(&stats);
+	check(stats.sleeps == 2 && stats.stops == 4, "stats count the waits");
+	interrupt_ms = NO_INTERRUPT;
+}
+
+/*
+ * brief : the tick is credited with the calendar time spent in STOP, also
+ *         when the calendar passes midnight, and the wakeup latency is
+ *         measured in MSI cycles
+ */
+static void test_stop_time(void)
+{
+	struct power_stats before;
+	struct power_stats after;
+	uint32_t tick;
+
+	power_get_stats(&before);
+	set_rtc(23, 59, 59, 128);
+	tick = uwTick;
+	power_wait(2000);
+	check(uwTick - tick == 2000, "tick credited across midnight");
+	check(power_rtc_ms() == 1500, "calendar past midnight");
+
+	set_rtc(8, 0, 0, 0);
+	tick = uwTick;
+	power_wait(375);
+	check(uwTick - tick == 375, "tick credited");
+
+	power_get_stats(&after);
+	check(after.stop_ms - before.stop_ms == 2375, "STOP time in the stats");
+	check(after.wake_us == WAKE_CYCLES * 1000000ULL / MSI_HZ && after.wake_us_max == after.wake_us,
+		"wakeup latency");
+}
+
+/*
+ * brief : HAL_Delay waits the whole delay, in STOP mode when it is long
+ */
+static void test_delay(void)
+{
+	uint32_t tick = uwTick;
+	uint32_t stops = stop_calls;
+	uint32_t sleeps = sleep_calls;
+
+	HAL_Delay(500);
+	check(uwTick - tick == 500 && stop_calls == stops + 1 && sleep_calls == sleeps, "long delay in STOP");
+
+	tick = uwTick;
+	HAL_Delay(3);
+	check(uwTick - tick == 3 && sleep_calls == sleeps + 3, "short delay in sleep");
+
+	/* Interrupts end the waits early, the delay waits on */
+	tick = uwTick;
+	interrupt_ms = 125;
+	HAL_Delay(1000);
+	check(uwTick - tick == 1000 && stop_calls == stops + 9, "delay through interrupts");
+	interrupt_ms = NO_INTERRUPT;
+}
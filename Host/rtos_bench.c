@@ -0,0 +1,165 @@
+/*
+********************************************************************************
+* @file    rtos_bench.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Runs the receive path of rx_threads.c on the pthread port. The
+*          main thread plays the radio interrupt, queueing packages with a
+*          few losses and calling rx_threads_radio_irq. Prints the interrupt
+*          to thread latency of every thread, then checks the threaded
+*          statistics against the same packages added in one thread. Exits
+*          with 1 on a mismatch. Run as root to get SCHED_FIFO priorities.
+*
+*          Build: cc -O2 -DPORT_POSIX -DSTATS_USE_CMSIS_DSP=0 -DSTM32L152xC
+*                    "-DPKT_QUEUE_BARRIER()=__sync_synchronize()"
+*                    -iquote ../Inc -iquote ../Drivers/CMSIS/RTOS/Template
+*                    -I../Drivers/CMSIS/Include
+*                    -I../Drivers/CMSIS/Device/ST/STM32L1xx/Include
+*                    -o rtos_bench rtos_bench.c rtos_port_posix.c
+*                    ../Src/rx_threads.c ../Src/pkt_queue.c ../Src/stats.c
+*                    ../Src/histogram.c ../Src/seq_tracker.c -lpthread -lm
+*          Use:   ./rtos_bench [packages] [interval us]
+*
+*          Inc is on the quote path only, its sched.h would otherwise hide
+*          the system one
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "rx_threads.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define RSSI_LOWEST            -140
+#define RSSI_HIGHEST           -40
+#define SNR_LOWEST             -20
+#define SNR_HIGHEST            15
+#define LOSS_INTERVAL          10          // every 10th package is lost
+
+/* Private variables ---------------------------------------------------------*/
+static struct pkt_queue queue;
+static struct stats_acc rssi_stats;
+static struct stats_acc snr_stats;
+static uint32_t rssi_bins[HISTOGRAM_BINS(RSSI_LOWEST, RSSI_HIGHEST)];
+static uint32_t snr_bins[HISTOGRAM_BINS(SNR_LOWEST, SNR_HIGHEST)];
+static struct histogram rssi_hist;
+static struct histogram snr_hist;
+static struct seq_tracker seq_tracker;
+static volatile uint32_t shown;
+
+/* Private function prototypes -----------------------------------------------*/
+static void show(uint32_t packets);
+static int16_t package_rssi(uint32_t i);
+static int8_t package_snr(uint32_t i);
+
+/* Function definitions ------------------------------------------------------*/
+int main(int argc, char** argv)
+{
+	uint32_t packages = argc > 1 ? strtoul(argv[1], NULL, 0) : 10000;
+	uint32_t interval_us = argc > 2 ? strtoul(argv[2], NULL, 0) : 100;
+	struct timespec interval = { 0, (long)interval_us * 1000 };
+	struct rx_threads_config config =
+	{
+		&queue, 0, &rssi_stats, &snr_stats, &rssi_hist, &snr_hist,
+		&seq_tracker, 0, show
+	};
+	const struct port_thread* thread;
+	struct pkt_desc* packet;
+	struct stats_acc rssi_check;
+	struct stats_acc snr_check;
+	uint32_t queued = 0;
+	uint32_t overruns = 0;
+	int ok;
+
+	pkt_queue_init(&queue);
+	stats_reset(&rssi_stats);
+	stats_reset(&snr_stats);
+	histogram_init(&rssi_hist, rssi_bins, RSSI_LOWEST, RSSI_HIGHEST);
+	histogram_init(&snr_hist, snr_bins, SNR_LOWEST, SNR_HIGHEST);
+	seq_tracker_init(&seq_tracker);
+	stats_reset(&rssi_check);
+	stats_reset(&snr_check);
+
+	port_init();
+	rx_threads_init(&config);
+	port_start();
+
+	/* The radio interrupt */
+	for(uint32_t i = 1; i <= packages; i++)
+	{
+		nanosleep(&interval, NULL);
+		if(i % LOSS_INTERVAL == 0)
+		{
+			continue;
+		}
+
+		packet = pkt_queue_reserve(&queue);
+		if(packet == 0)
+		{
+			overruns++;
+			continue;
+		}
+		packet->payload[0] = (uint8_t)i;
+		packet->payload[1] = (uint8_t)(i >> 8);
+		packet->length = 2;
+		packet->rssi = package_rssi(i);
+		packet->snr = package_snr(i);
+		packet->freq_error = 0;
+		packet->tick = i;
+		pkt_queue_commit(&queue);
+		rx_threads_radio_irq();
+
+		stats_add(&rssi_check, packet->rssi);
+		stats_add(&snr_check, packet->snr);
+		queued++;
+	}
+
+	/* The threads drain their queues before they stop */
+	port_stop();
+	seq_tracker_flush(&seq_tracker);
+
+	printf("%u packages, %u us apart, %s priorities\n", packages, interval_us,
+		port_realtime() ? "SCHED_FIFO" : "default");
+	printf("thread,messages,drops,mean_latency_us,max_latency_us\n");
+	for(uint8_t id = 0; id < RX_THREAD_COUNT; id++)
+	{
+		thread = port_thread_get(id);
+		printf("%s,%u,%u,%.1f,%u\n", thread->name, thread->messages, thread->drops,
+			thread->messages ? (double)thread->total_latency_us / thread->messages : 0.0,
+			thread->max_latency_us);
+	}
+
+	/* Drops are reported rather than failed, a slow host may lose messages */
+	ok = overruns == 0 && port_thread_get(RX_THREAD_RADIO)->drops == 0
+		&& port_thread_get(RX_THREAD_STATS)->drops == 0
+		&& shown == queued && rssi_stats.count == queued
+		&& stats_mean(&rssi_stats) == stats_mean(&rssi_check)
+		&& stats_mean(&snr_stats) == stats_mean(&snr_check)
+		&& seq_tracker_lost(&seq_tracker) == packages / LOSS_INTERVAL
+			- (packages % LOSS_INTERVAL == 0);
+	printf("queued %u, overruns %u, shown %u, lost %u, rssi mean %.2f, snr mean %.2f: %s\n",
+		queued, overruns, shown, seq_tracker_lost(&seq_tracker),
+		stats_mean(&rssi_stats), stats_mean(&snr_stats), ok ? "OK" : "MISMATCH");
+	return ok ? 0 : 1;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief : lcd thread hook, the count it is given only grows
+ */
+static void show(uint32_t packets)
+{
+	shown = packets;
+}
+
+static int16_t package_rssi(uint32_t i)
+{
+	return (int16_t)(-120 + (int16_t)((i * 7) % 60));
+}
+
+static int8_t package_snr(uint32_t i)
+{
+	return (int8_t)(-10 + (int8_t)((i * 3) % 20));
+}
@@ -0,0 +1,215 @@
+/*
+********************************************************************************
+* @file    rtos_port_posix.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host implementation of rtos_port.h on pthreads, so the threaded
+*          firmware logic can be tested and benchmarked on Linux. Every
+*          thread is a pthread blocking on its message queue. Threads get
+*          SCHED_FIFO priorities following their osPriority when the process
+*          is allowed to, and the default policy otherwise. Any thread may
+*          play the interrupt and put messages. Build with -DPORT_POSIX
+********************************************************************************
+*/
+
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include "rtos_port.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define CLOCK_PER_US           1000        // the port clock counts ns
+
+/* Private variables ---------------------------------------------------------*/
+static struct port_thread* threads[PORT_MAX_THREADS];
+static uint8_t realtime;
+
+/* Private function prototypes -----------------------------------------------*/
+static void* port_thread_main(void* arg);
+static uint32_t port_clock(void);
+
+/* Function definitions ------------------------------------------------------*/
+void port_init(void)
+{
+	for(uint8_t id = 0; id < PORT_MAX_THREADS; id++)
+	{
+		threads[id] = 0;
+	}
+	realtime = 0;
+}
+
+/*
+ * brief  : registers a thread, it is started by port_start
+ * retval : osOK, or osErrorParameter for a bad id or queue depth
+ */
+osStatus port_thread_create(uint8_t id, struct port_thread* thread)
+{
+	if(id >= PORT_MAX_THREADS || thread->depth == 0
+		|| (thread->depth & (thread->depth - 1)) != 0)
+	{
+		return osErrorParameter;
+	}
+
+	thread->head = 0;
+	thread->tail = 0;
+	thread->messages = 0;
+	thread->drops = 0;
+	thread->max_latency_us = 0;
+	thread->total_latency_us = 0;
+	thread->running = 0;
+	pthread_mutex_init(&thread->lock, NULL);
+	pthread_cond_init(&thread->ready, NULL);
+	threads[id] = thread;
+	return osOK;
+}
+
+/*
+ * brief  : queues a message for a thread and wakes it, the stamp is taken
+ *          before the lock so waiting for it counts as latency
+ * retval : osOK, osErrorResource if the queue is full or osErrorParameter
+ *          if there is no such thread
+ */
+osStatus port_message_put(uint8_t id, uint32_t message)
+{
+	uint32_t stamp = port_clock();
+	struct port_thread* thread;
+	uint8_t head;
+
+	if(id >= PORT_MAX_THREADS || (thread = threads[id]) == 0)
+	{
+		return osErrorParameter;
+	}
+
+	pthread_mutex_lock(&thread->lock);
+	head = thread->head;
+	if((uint8_t)(head - thread->tail) >= thread->depth)
+	{
+		thread->drops++;
+		pthread_mutex_unlock(&thread->lock);
+		return osErrorResource;
+	}
+	thread->queue[head & (thread->depth - 1)].value = message;
+	thread->queue[head & (thread->depth - 1)].stamp = stamp;
+	thread->head = head + 1;
+	pthread_cond_signal(&thread->ready);
+	pthread_mutex_unlock(&thread->lock);
+	return osOK;
+}
+
+const struct port_thread* port_thread_get(uint8_t id)
+{
+	return id < PORT_MAX_THREADS ? threads[id] : 0;
+}
+
+/*
+ * brief : starts the registered threads. osPriorityNormal maps to the middle
+ *         of the SCHED_FIFO range
+ */
+void port_start(void)
+{
+	struct sched_param param;
+	pthread_attr_t attr;
+	int middle = (sched_get_priority_min(SCHED_FIFO) + sched_get_priority_max(SCHED_FIFO)) / 2;
+	int status;
+
+	realtime = 1;
+	for(uint8_t id = 0; id < PORT_MAX_THREADS; id++)
+	{
+		if(threads[id] == 0)
+		{
+			continue;
+		}
+		threads[id]->running = 1;
+
+		pthread_attr_init(&attr);
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+		param.sched_priority = middle + threads[id]->priority;
+		pthread_attr_setschedparam(&attr, &param);
+		status = pthread_create(&threads[id]->handle, &attr, port_thread_main, threads[id]);
+		pthread_attr_destroy(&attr);
+
+		/* Not privileged, every thread gets the default policy then */
+		if(status == EPERM)
+		{
+			realtime = 0;
+			pthread_create(&threads[id]->handle, NULL, port_thread_main, threads[id]);
+		}
+	}
+}
+
+/*
+ * brief : stops the threads in id order once their queues are empty, so a
+ *         pipeline drains completely when its ids follow the messages
+ */
+void port_stop(void)
+{
+	for(uint8_t id = 0; id < PORT_MAX_THREADS; id++)
+	{
+		if(threads[id] == 0)
+		{
+			continue;
+		}
+
+		pthread_mutex_lock(&threads[id]->lock);
+		threads[id]->running = 0;
+		pthread_cond_signal(&threads[id]->ready);
+		pthread_mutex_unlock(&threads[id]->lock);
+		pthread_join(threads[id]->handle, NULL);
+	}
+}
+
+/*
+ * retval : 1 if the threads run with SCHED_FIFO priorities
+ */
+uint8_t port_realtime(void)
+{
+	return realtime;
+}
+
+/* Private function definitions ----------------------------------------------*/
+static void* port_thread_main(void* arg)
+{
+	struct port_thread* thread = arg;
+	struct port_message message;
+	uint32_t latency_us;
+
+	while(1)
+	{
+		pthread_mutex_lock(&thread->lock);
+		while(thread->tail == thread->head && thread->running)
+		{
+			pthread_cond_wait(&thread->ready, &thread->lock);
+		}
+		if(thread->tail == thread->head)
+		{
+			pthread_mutex_unlock(&thread->lock);
+			return NULL;
+		}
+		message = thread->queue[thread->tail & (thread->depth - 1)];
+		thread->tail++;
+		pthread_mutex_unlock(&thread->lock);
+
+		latency_us = (port_clock() - message.stamp) / CLOCK_PER_US;
+		if(latency_us > thread->max_latency_us)
+		{
+			thread->max_latency_us = latency_us;
+		}
+		thread->total_latency_us += latency_us;
+		thread->messages++;
+
+		thread->handler(message.value);
+	}
+}
+
+/*
+ * retval : monotonic ns, differences are valid across wrap arounds
+ */
+static uint32_t port_clock(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec);
+}
@@ -0,0 +1,380 @@
+/*
+********************************************************************************
+* @file    sched_test.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host test of the dispatcher in sched.c. Three tasks log every run
+*          with the events they took. Checks that ready tasks run highest
+*          priority first with their events merged, that a published event
+*          reaches only the tasks subscribed to it, that a task signalled
+*          from another task's run is picked by priority, the latency and
+*          run times measured on a simulated cycle counter, and that the
+*          loop sleeps until the next timer and wakes for a signal from an
+*          interrupt. Exits with 1 on a failed check.
+*
+*          Build: cc -std=gnu99 -DSTM32L152xC -DUSE_HAL_DRIVER
+*                    -iquote ../Inc -I../Drivers/STM32L1xx_HAL_Driver/Inc
+*                    -I../Drivers/CMSIS/Include
+*                    -I../Drivers/CMSIS/Device/ST/STM32L1xx/Include
+*                    -o sched_test sched_test.c ../Src/timer_wheel.c
+*          Use:   ./sched_test
+*
+*          The scheduler source is included so the Cortex-M intrinsics it
+*          uses can be replaced. sched_run does not return, the fake
+*          power_wait leaves it with longjmp once a test is done
+********************************************************************************
+*/
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include "sched.h"
+
+/* Interrupts are simulated from power_wait only */
+#define __get_PRIMASK()        0
+#define __set_PRIMASK(primask) ((void)(primask))
+#define __disable_irq()
+#define __enable_irq()
+#define __RBIT(value)          test_rbit(value)
+
+static uint32_t test_rbit(uint32_t value);
+
+#include "../Src/sched.c"
+
+/* Private defines -----------------------------------------------------------*/
+#define HCLK_HZ                32000000
+#define CYCLES_PER_US          (HCLK_HZ / 1000000)
+#define LOG_SIZE               128
+#define RUNS                   5
+
+/* Private types -------------------------------------------------------------*/
+enum test_task
+{
+	TASK_HIGH,
+	TASK_MID,
+	TASK_LOW,
+	TASK_COUNT
+};
+
+/* Private variables ---------------------------------------------------------*/
+static void entry_high(uint32_t events);
+static void entry_mid(uint32_t events);
+static void entry_low(uint32_t events);
+
+static struct sched_task tasks[TASK_COUNT] =
+{
+	{ "HIGH", entry_high, 0 },
+	{ "MID",  entry_mid,  SCHED_EVENT_RADIO },
+	{ "LOW",  entry_low,  SCHED_EVENT_RADIO | SCHED_EVENT_BUTTON },
+};
+
+static uint32_t now;
+static uint32_t cycles;
+static uint32_t wakes;                     // power_wake calls
+static char log_text[LOG_SIZE];            // "<task letter><events in hex> "
+static jmp_buf done;
+static uint32_t run_ticks[RUNS];           // ms after start of each run
+static uint32_t run_count;
+static uint32_t interrupt_tick;            // 0 once taken
+
+/* Set by each test */
+static void (*on_run)(uint8_t task, uint32_t events);
+static uint8_t (*on_wait)(uint32_t timeout);
+static uint32_t failures;
+
+/* Private function prototypes -----------------------------------------------*/
+static void check(int ok, const char* what);
+static void start(void);
+static void run(void);
+static void log_run(uint8_t task, uint32_t events);
+static uint8_t stop_on_wait(uint32_t timeout);
+static void test_priority(void);
+static void test_publish(void);
+static void signal_from_task(uint8_t task, uint32_t events);
+static void test_signal_from_task(void);
+static void busy_run(uint8_t task, uint32_t events);
+static void test_timing(void);
+static void timer_signal(void* arg);
+static void record_tick(uint8_t task, uint32_t events);
+static uint8_t sleep_until_timer(uint32_t timeout);
+static void test_timers(void);
+
+/* Function definitions ------------------------------------------------------*/
+int main(void)
+{
+	/* Before sched_init nothing is signalled, but the wake still counts */
+	sched_publish(SCHED_EVENT_BUTTON);
+	check(wakes == 1, "publish before sched_init");
+
+	test_priority();
+	test_publish();
+	test_signal_from_task();
+	test_timing();
+	test_timers();
+
+	printf("%u failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
+
+uint32_t HAL_GetTick(void)
+{
+	return now;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+	return HCLK_HZ;
+}
+
+uint32_t cycle_counter_read(void)
+{
+	return cycles;
+}
+
+void power_wake(void)
+{
+	wakes++;
+}
+
+void power_wait(uint32_t timeout)
+{
+	if(!on_wait(timeout))
+	{
+		longjmp(done, 1);
+	}
+}
+
+/* Private function definitions ----------------------------------------------*/
+static uint32_t test_rbit(uint32_t value)
+{
+	uint32_t result = 0;
+
+	for(int i = 0; i < 32; i++)
+	{
+		result = (result << 1) | ((value >> i) & 1);
+	}
+	return result;
+}
+
+static void check(int ok, const char* what)
+{
+	if(!ok)
+	{
+		printf("FAIL %s, runs: %s\n", what, log_text);
+		failures++;
+	}
+}
+
+static void entry_high(uint32_t events)
+{
+	log_run(TASK_HIGH, events);
+}
+
+static void entry_mid(uint32_t events)
+{
+	log_run(TASK_MID, events);
+}
+
+static void entry_low(uint32_t events)
+{
+	log_run(TASK_LOW, events);
+}
+
+static void log_run(uint8_t task, uint32_t events)
+{
+	size_t length = strlen(log_text);
+
+	snprintf(log_text + length, LOG_SIZE - length, "%c%x ", "HML"[task], events);
+	if(on_run != 0)
+	{
+		on_run(task, events);
+	}
+}
+
+static void start(void)
+{
+	now = 1000;
+	cycles = 0;
+	wakes = 0;
+	log_text[0] = 0;
+	on_run = 0;
+	on_wait = stop_on_wait;
+	timer_wheel_init();
+	sched_init(tasks, TASK_COUNT);
+}
+
+static void run(void)
+{
+	if(setjmp(done) == 0)
+	{
+		sched_run();
+	}
+}
+
+/*
+ * brief : nothing more to do, ends the test at the first wait
+ */
+static uint8_t stop_on_wait(uint32_t timeout)
+{
+	check(timeout == POWER_WAIT_FOREVER, "wait forever without timers");
+	return 0;
+}
+
+/*
+ * brief : ready tasks run highest priority first, each once with all the
+ *         events it was signalled
+ */
+static void test_priority(void)
+{
+	start();
+	sched_signal(TASK_LOW, 0x1);
+	sched_signal(TASK_MID, 0x2);
+	sched_signal(TASK_HIGH, 0x4);
+	sched_signal(TASK_MID, 0x8);
+	sched_signal(TASK_COUNT, 0x10);
+	check(wakes == 5, "every signal wakes the loop");
+	run();
+	check(strcmp(log_text, "H4 Ma L1 ") == 0, "priority order, events merged");
+	check(tasks[TASK_MID].runs == 1 && tasks[TASK_MID].events == 0, "one run takes the events");
+}
+
+/*
+ * brief : a published event reaches the subscribed tasks only, each gets
+ *         the bits it subscribed to
+ */
+static void test_publish(void)
+{
+	start();
+	sched_publish(SCHED_EVENT_RADIO | SCHED_EVENT_BUTTON | 0x1);
+	run();
+	check(strcmp(log_text, "M80000000 Lc0000000 ") == 0, "published to the subscribers");
+
+	start();
+	sched_publish(SCHED_EVENT_BUTTON);
+	run();
+	check(strcmp(log_text, "L40000000 ") == 0, "published to one subscriber");
+}
+
+/*
+ * brief : LOW wakes HIGH and MID, HIGH wakes LOW again
+ */
+static void signal_from_task(uint8_t task, uint32_t events)
+{
+	if(task == TASK_LOW && events == 0x1)
+	{
+		sched_signal(TASK_MID, 0x1);
+		sched_signal(TASK_HIGH, 0x1);
+	}
+	else if(task == TASK_HIGH)
+	{
+		sched_signal(TASK_LOW, 0x2);
+	}
+}
+
+static void test_signal_from_task(void)
+{
+	start();
+	on_run = signal_from_task;
+	sched_signal(TASK_LOW, 0x1);
+	run();
+	check(strcmp(log_text, "L1 H1 M1 L2 ") == 0, "signals from a task by priority");
+}
+
+/*
+ * brief : HIGH runs for 150 us, LOW for 20 us
+ */
+static void busy_run(uint8_t task, uint32_t events)
+{
+	cycles += (task == TASK_HIGH ? 150 : 20) * CYCLES_PER_US;
+}
+
+/*
+ * brief : latency runs from the first signal that finds a task idle, a
+ *         second signal before it runs does not restart it
+ */
+static void test_timing(void)
+{
+	start();
+	on_run = busy_run;
+	sched_signal(TASK_LOW, 0x1);
+	cycles += 10 * CYCLES_PER_US;
+	sched_signal(TASK_LOW, 0x2);
+	sched_signal(TASK_HIGH, 0x1);
+	run();
+	check(tasks[TASK_HIGH].max_latency_us == 0 && tasks[TASK_HIGH].max_run_us == 150, "HIGH times");
+	check(tasks[TASK_LOW].max_latency_us == 160 && tasks[TASK_LOW].max_run_us == 20, "LOW times");
+
+	/* Worst cases are kept */
+	sched_signal(TASK_LOW, 0x1);
+	run();
+	check(tasks[TASK_LOW].max_latency_us == 160 && tasks[TASK_LOW].runs == 2, "worst latency kept");
+}
+
+static void timer_signal(void* arg)
+{
+	sched_signal(TASK_MID, 0x1);
+}
+
+static void record_tick(uint8_t task, uint32_t events)
+{
+	if(run_count < RUNS)
+	{
+		run_ticks[run_count] = now - 1000;
+	}
+	run_count++;
+}
+
+/*
+ * brief : sleeps the whole timeout unless the interrupt comes first, it
+ *         signals LOW. The wheel may wake the loop early for a far timer,
+ *         never late. Ends the test 450 ms in
+ */
+static uint8_t sleep_until_timer(uint32_t timeout)
+{
+	check(timeout != POWER_WAIT_FOREVER, "a deadline with a timer running");
+	if(now - 1000 >= 450 || timeout == POWER_WAIT_FOREVER)
+	{
+		return 0;
+	}
+
+	if(interrupt_tick != 0 && now + timeout >= interrupt_tick)
+	{
+		now = interrupt_tick;
+		interrupt_tick = 0;
+		sched_signal(TASK_LOW, 0x1);
+	}
+	else
+	{
+		now += timeout;
+	}
+	return 1;
+}
+
+/*
+ * brief : a 100 ms periodic timer drives MID between sleeps, an interrupt
+ *         130 ms in wakes LOW
+ */
+static void test_timers(void)
+{
+	static const uint32_t expected[] = { 100, 130, 200, 300, 400 };
+	struct timer timer;
+	int same = 1;
+
+	start();
+	on_run = record_tick;
+	on_wait = sleep_until_timer;
+	run_count = 0;
+	interrupt_tick = 1130;
+	timer_init(&timer, timer_signal, 0);
+	timer_start(&timer, 100, 100);
+	run();
+
+	for(uint32_t i = 0; i < RUNS && i < run_count; i++)
+	{
+		same &= run_ticks[i] == expected[i];
+	}
+	check(same && run_count == RUNS, "tasks run on the timer and interrupt ticks");
+	check(strcmp(log_text, "M1 L1 M1 M1 M1 ") == 0, "timer and interrupt runs");
+	timer_stop(&timer);
+}
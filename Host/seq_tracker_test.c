@@ -0,0 +1,133 @@
+/*
+********************************************************************************
+* @file    seq_tracker_test.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host table test of seq_tracker.c. Each case feeds runs of
+*          consecutive sequence numbers, flushes the tracker as the end of a
+*          receive run does and compares every counter and burst bucket.
+*          Covers the wrap at 65535, duplicates, reordering, late packets,
+*          jumps of more than the window, transmitter restarts and the edges
+*          of the burst buckets. Exits with 1 on a mismatch.
+*
+*          Build: cc -std=gnu99 -iquote ../Inc -o seq_tracker_test
+*                    seq_tracker_test.c ../Src/seq_tracker.c
+*          Use:   ./seq_tracker_test
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include "seq_tracker.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define SEGMENTS               16
+
+/* Private types -------------------------------------------------------------*/
+/* Consecutive sequence numbers, wrapping at 65535 */
+struct seq_segment
+{
+	uint16_t first;
+	uint16_t count;            // 0 ends the list
+};
+
+struct seq_case
+{
+	const char* name;
+	struct seq_segment segments[SEGMENTS];
+	uint32_t expected;
+	uint32_t received;
+	uint32_t duplicates;
+	uint32_t reordered;
+	uint32_t late;
+	uint32_t restarts;
+	uint32_t longest;
+	uint32_t bursts[SEQ_TRACKER_BURST_BUCKETS];
+};
+
+/* Private variables ---------------------------------------------------------*/
+static const struct seq_case cases[] =
+{
+	/* name             segments                               exp  rx  dup reo late rst long  bursts */
+	{ "in order",       { {1, 100} },                          100, 100, 0, 0, 0, 0,  0, {0} },
+	{ "wrap",           { {65530, 16} },                        16,  16, 0, 0, 0, 0,  0, {0} },
+	{ "loss over wrap", { {65530, 5}, {2, 5} },                 13,  10, 0, 0, 0, 0,  3, {0, 0, 1} },
+	{ "duplicates",     { {1, 10}, {5, 3}, {11, 5} },           15,  15, 3, 0, 0, 0,  0, {0} },
+	{ "reordered",      { {1, 10}, {13, 5}, {11, 2} },          17,  17, 0, 2, 0, 0,  0, {0} },
+	{ "late",           { {1, 100}, {50, 1}, {101, 10} },      110, 110, 0, 0, 1, 0,  0, {0} },
+	{ "late apart",     { {1, 100}, {40, 1}, {101, 1}, {41, 1} },
+	                                                           101, 101, 0, 0, 2, 0,  0, {0} },
+	{ "jump of 32",     { {1, 10}, {43, 10} },                  52,  20, 0, 0, 0, 0, 32, {0, 0, 0, 0, 0, 1} },
+	{ "jump of 33",     { {1, 10}, {44, 10} },                  53,  20, 0, 0, 0, 0, 33, {0, 0, 0, 0, 0, 0, 1} },
+	{ "jump of 40",     { {1, 10}, {51, 10} },                  60,  20, 0, 0, 0, 0, 40, {0, 0, 0, 0, 0, 0, 1} },
+	{ "restart",        { {1, 500}, {1, 100} },                600, 600, 0, 0, 0, 1,  0, {0} },
+	{ "short restart",  { {1, 35}, {1, 35} },                   70,  70, 0, 0, 0, 1,  0, {0} },
+	{ "restart loss",   { {1, 200}, {1, 1}, {4, 50} },         253, 251, 0, 0, 0, 1,  2, {0, 1} },
+	{ "restart wrap",   { {65000, 600}, {1, 10} },             610, 610, 0, 0, 0, 1,  0, {0} },
+	/* Runs of 1, 2, 3, 4, 5, 8, 9, 16, 17, 32, 33 and 64 */
+	{ "bucket edges",   { {1, 1}, {3, 1}, {6, 1}, {10, 1}, {15, 1}, {21, 1}, {30, 1},
+	                      {40, 1}, {57, 1}, {75, 1}, {108, 1}, {142, 1}, {207, 1} },
+	                                                           207,  13, 0, 0, 0, 0, 64, {1, 1, 2, 2, 2, 2, 2} },
+};
+
+static const uint16_t bucket_lower[SEQ_TRACKER_BURST_BUCKETS] = {1, 2, 3, 5, 9, 17, 33};
+
+/* Function definitions ------------------------------------------------------*/
+int main(void)
+{
+	struct seq_tracker tracker;
+	const struct seq_case* c;
+	const struct seq_segment* segment;
+	uint32_t failures = 0;
+	int same;
+
+	for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		c = &cases[i];
+		seq_tracker_init(&tracker);
+		for(segment = c->segments; segment < c->segments + SEGMENTS && segment->count != 0; segment++)
+		{
+			for(uint16_t n = 0; n < segment->count; n++)
+			{
+				seq_tracker_add(&tracker, (uint16_t)(segment->first + n));
+			}
+		}
+		seq_tracker_flush(&tracker);
+
+		same = seq_tracker_expected(&tracker) == c->expected
+			&& tracker.received == c->received
+			&& seq_tracker_lost(&tracker) == c->expected - c->received
+			&& tracker.duplicates == c->duplicates
+			&& tracker.reordered == c->reordered
+			&& tracker.late == c->late
+			&& tracker.restarts == c->restarts
+			&& seq_tracker_longest_outage(&tracker) == c->longest;
+		for(int b = 0; b < SEQ_TRACKER_BURST_BUCKETS; b++)
+		{
+			same &= tracker.bursts[b] == c->bursts[b];
+		}
+
+		printf("%-15s exp %u rx %u dup %u reo %u late %u rst %u long %u bursts",
+			c->name, seq_tracker_expected(&tracker), tracker.received, tracker.duplicates,
+			tracker.reordered, tracker.late, tracker.restarts,
+			seq_tracker_longest_outage(&tracker));
+		for(int b = 0; b < SEQ_TRACKER_BURST_BUCKETS; b++)
+		{
+			printf(" %u", tracker.bursts[b]);
+		}
+		printf("%s\n", same ? "" : "  FAIL");
+		failures += !same;
+	}
+
+	for(uint8_t b = 0; b < SEQ_TRACKER_BURST_BUCKETS; b++)
+	{
+		if(seq_tracker_burst_lower(b) != bucket_lower[b])
+		{
+			printf("FAIL bucket %u starts at %u\n", b, seq_tracker_burst_lower(b));
+			failures++;
+		}
+	}
+
+	printf("%u failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+/*
+********************************************************************************
+* @file    spi_transport_test.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host test of the SPI1 transports in spi.c. Runs the same transmit,
+*          receive and exchange transfers through spi_transport_polled and
+*          spi_transport_dma on a fake HAL, for sizes on both sides of
+*          SPI_DMA_MIN_BYTES. Both must move the same bytes. The DMA
+*          transport must poll below the threshold, start DMA from it on,
+*          and only return once the completion callback has run. A failed
+*          DMA start must not hang. Exits with 1 on a failed check.
+*
+*          Build: cc -std=gnu99 -DSTM32L152xC -DUSE_HAL_DRIVER
+*                    -iquote ../Inc -I../Drivers/STM32L1xx_HAL_Driver/Inc
+*                    -I../Drivers/CMSIS/Include
+*                    -I../Drivers/CMSIS/Device/ST/STM32L1xx/Include
+*                    -o spi_transport_test spi_transport_test.c
+*          Use:   ./spi_transport_test
+*
+*          Add -DSPI_USE_DMA=0 to test the polled only build.
+*          The driver source is included so the fake interrupt can see the
+*          busy flag
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "spi.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define MAX_TRANSFER           255
+#define MAX_WAKE_UPS           4           // WFI calls before a wait counts as hung
+
+/* Interrupts are played by the fake DMA, WFI runs the pending completion */
+#define __get_PRIMASK()        0
+#define __set_PRIMASK(primask) ((void)(primask))
+#define __disable_irq()
+#define __enable_irq()
+#define __WFI()                fake_dma_irq()
+
+/* Without the ARM bit reverse */
+#undef POSITION_VAL
+#define POSITION_VAL(VAL)      __builtin_ctz(VAL)
+
+/* Private types -------------------------------------------------------------*/
+enum fake_call
+{
+	CALL_NONE,
+	CALL_POLLED,
+	CALL_DMA
+};
+
+/* Private variables ---------------------------------------------------------*/
+static struct
+{
+	enum fake_call call;                       // last HAL transfer call
+	uint16_t size;
+	void (*pending)(SPI_HandleTypeDef* hspi);  // completion the DMA will raise
+	uint8_t fail_start;                        // the next DMA start fails
+	uint32_t completions;
+	uint32_t wake_ups;
+	uint8_t sent[MAX_TRANSFER];                // MOSI of the last transfer
+} fake_spi;
+static uint32_t failures;
+
+/* Private function prototypes -----------------------------------------------*/
+#if SPI_USE_DMA
+static void fake_dma_irq(void);
+#endif
+
+#include "../Src/spi.c"
+
+/* Private function prototypes -----------------------------------------------*/
+static void check(int ok, const char* what, const char* transport, size_t size);
+static void run_transfers(const struct spi_transport* transport, const char* name,
+	size_t size, uint8_t* received, uint8_t* exchanged);
+static void test_size(size_t size);
+static void test_failed_start(void);
+
+/* Function definitions ------------------------------------------------------*/
+int main(void)
+{
+	static const size_t sizes[] =
+	{
+		1, 2, SPI_DMA_MIN_BYTES - 2, SPI_DMA_MIN_BYTES - 1, SPI_DMA_MIN_BYTES,
+		SPI_DMA_MIN_BYTES + 1, 64, MAX_TRANSFER
+	};
+
+	for(size_t i = 0; i < COUNTOF(sizes); i++)
+	{
+		test_size(sizes[i]);
+	}
+	test_failed_start();
+
+	printf("%u failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
+
+/* Fake HAL, the slave answers byte i with i * 3 + 1 and echoes MOSI inverted
+ * on an exchange ------------------------------------------------------------*/
+static void fake_spi_move(uint8_t* tx_data, uint8_t* rx_data, uint16_t size, enum fake_call call)
+{
+	fake_spi.call = call;
+	fake_spi.size = size;
+	for(uint16_t i = 0; i < size; i++)
+	{
+		fake_spi.sent[i] = tx_data ? tx_data[i] : 0x00;
+		if(rx_data)
+		{
+			rx_data[i] = tx_data ? (uint8_t)~tx_data[i] : (uint8_t)(i * 3 + 1);
+		}
+	}
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size, uint32_t Timeout)
+{
+	fake_spi_move(pData, 0, Size, CALL_POLLED);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size, uint32_t Timeout)
+{
+	fake_spi_move(0, pData, Size, CALL_POLLED);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef* hspi, uint8_t* pTxData, uint8_t* pRxData, uint16_t Size, uint32_t Timeout)
+{
+	fake_spi_move(pTxData, pRxData, Size, CALL_POLLED);
+	return HAL_OK;
+}
+
+#if SPI_USE_DMA
+static HAL_StatusTypeDef fake_spi_start_dma(void (*complete)(SPI_HandleTypeDef* hspi))
+{
+	if(fake_spi.fail_start)
+	{
+		fake_spi.fail_start = 0;
+		return HAL_ERROR;
+	}
+	fake_spi.pending = complete;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size)
+{
+	fake_spi_move(pData, 0, Size, CALL_DMA);
+	return fake_spi_start_dma(HAL_SPI_TxCpltCallback);
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size)
+{
+	fake_spi_move(0, pData, Size, CALL_DMA);
+	return fake_spi_start_dma(HAL_SPI_RxCpltCallback);
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef* hspi, uint8_t* pTxData, uint8_t* pRxData, uint16_t Size)
+{
+	fake_spi_move(pTxData, pRxData, Size, CALL_DMA);
+	return fake_spi_start_dma(HAL_SPI_TxRxCpltCallback);
+}
+#endif
+
+/* Only reached from spi_init and the MSP functions, which are not run */
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef* hspi) { return HAL_OK; }
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef* hdma) { return HAL_OK; }
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef* hdma) { return HAL_OK; }
+void HAL_GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_Init) { }
+void HAL_GPIO_DeInit(GPIO_TypeDef* GPIOx, uint32_t GPIO_Pin) { }
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority) { }
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) { }
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn) { }
+uint32_t HAL_RCC_GetPCLK2Freq(void) { return 32000000; }
+void rfm96_spi_disable(void) { }
+void Error_Handler(void) { }
+
+/* Private function definitions ----------------------------------------------*/
+#if SPI_USE_DMA
+/*
+ * brief : the DMA channel interrupt, raised by WFI in spi_dma_wait. A wait
+ *         that sleeps on without a transfer in flight would never end
+ */
+static void fake_dma_irq(void)
+{
+	void (*complete)(SPI_HandleTypeDef* hspi) = fake_spi.pending;
+
+	if(++fake_spi.wake_ups > MAX_WAKE_UPS)
+	{
+		printf("FAIL DMA wait does not end\n");
+		exit(1);
+	}
+
+	fake_spi.pending = 0;
+	if(complete)
+	{
+		fake_spi.completions++;
+		complete(&hspi1);
+	}
+}
+#endif
+
+static void check(int ok, const char* what, const char* transport, size_t size)
+{
+	if(!ok)
+	{
+		printf("FAIL %s, %s transport, %u bytes\n", what, transport, (unsigned)size);
+		failures++;
+	}
+}
+
+/*
+ * brief    : transmits, receives and exchanges size bytes on a transport,
+ *            checking the HAL call used for each
+ * received : bytes from the receive
+ * exchanged: bytes from the exchange
+ */
+static void run_transfers(const struct spi_transport* transport, const char* name,
+	size_t size, uint8_t* received, uint8_t* exchanged)
+{
+	enum fake_call expected = CALL_POLLED;
+	uint8_t tx_data[MAX_TRANSFER];
+
+#if SPI_USE_DMA
+	if(transport == &spi_transport_dma && size >= SPI_DMA_MIN_BYTES)
+	{
+		expected = CALL_DMA;
+	}
+#endif
+
+	for(size_t i = 0; i < size; i++)
+	{
+		tx_data[i] = (uint8_t)(i * 5 + 2);
+	}
+	spi_set_transport(transport);
+
+	fake_spi.completions = 0;
+	fake_spi.wake_ups = 0;
+	spi_transmit(tx_data, size);
+	check(fake_spi.call == expected && fake_spi.size == size, "transmit HAL call", name, size);
+	check(memcmp(fake_spi.sent, tx_data, size) == 0, "transmit bytes", name, size);
+
+	spi_receive(received, size);
+	check(fake_spi.call == expected && fake_spi.size == size, "receive HAL call", name, size);
+
+	spi_transmit_receive(tx_data, exchanged, size);
+	check(fake_spi.call == expected && fake_spi.size == size, "exchange HAL call", name, size);
+	check(memcmp(fake_spi.sent, tx_data, size) == 0, "exchange bytes sent", name, size);
+
+	/* Each DMA transfer waits for exactly its own completion */
+	check(fake_spi.completions == (expected == CALL_DMA ? 3 : 0), "completions", name, size);
+	check(fake_spi.pending == 0, "no completion left pending", name, size);
+}
+
+static void test_size(size_t size)
+{
+	uint8_t polled_received[MAX_TRANSFER];
+	uint8_t polled_exchanged[MAX_TRANSFER];
+
+	run_transfers(&spi_transport_polled, "polled", size, polled_received, polled_exchanged);
+#if SPI_USE_DMA
+	uint8_t dma_received[MAX_TRANSFER];
+	uint8_t dma_exchanged[MAX_TRANSFER];
+
+	run_transfers(&spi_transport_dma, "dma", size, dma_received, dma_exchanged);
+	check(memcmp(polled_received, dma_received, size) == 0, "receive matches polled", "dma", size);
+	check(memcmp(polled_exchanged, dma_exchanged, size) == 0, "exchange matches polled", "dma", size);
+#endif
+}
+
+/*
+ * brief : a DMA start the HAL refuses returns without waiting
+ */
+static void test_failed_start(void)
+{
+#if SPI_USE_DMA
+	uint8_t data[MAX_TRANSFER] = { 0 };
+
+	spi_set_transport(&spi_transport_dma);
+	fake_spi.wake_ups = 0;
+	fake_spi.fail_start = 1;
+	spi_transmit(data, MAX_TRANSFER);
+	check(fake_spi.wake_ups == 0 && spi_dma_busy == 0, "failed start does not wait", "dma", MAX_TRANSFER);
+#endif
+}
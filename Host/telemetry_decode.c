@@ -0,0 +1,75 @@
+/*
+********************************************************************************
+* @file    telemetry_decode.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host side decoder for the receiver's UART telemetry stream. Reads 
+*          the raw byte stream from a file or stdin and writes one CSV row 
+*          per valid frame to stdout, with a typed header row so the output 
+*          loads directly into pandas, or into Parquet via pyarrow.
+*
+*          Build: cc -I../Inc -o telemetry_decode telemetry_decode.c 
+*                    ../Src/telemetry.c ../Src/crc.c
+*          Use:   stty -F /dev/ttyUSB0 115200 raw 
+*                 ./telemetry_decode /dev/ttyUSB0 > run.csv
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include "telemetry.h"
+
+int main(int argc, char** argv)
+{
+	FILE* in = stdin;
+	uint8_t frame[TELEMETRY_FRAME_MAX];
+	size_t size = 0;
+	uint8_t overflow = 0;
+	unsigned long good = 0;
+	unsigned long bad = 0;
+	struct telemetry_record record;
+	int c;
+
+	if(argc > 1 && (in = fopen(argv[1], "rb")) == NULL)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+
+	printf("type,session,seq,tick_ms,rssi_dbm,snr_db,freq_error_hz\n");
+
+	while((c = fgetc(in)) != EOF)
+	{
+		if(c != TELEMETRY_DELIMITER)
+		{
+			/* Oversized frames are garbage, skip to the next delimiter */
+			if(size < sizeof(frame))
+				frame[size++] = (uint8_t)c;
+			else
+				overflow = 1;
+			continue;
+		}
+
+		if(size > 0 && !overflow && telemetry_decode(frame, size, &record))
+		{
+			printf("%s,%u,%u,%lu,%d,%d,%ld\n", 
+				record.type == TELEMETRY_LOG ? "log" : "live", record.session,
+				record.seq, (unsigned long)record.tick, record.rssi, record.snr, 
+				(long)record.freq_error);
+			good++;
+		}
+		else if(size > 0)
+		{
+			bad++;
+		}
+		size = 0;
+		overflow = 0;
+	}
+
+	fprintf(stderr, "%lu frames decoded, %lu rejected\n", good, bad);
+	if(in != stdin)
+	{
+		fclose(in);
+	}
+	return 0;
+}
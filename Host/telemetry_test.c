@@ -0,0 +1,152 @@
+/*
+********************************************************************************
+* @file    telemetry_test.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host test of the telemetry codec in telemetry.c. Records with
+*          extreme and zero heavy fields make the round trip through a
+*          frame, and random buffers up to 600 bytes, including runs of 254
+*          and 255 non-zero bytes, make the round trip through COBS. Every
+*          single bit error and every truncation of a frame must be
+*          rejected. Exits with 1 on a failed check.
+*
+*          Build: cc -std=gnu99 -I../Inc -o telemetry_test telemetry_test.c
+*                    ../Src/telemetry.c ../Src/crc.c
+*          Use:   ./telemetry_test
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "telemetry.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define COBS_MAX_SIZE          600
+#define COBS_ROUNDS            20000
+
+/* Private variables ---------------------------------------------------------*/
+static const struct telemetry_record records[] =
+{
+	/* type              session seq    tick        freq_error   rssi  snr */
+	{ TELEMETRY_PACKET,  1,      1,     1000,       -4321,       -120, -7 },
+	{ TELEMETRY_PACKET,  0,      0,     0,          0,           0,    0 },
+	{ TELEMETRY_LOG,     255,    65535, 0xFFFFFFFF, -1,          -1,   -1 },
+	{ TELEMETRY_LOG,     128,    256,   0x01000000, INT32_MIN,   INT16_MIN, INT8_MIN },
+	{ TELEMETRY_PACKET,  7,      32768, 0x00010000, INT32_MAX,   INT16_MAX, INT8_MAX },
+	{ TELEMETRY_PACKET,  2,      0x0100, 0x00FF00FF, 0x00010000, -164, 20 },
+};
+static uint32_t random_state = 1;
+static uint32_t failures;
+
+/* Private function prototypes -----------------------------------------------*/
+static void check(int ok, const char* what, unsigned index);
+static uint32_t random_below(uint32_t limit);
+static void test_record(const struct telemetry_record* record, unsigned index);
+static void test_cobs(void);
+
+/* Function definitions ------------------------------------------------------*/
+int main(void)
+{
+	for(unsigned i = 0; i < sizeof(records) / sizeof(records[0]); i++)
+	{
+		test_record(&records[i], i);
+	}
+	test_cobs();
+
+	printf("%u failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
+
+/* Private function definitions ----------------------------------------------*/
+static void check(int ok, const char* what, unsigned index)
+{
+	if(!ok)
+	{
+		if(failures < 20)
+		{
+			printf("FAIL %s, case %u\n", what, index);
+		}
+		failures++;
+	}
+}
+
+static uint32_t random_below(uint32_t limit)
+{
+	random_state = random_state * 1103515245 + 12345;
+	return (random_state >> 8) % limit;
+}
+
+/*
+ * brief : a record comes back field for field from its frame, and no bit
+ *         error or truncation of the frame gets through
+ */
+static void test_record(const struct telemetry_record* record, unsigned index)
+{
+	uint8_t frame[TELEMETRY_FRAME_MAX];
+	uint8_t bad[TELEMETRY_FRAME_MAX];
+	struct telemetry_record out;
+	size_t size;
+	int zeros = 0;
+
+	size = telemetry_encode(record, frame);
+	for(size_t i = 0; i < size; i++)
+	{
+		zeros += frame[i] == TELEMETRY_DELIMITER;
+	}
+	check(size <= TELEMETRY_FRAME_MAX, "frame fits TELEMETRY_FRAME_MAX", index);
+	check(zeros == 1 && frame[size - 1] == TELEMETRY_DELIMITER, "delimiter only at the end", index);
+
+	memset(&out, 0xA5, sizeof(out));
+	check(telemetry_decode(frame, size - 1, &out), "frame decodes", index);
+	check(out.type == record->type && out.session == record->session && out.seq == record->seq
+		&& out.tick == record->tick && out.freq_error == record->freq_error
+		&& out.rssi == record->rssi && out.snr == record->snr, "record round trip", index);
+
+	for(size_t bit = 0; bit < 8 * (size - 1); bit++)
+	{
+		memcpy(bad, frame, size - 1);
+		bad[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+		check(!telemetry_decode(bad, size - 1, &out), "bit error rejected", index);
+	}
+	for(size_t length = 0; length < size - 1; length++)
+	{
+		check(!telemetry_decode(frame, length, &out), "truncated frame rejected", index);
+	}
+}
+
+/*
+ * brief : random buffers with few, many or no zero bytes
+ */
+static void test_cobs(void)
+{
+	uint8_t src[COBS_MAX_SIZE];
+	uint8_t encoded[COBS_MAX_SIZE + COBS_MAX_SIZE / 254 + 1];
+	uint8_t decoded[COBS_MAX_SIZE + COBS_MAX_SIZE / 254 + 1];
+	size_t size;
+	size_t encoded_size;
+	uint32_t zero_odds;
+	int zeros;
+
+	for(unsigned round = 0; round < COBS_ROUNDS; round++)
+	{
+		/* Lengths around the 254 byte block size come up often */
+		size = round % 4 == 0 ? 250 + random_below(12) : random_below(COBS_MAX_SIZE + 1);
+		zero_odds = round % 3 == 0 ? 0 : 1 + random_below(round % 3 == 1 ? 4 : 300);
+		for(size_t i = 0; i < size; i++)
+		{
+			src[i] = zero_odds != 0 && random_below(zero_odds) == 0 ? 0 : (uint8_t)(1 + random_below(255));
+		}
+
+		encoded_size = cobs_encode(src, size, encoded);
+		zeros = 0;
+		for(size_t i = 0; i < encoded_size; i++)
+		{
+			zeros += encoded[i] == 0;
+		}
+		check(zeros == 0, "no zero in COBS output", round);
+		check(encoded_size <= size + size / 254 + 1, "COBS overhead", round);
+		check(cobs_decode(encoded, encoded_size, decoded) == size
+			&& memcmp(src, decoded, size) == 0, "COBS round trip", round);
+	}
+}
@@ -0,0 +1,246 @@
+/*
+********************************************************************************
+* @file    timer_wheel_test.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Host test of timer_wheel.c against a reference model. Random
+*          one-shot and periodic timers, some beyond the reach of the wheel,
+*          are restarted and stopped from callbacks while the tick runs
+*          through a wrap-around. The host sleeps the way the main loop
+*          does, jumping straight to each timer_wheel_time_left deadline,
+*          and every callback must run on the exact tick the model expects.
+*          Also checks that a periodic timer fires once, in phase, after a
+*          long STOP instead of once per missed period. Exits with 1 on a
+*          failed check.
+*
+*          Build: cc -std=gnu99 -DSTM32L152xC -DUSE_HAL_DRIVER
+*                    -iquote ../Inc -I../Drivers/STM32L1xx_HAL_Driver/Inc
+*                    -I../Drivers/CMSIS/Include
+*                    -I../Drivers/CMSIS/Device/ST/STM32L1xx/Include
+*                    -o timer_wheel_test timer_wheel_test.c
+*                    ../Src/timer_wheel.c
+*          Use:   ./timer_wheel_test [expiries]
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "timer_wheel.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define TIMERS                 300
+#define MAX_DELAY              300000      // ms, past the 4.4 min reach
+#define START_TICK             (0xFFFFFFFFUL - 60000)
+
+/* Private types -------------------------------------------------------------*/
+struct model
+{
+	struct timer timer;
+	uint8_t active;
+	uint32_t expires;          // tick the callback must run on
+	uint32_t period;
+};
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t now;
+static struct model models[TIMERS];
+static uint32_t random_state = 1;
+static uint32_t expiries;
+static uint32_t stop_expiries;
+static uint32_t failures;
+
+/* Private function prototypes -----------------------------------------------*/
+static void check(int ok, const char* what);
+static uint32_t random_below(uint32_t limit);
+static void model_start(struct model* model);
+static void model_expired(void* arg);
+static void stop_expired(void* arg);
+static void test_random_timers(uint32_t count);
+static void test_long_stop(void);
+
+/* Function definitions ------------------------------------------------------*/
+int main(int argc, char** argv)
+{
+	test_random_timers(argc > 1 ? strtoul(argv[1], NULL, 0) : 200000);
+	test_long_stop();
+
+	printf("%u failures\n", failures);
+	return failures == 0 ? 0 : 1;
+}
+
+uint32_t HAL_GetTick(void)
+{
+	return now;
+}
+
+/* Private function definitions ----------------------------------------------*/
+static void check(int ok, const char* what)
+{
+	if(!ok)
+	{
+		if(failures < 10)
+		{
+			printf("FAIL %s at tick %u\n", what, now);
+		}
+		failures++;
+	}
+}
+
+static uint32_t random_below(uint32_t limit)
+{
+	random_state = random_state * 1103515245 + 12345;
+	return (random_state >> 8) % limit;
+}
+
+/*
+ * brief : starts a timer with a random delay, one in four one-shot. Timers
+ *         started from a callback run from the next tick on, so the delay
+ *         is at least 1 ms
+ */
+static void model_start(struct model* model)
+{
+	uint32_t delay = 1 + (random_below(8) == 0 ? random_below(MAX_DELAY) : random_below(500));
+	uint32_t period = random_below(4) == 0 ? 0 : 1 + random_below(random_below(8) == 0 ? MAX_DELAY : 200);
+
+	timer_start(&model->timer, delay, period);
+	model->active = 1;
+	model->expires = now + delay;
+	model->period = period;
+}
+
+/*
+ * brief : checks the tick and moves the model on, then restarts or stops
+ *         a random timer now and then, as application callbacks do
+ */
+static void model_expired(void* arg)
+{
+	struct model* model = arg;
+	struct model* other;
+
+	check(model->active, "callback of a stopped timer");
+	check(model->expires == now, "callback on the expected tick");
+	expiries++;
+
+	if(model->period != 0)
+	{
+		model->expires += model->period;
+		check(timer_active(&model->timer), "periodic timer stays armed");
+	}
+	else
+	{
+		model->active = 0;
+		check(!timer_active(&model->timer), "one-shot timer disarmed");
+	}
+
+	other = &models[random_below(TIMERS)];
+	switch(random_below(8))
+	{
+		case 0:
+			model_start(other);
+			break;
+
+		case 1:
+			timer_stop(&other->timer);
+			other->active = 0;
+			break;
+
+		default:
+			break;
+	}
+}
+
+/*
+ * brief : a periodic timer fired, on the tick in arg
+ */
+static void stop_expired(void* arg)
+{
+	check(*(uint32_t*)arg == now, "callback after the stop on the expected tick");
+	stop_expiries++;
+}
+
+/*
+ * brief : sleeps to each deadline the wheel reports, which must never be
+ *         later than the first expiry of the model
+ */
+static void test_random_timers(uint32_t count)
+{
+	uint32_t time_left;
+	uint32_t first;
+	uint8_t any;
+
+	now = START_TICK;
+	timer_wheel_init();
+	for(int i = 0; i < TIMERS; i++)
+	{
+		timer_init(&models[i].timer, model_expired, &models[i]);
+		model_start(&models[i]);
+	}
+
+	while(expiries < count)
+	{
+		any = 0;
+		first = 0;
+		for(int i = 0; i < TIMERS; i++)
+		{
+			if(models[i].active && (!any || (int32_t)(models[i].expires - first) < 0))
+			{
+				first = models[i].expires;
+				any = 1;
+			}
+		}
+
+		time_left = timer_wheel_time_left();
+		if(!any)
+		{
+			check(time_left == TIMER_NO_DEADLINE, "no deadline without timers");
+			model_start(&models[random_below(TIMERS)]);
+			continue;
+		}
+		check(time_left != TIMER_NO_DEADLINE && (int32_t)(first - (now + time_left)) >= 0,
+			"deadline no later than the first expiry");
+		if(time_left == TIMER_NO_DEADLINE)
+		{
+			break;
+		}
+
+		now += time_left;
+		timer_wheel_process();
+	}
+
+	printf("random timers: %u expiries, tick wrapped %s, ended at %u\n", expiries,
+		now < START_TICK ? "yes" : "no", now);
+	check(now < START_TICK, "tick wrapped");
+}
+
+/*
+ * brief : a 10 ms periodic timer through a 1 s STOP fires once and stays
+ *         on its 10 ms grid
+ */
+static void test_long_stop(void)
+{
+	struct timer timer;
+	uint32_t start;
+	uint32_t expected;
+
+	for(int i = 0; i < TIMERS; i++)
+	{
+		timer_stop(&models[i].timer);
+	}
+
+	start = now;
+	timer_init(&timer, stop_expired, &expected);
+	timer_start(&timer, 10, 10);
+
+	now = expected = start + 10;
+	timer_wheel_process();
+	now = expected = start + 1005;
+	timer_wheel_process();
+	check(stop_expiries == 2, "one callback for the missed periods");
+	check(timer_wheel_time_left() == 5, "next expiry keeps the phase");
+
+	now = expected = start + 1010;
+	timer_wheel_process();
+	check(stop_expiries == 3, "periodic timer goes on after the stop");
+	timer_stop(&timer);
+}
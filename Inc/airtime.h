@@ -0,0 +1,47 @@
+/*
+********************************************************************************
+* @file    airtime.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for airtime.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __airtime_H
+#define __airtime_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Types ---------------------------------------------------------------------*/
+struct airtime_params
+{
+	uint8_t spreading_factor;  // 6 - 12
+	uint32_t bandwidth;        // Hz
+	uint8_t coding_rate;       // denominator 5 - 8, i.e. 4/5 - 4/8
+	uint16_t preamble_length;  // programmed preamble symbols
+	uint8_t implicit_header;   // 1 if no explicit header is sent
+	uint8_t crc_on;            // 1 if payload CRC is sent
+	uint8_t low_data_rate_opt; // 1 if low data rate optimization is on
+	uint8_t payload_length;    // bytes
+};
+
+/* Function prototypes -------------------------------------------------------*/
+/* Time on air */
+uint32_t airtime_symbol_time_us(uint8_t spreading_factor, uint32_t bandwidth);
+uint8_t airtime_ldro_required(uint8_t spreading_factor, uint32_t bandwidth);
+uint32_t airtime_preamble_us(const struct airtime_params* params);
+uint32_t airtime_payload_symbols(const struct airtime_params* params);
+uint32_t airtime_time_on_air_us(const struct airtime_params* params);
+
+/* Throughput and duty cycle budget */
+uint32_t airtime_throughput_bps(const struct airtime_params* params);
+uint32_t airtime_min_interval_ms(uint32_t time_on_air_us, uint16_t duty_cycle);
+uint32_t airtime_max_packets_per_hour(uint32_t time_on_air_us, uint16_t duty_cycle);
+
+/* Defines -------------------------------------------------------------------*/
+#define AIRTIME_LDRO_SYMBOL_TIME  16000 // us, longer symbols require LDRO
+#define AIRTIME_DUTY_CYCLE_FULL   1000  // duty cycles are given per mille
+
+#endif /*__ airtime_H */
@@ -0,0 +1,40 @@
+/*
+********************************************************************************
+* @file    button.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for button.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __button_H
+#define __button_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32l1xx_hal.h"
+#include "stm32l152c_discovery.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define BUTTON_DEBOUNCE_TIME   20   // ms without edges before the level counts
+#define BUTTON_LONG_TIME       500  // ms held for a long press
+#define BUTTON_DOUBLE_TIME     250  // ms after a release that a second press may start
+#define BUTTON_QUEUE_SIZE      8    // events, must be a power of two
+
+/* Enums ---------------------------------------------------------------------*/
+enum button_event
+{
+	BUTTON_NONE,
+	BUTTON_SHORT,     // released before BUTTON_LONG_TIME, no second press
+	BUTTON_LONG,      // sent once held for BUTTON_LONG_TIME, before the release
+	BUTTON_DOUBLE     // second press started within BUTTON_DOUBLE_TIME
+};
+
+/* Function declarations -----------------------------------------------------*/
+void button_init(void);
+void button_exti_irq_handler(void);
+void button_tick(void);
+enum button_event button_get_event(void);
+void button_clear(void);
+
+#endif // __button_H
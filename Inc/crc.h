@@ -0,0 +1,24 @@
+/*
+********************************************************************************
+* @file    crc.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for crc.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __crc_H
+#define __crc_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define CRC16_CCITT_INIT  0xFFFF
+
+/* Function prototypes -------------------------------------------------------*/
+uint16_t crc16_ccitt(uint16_t crc, const void* data, size_t size);
+
+#endif /*__ crc_H */
@@ -24,6 +24,12 @@
 #define RFM96_NSS_PIN                     GPIO_PIN_2
 #define RFM96_RESET_PORT                  GPIOA
 #define RFM96_RESET_PIN                   GPIO_PIN_4
+/* DIO0 is wired to PA7 on the P1 header. PC12, used before, is LCD SEG30 on
+ * the Discovery board and was taken back by the LCD init. PA7 belongs to the
+ * touch slider, which this firmware does not use, and EXTI line 7 is free */
+#define RFM96_DIO0_PORT                   GPIOA
+#define RFM96_DIO0_PIN                    GPIO_PIN_7
+#define RFM96_DIO0_EXTI_IRQn              EXTI9_5_IRQn
 
 /* Size of buffer */
 #define BUFFERSIZE                       (COUNTOF(aTxBuffer) - 1)
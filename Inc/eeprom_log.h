@@ -0,0 +1,64 @@
+/*
+********************************************************************************
+* @file    eeprom_log.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for eeprom_log.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __eeprom_log_H
+#define __eeprom_log_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32l1xx_hal.h"
+#include "crc.h"
+#include "string.h"
+
+/* Types ---------------------------------------------------------------------*/
+/* One received packet, 12 bytes */
+struct eeprom_log_record
+{
+	uint32_t tick;       // ms since boot
+	int16_t freq_error;  // Hz, saturated
+	uint16_t seq;        // package ID
+	int16_t rssi;        // dBm
+	int8_t snr;          // dB
+	uint8_t session;     // boot the record was logged in
+};
+
+/* Two copies are kept and written alternately, the valid one with the 
+ * highest generation describes the log */
+struct eeprom_log_header
+{
+	uint32_t magic;
+	uint32_t generation;
+	uint16_t head;       // slot of the oldest record
+	uint16_t count;      // records committed
+	uint8_t session;
+	uint8_t reserved;
+	uint16_t crc;        // CRC-16-CCITT of the fields above
+};
+
+/* Function prototypes -------------------------------------------------------*/
+void eeprom_log_init(void);
+HAL_StatusTypeDef eeprom_log_append(const struct eeprom_log_record* record);
+uint8_t eeprom_log_batch_ready(void);
+HAL_StatusTypeDef eeprom_log_flush(void);
+HAL_StatusTypeDef eeprom_log_clear(void);
+uint16_t eeprom_log_count(void);
+uint32_t eeprom_log_dropped(void);
+uint8_t eeprom_log_session(void);
+uint8_t eeprom_log_read(uint16_t index, struct eeprom_log_record* record);
+
+/* Defines -------------------------------------------------------------------*/
+#define EEPROM_LOG_MAGIC      0x4C4F4731 // "LOG1"
+#define EEPROM_LOG_BATCH      8          // records buffered per EEPROM write
+#define EEPROM_LOG_BUFFER     (2 * EEPROM_LOG_BATCH) // room while a flush waits
+#define EEPROM_LOG_HEADER_A   FLASH_EEPROM_BASE
+#define EEPROM_LOG_HEADER_B   (FLASH_EEPROM_BASE + sizeof(struct eeprom_log_header))
+#define EEPROM_LOG_RECORDS    (FLASH_EEPROM_BASE + 2 * sizeof(struct eeprom_log_header))
+#define EEPROM_LOG_CAPACITY   ((FLASH_EEPROM_END + 1 - EEPROM_LOG_RECORDS) / sizeof(struct eeprom_log_record))
+
+#endif /*__ eeprom_log_H */
@@ -0,0 +1,40 @@
+/*
+********************************************************************************
+* @file    histogram.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for histogram.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __histogram_H
+#define __histogram_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+/* Number of 1 dB bins needed to cover lowest to highest, both inclusive */
+#define HISTOGRAM_BINS(lowest, highest) ((highest) - (lowest) + 1)
+
+#define RSSI_HISTOGRAM_LOWEST   -137 // dBm
+#define RSSI_HISTOGRAM_HIGHEST  0    // dBm
+#define SNR_HISTOGRAM_LOWEST    -20  // dB
+#define SNR_HISTOGRAM_HIGHEST   10   // dB
+
+/* Types ---------------------------------------------------------------------*/
+struct histogram
+{
+	uint32_t* bins;     // one counter per dB, supplied by the user
+	uint16_t num_bins;
+	int16_t lowest;     // value of the first bin
+	uint32_t count;
+};
+
+/* Function prototypes -------------------------------------------------------*/
+void histogram_init(struct histogram* hist, uint32_t* bins, int16_t lowest, int16_t highest);
+void histogram_add(struct histogram* hist, int16_t value);
+int16_t histogram_percentile(const struct histogram* hist, uint8_t percent);
+
+#endif /*__ histogram_H */
@@ -41,6 +41,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32l1xx_hal.h"
 #include "stm32l152c_discovery_glass_lcd.h" 
+#include "lcd_format.h"
 #include "gpio.h"
 #include "math.h"
 #include "string.h"
@@ -52,7 +53,9 @@ extern void Error_Handler(void);
 
 void MX_LCD_Init(void);
 void lcd_display_str(uint8_t* ptr);
+void lcd_display_text(const struct lcd_text* text);
 void lcd_display_int(int val); 
+void lcd_display_fixed(int32_t val, uint8_t decimals);
 void lcd_display_float(float val);
 void lcd_display_percentage(float val);
 void lcd_display_str_delayed(uint8_t* ptr, int delay_time);
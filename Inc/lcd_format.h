@@ -0,0 +1,38 @@
+/*
+********************************************************************************
+* @file    lcd_format.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for lcd_format.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __lcd_format_H
+#define __lcd_format_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define LCD_FORMAT_WIDTH          6    // character positions on the glass
+#define LCD_FORMAT_PERCENT_WIDTH  3    // positions left for digits before "°/%"
+#define LCD_FORMAT_NO_POINT       0xFF
+
+/* Types ---------------------------------------------------------------------*/
+/* One screen of text, the decimal point is lit on chars[point] */
+struct lcd_text
+{
+	uint8_t chars[LCD_FORMAT_WIDTH + 1];
+	uint8_t point;
+};
+
+/* Function prototypes -------------------------------------------------------*/
+void lcd_format_int(int32_t value, struct lcd_text* text);
+void lcd_format_fixed(int32_t value, uint8_t decimals, struct lcd_text* text);
+void lcd_format_float(float value, struct lcd_text* text);
+void lcd_format_percent(int32_t value, uint8_t decimals, struct lcd_text* text);
+void lcd_format_ratio(float ratio, struct lcd_text* text);
+uint8_t lcd_format_append_int(int32_t value, uint8_t pos, struct lcd_text* text);
+
+#endif /*__ lcd_format_H */
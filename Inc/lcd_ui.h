@@ -0,0 +1,50 @@
+/*
+********************************************************************************
+* @file    lcd_ui.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for lcd_ui.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __lcd_ui_H
+#define __lcd_ui_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "lcd.h"
+#include "timer_wheel.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define LCD_UI_QUEUE_SIZE     8  // screens, must be a power of two
+#define LCD_UI_HOLD           0  // duration: shown until the next screen is queued
+#define LCD_UI_SCROLL_GAP     2  // blanks between repeats of a scrolled sentence
+
+/* Types ---------------------------------------------------------------------*/
+enum lcd_ui_kind
+{
+	LCD_UI_TEXT,
+	LCD_UI_SCROLL
+};
+
+struct lcd_ui_screen
+{
+	uint8_t kind;              // LCD_UI_*
+	uint8_t repeats;           // scroll: passes over the sentence
+	uint16_t length;           // scroll: sentence length
+	uint32_t duration;         // ms shown, or ms per step when scrolling
+	struct lcd_text text;      // text: the formatted screen
+	const uint8_t* sentence;   // scroll: must stay valid until shown
+};
+
+/* Function prototypes -------------------------------------------------------*/
+void lcd_ui_init(void);
+uint8_t lcd_ui_idle(void);
+void lcd_ui_clear(void);
+uint8_t lcd_ui_show_str(const uint8_t* str, uint32_t duration);
+uint8_t lcd_ui_show_int(int32_t value, uint32_t duration);
+uint8_t lcd_ui_show_float(float value, uint32_t duration);
+uint8_t lcd_ui_show_percent(float ratio, uint32_t duration);
+uint8_t lcd_ui_show_scroll(const uint8_t* sentence, uint32_t step, uint8_t repeats);
+
+#endif /*__ lcd_ui_H */
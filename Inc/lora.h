@@ -7,22 +7,86 @@
 * @brief   Header file for LoRa.c
 ********************************************************************************
 */	
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __lora_H
+#define __lora_H
 
 /* Includes ------------------------------------------------------------------*/
 #include "defines.h"
 #include "spi.h"
+#include "airtime.h"
+#include "pkt_queue.h"
+#include "string.h"
+
+/* Types ---------------------------------------------------------------------*/
+typedef void (*rfm96_tx_callback)(uint8_t status);
+
+struct rfm96_modem_profile
+{
+	uint32_t frequency;       // Hz
+	uint8_t spreading_factor; // 6 - 12
+	uint8_t bandwidth;        // BW_* register code
+	uint8_t coding_rate;      // denominator 5 - 8, i.e. 4/5 - 4/8
+	uint16_t preamble_length; // symbols
+	uint8_t sync_word;
+	int8_t tx_power;          // dBm, 2 - 17 on PA_BOOST
+	uint8_t crc_on;
+};
+
+struct rfm96_rx_stats
+{
+	uint32_t packets;       // packets with a valid CRC
+	uint32_t crc_errors;    // packets dropped for a bad CRC
+	uint32_t fifo_overruns; // packets left in the FIFO without their RX done flag
+	uint32_t queue_drops;   // packets dropped because the queue was full
+};
+
+struct rfm96_cache_stats
+{
+	uint32_t hits;   // cached reads served from the shadow registers
+	uint32_t misses; // cached reads that had to go to the bus
+};
+
+/* External variables --------------------------------------------------------*/
+extern const struct rfm96_modem_profile rfm96_profile_fast;
+extern const struct rfm96_modem_profile rfm96_profile_balanced;
+extern const struct rfm96_modem_profile rfm96_profile_long_range;
 
 /* Function prototypes -------------------------------------------------------*/
 uint8_t rfm96_init(void); 
 
+/* Modem configuration */
+void rfm96_apply_profile(const struct rfm96_modem_profile* profile);
+const struct rfm96_modem_profile* rfm96_get_profile(void);
+uint32_t rfm96_bandwidth_hz(uint8_t bandwidth);
+uint32_t rfm96_time_on_air(const struct rfm96_modem_profile* profile, uint8_t payload_length);
+
 /* SPI */
 void rfm96_spi_enable(void);
 void rfm96_spi_disable(void);
+uint32_t rfm96_spi_speed_test(void);
 
 /* Write / Read */
 void rfm96_write_reg(uint8_t address, uint8_t value); 
 uint8_t rfm96_read_reg(uint8_t address);
 uint8_t rfm96_single_transfer(uint8_t address, uint8_t value);
+uint8_t rfm96_read_reg_cached(uint8_t address);
+uint8_t rfm96_write_reg_if_changed(uint8_t address, uint8_t value);
+void rfm96_burst_write(uint8_t address, const uint8_t* data, size_t size);
+void rfm96_burst_read(uint8_t address, uint8_t* data, size_t size);
+void rfm96_write_fifo(const uint8_t* data, size_t size);
+void rfm96_read_fifo(uint8_t* data, size_t size);
+
+/* Shadow register cache */
+void rfm96_cache_invalidate(void);
+void rfm96_cache_update(uint8_t address, uint8_t value);
+void rfm96_cache_get_stats(struct rfm96_cache_stats* stats);
+void rfm96_cache_reset_stats(void);
+
+/* Interrupts */
+void rfm96_dio0_map(uint8_t mapping);
+void rfm96_dio0_irq_handler(void);
+uint8_t rfm96_take_events(uint8_t mask);
 
 /* Mode selection */
 void rfm96_standby_mode(void);
@@ -33,15 +97,36 @@ void rfm96_continous_tx(void);
 void rfm96_begin_packet(void); 
 size_t rfm96_write_packet(const uint8_t *payload, size_t size);
 void rfm96_send_packet(void);
+uint8_t rfm96_send_async(const uint8_t* buf, size_t size, rfm96_tx_callback cb);
+void rfm96_tx_process(void);
+uint8_t rfm96_tx_busy(void);
+uint8_t rfm96_tx_step_due(void);
 
 /* Receive */
-uint8_t rfm96_receive_package(uint8_t* rx_buff);
+void rfm96_rx_start(void);
+struct pkt_queue* rfm96_rx_queue(void);
+void rfm96_rx_get_stats(struct rfm96_rx_stats* stats);
+void rfm96_rx_callback(void);
+int16_t rfm96_packet_rssi(void);
+int8_t rfm96_packet_snr(void);
+int32_t rfm96_packet_frequency_error(void);
 
 /* Defines -------------------------------------------------------------------*/
 /* Hardware definitions */
 #define RFM96_FREQUENCY          433000000 // 433 MHz
+#define RFM96_XTAL_FREQ          32000000  // Hz
+#define MAX_PKT_LENGTH           PKT_QUEUE_PAYLOAD_SIZE
 #define RFM96_TX_POWER           10        // dBm
-#define MAX_PKT_LENGTH           255       // bytes
+#define RFM96_SYNC_WORD          0x12
+#define RFM96_PREAMBLE_LENGTH    8         // symbols
+#define RFM96_DEFAULT_PROFILE    rfm96_profile_long_range
+#define RFM96_VERSION            0x12
+#define RFM96_SPI_MAX_CLOCK      10000000  // Hz
+#define RFM96_SPI_TEST_ROUNDS    16
+#define RFM96_NUM_REGS           0x80
+#define RFM96_RX_MODE_CHECK_TIME 100       // ms
+#define RFM96_TX_TIMEOUT_MARGIN  100       // ms, added to the time on air
+#define RFM96_RSSI_OFFSET        -137      // dBm
 
 /* SPI access mode */
 #define WNR_READ_ACCESS          0x7F // AND with this, msb = 0
@@ -90,7 +175,41 @@ uint8_t rfm96_receive_package(uint8_t* rx_buff);
 /* PA config */
 #define PA_BOOST                 0x80
 
+/* Bandwidth register codes, bits 7-4 of REG_MODEM_CONFIG_1 */
+#define BW_7_8_KHZ               0x0
+#define BW_10_4_KHZ              0x1
+#define BW_15_6_KHZ              0x2
+#define BW_20_8_KHZ              0x3
+#define BW_31_25_KHZ             0x4
+#define BW_41_7_KHZ              0x5
+#define BW_62_5_KHZ              0x6
+#define BW_125_KHZ               0x7
+#define BW_250_KHZ               0x8
+#define BW_500_KHZ               0x9
+
+/* Modem config bits */
+#define MC1_IMPLICIT_HEADER      0x01
+#define MC2_TX_CONTINUOUS        0x08
+#define MC2_RX_CRC_ON            0x04
+#define MC2_SYMB_TIMEOUT_MSB     0x03
+#define MC3_LOW_DATA_RATE_OPT    0x08
+#define MC3_AGC_AUTO_ON          0x04
+
 /* IRQ masks */
 #define IRQ_TX_DONE_MASK           0x08
 #define IRQ_PAYLOAD_CRC_ERROR_MASK 0x20
 #define IRQ_RX_DONE_MASK           0x40
+
+/* DIO0 mapping, bits 7-6 of REG_DIO_MAPPING_1 */
+#define DIO0_RX_DONE             0x00
+#define DIO0_TX_DONE             0x40
+#define DIO0_MAPPING_MASK        0xC0
+
+/* Asynchronous transmit status */
+#define RFM96_TX_OK              0
+#define RFM96_TX_TIMEOUT         1
+
+/* Radio events signalled through DIO0 */
+#define RFM96_EVENT_TX_DONE      0x01
+
+#endif /*__ lora_H */
@@ -16,13 +16,25 @@
 #include "spi.h"
 #include "lora.h"
 #include "lcd.h"
+#include "lcd_ui.h"
+#include "stats.h"
+#include "histogram.h"
+#include "seq_tracker.h"
+#include "eeprom_log.h"
+#include "uart.h"
+#include "telemetry.h"
+#include "rx_threads.h"
 
 /* Defines -------------------------------------------------------------------*/
 #define DISPLAY_DELAY              800  // ms
-#define BUTTON_HELD_LONG           500  // ms
-#define MAX_EXPECTED_NUM_PACKAGES  1000	
 #define LED_GREEN                  LED3
 #define LED_BLUE                   LED4
+#define RX_UNBOUNDED               0    // package count mode without limit
+#define STATS_BENCHMARK            0    // 1 to benchmark statistics at boot
+#define LCD_FORMAT_BENCHMARK       0    // 1 to benchmark number formatting at boot
+#define TX_DUTY_CYCLE              1000 // per mille, lower to respect band limits
+#define TELEMETRY_STREAM           0    // 1 to stream packages over USART1 on PB6
+#define RTOS_PORT                  0    // 1 to receive through the port threads of rx_threads.c
 
 /* Unions --------------------------------------------------------------------*/
 union two_byte_union
@@ -32,6 +44,6 @@ union two_byte_union
 };
 
 /* Function declarations -----------------------------------------------------*/
-void wait_for_user_button(void);
+enum button_event wait_for_user_button(void);
 
 #endif // __MAIN_H	
\ No newline at end of file
@@ -0,0 +1,54 @@
+/*
+********************************************************************************
+* @file    pkt_queue.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for pkt_queue.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __pkt_queue_H
+#define __pkt_queue_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define PKT_QUEUE_LENGTH        8   // entries, power of two
+#define PKT_QUEUE_PAYLOAD_SIZE  255 // bytes
+
+/* Types ---------------------------------------------------------------------*/
+/* Largest members first, so entries are packed into whole words */
+struct pkt_desc
+{
+	uint32_t tick;                            // HAL tick at reception
+	int32_t freq_error;                       // Hz
+	int16_t rssi;                             // dBm
+	int8_t snr;                               // dB
+	uint8_t length;                           // payload bytes
+	uint8_t payload[PKT_QUEUE_PAYLOAD_SIZE];
+};
+
+/* Single producer, single consumer ring. head is only written by the 
+ * producer and tail only by the consumer, so neither side needs a lock */
+struct pkt_queue
+{
+	struct pkt_desc entries[PKT_QUEUE_LENGTH];
+	volatile uint32_t head;
+	volatile uint32_t tail;
+};
+
+/* Function prototypes -------------------------------------------------------*/
+void pkt_queue_init(struct pkt_queue* queue);
+uint32_t pkt_queue_count(const struct pkt_queue* queue);
+
+/* Producer side */
+struct pkt_desc* pkt_queue_reserve(struct pkt_queue* queue);
+void pkt_queue_commit(struct pkt_queue* queue);
+
+/* Consumer side */
+const struct pkt_desc* pkt_queue_peek(struct pkt_queue* queue);
+void pkt_queue_release(struct pkt_queue* queue);
+
+#endif /*__ pkt_queue_H */
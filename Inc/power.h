@@ -0,0 +1,46 @@
+/*
+********************************************************************************
+* @file    power.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for power.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __power_H
+#define __power_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32l1xx_hal.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define POWER_WAIT_FOREVER     0xFFFFFFFF // timeout: only an interrupt wakes
+#define POWER_STOP_MIN_TIME    5          // ms, shorter waits use sleep mode
+#define POWER_STOP_MAX_TIME    30000      // ms, longest RTC wakeup timer period
+#define POWER_RTC_ASYNCH_DIV   128        // LSE / 128 = 256 Hz calendar clock
+#define POWER_RTC_SYNCH_DIV    256        // 256 Hz / 256 = 1 Hz, 3.9 ms subseconds
+#define POWER_WAKEUP_CLOCK_HZ  2048       // LSE / 16 clocks the wakeup timer
+
+/* Structs -------------------------------------------------------------------*/
+struct power_stats
+{
+	uint32_t sleeps;        // waits spent in sleep mode
+	uint32_t stops;         // waits spent in STOP mode
+	uint32_t stop_ms;       // total time in STOP mode
+	uint32_t wake_us;       // last STOP wakeup to 32 MHz ready latency
+	uint32_t wake_us_max;   // worst wake_us seen
+};
+
+/* External variables --------------------------------------------------------*/
+extern RTC_HandleTypeDef hrtc;
+
+/* Function declarations -----------------------------------------------------*/
+void power_init(void);
+void power_wait(uint32_t timeout);
+void power_wake(void);
+void power_stop_lock(void);
+void power_stop_unlock(void);
+void power_get_stats(struct power_stats* stats);
+
+#endif // __power_H
@@ -0,0 +1,81 @@
+/*
+********************************************************************************
+* @file    rtos_port.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for rtos_port.c and Host/rtos_port_posix.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __rtos_port_H
+#define __rtos_port_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "cmsis_os.h"
+#ifdef PORT_POSIX
+#include <pthread.h>
+#endif
+
+/* Defines -------------------------------------------------------------------*/
+#define PORT_MAX_THREADS       8           // thread ids 0 to PORT_MAX_THREADS - 1
+
+/* On target every thread is a scheduler task subscribed to the event of its
+ * id, listed in the application's task table where the order sets the
+ * priority. port_dispatch runs one message per dispatch */
+#define PORT_EVENT(id)         (1UL << (id))
+#define PORT_TASK(id, name)    { name, port_dispatch, PORT_EVENT(id) }
+
+/* Statically allocates a thread and its message queue, depth a power of two */
+#define PORT_THREAD_DEF(var, thread_name, thread_priority, thread_handler, queue_depth) \
+	static struct port_message var##_queue[queue_depth]; \
+	static struct port_thread var = { .name = thread_name, \
+		.priority = thread_priority, .handler = thread_handler, \
+		.queue = var##_queue, .depth = queue_depth }
+
+/* Types ---------------------------------------------------------------------*/
+typedef void (*port_handler)(uint32_t message);
+
+/* Structs -------------------------------------------------------------------*/
+struct port_message
+{
+	uint32_t value;
+	uint32_t stamp;              // port clock when put, for the latency
+};
+
+struct port_thread
+{
+	const char* name;
+	osPriority priority;         // host thread priority, unused on target
+	port_handler handler;        // runs to completion once per message
+	struct port_message* queue;
+	uint8_t depth;
+	volatile uint8_t head;       // written by port_message_put
+	volatile uint8_t tail;       // written by the thread
+	uint32_t messages;           // handled
+	uint32_t drops;              // put on a full queue
+	uint32_t max_latency_us;     // worst put to handler time
+	uint64_t total_latency_us;
+#ifdef PORT_POSIX
+	pthread_t handle;
+	pthread_mutex_t lock;
+	pthread_cond_t ready;
+	uint8_t running;
+#endif
+};
+
+/* Function declarations -----------------------------------------------------*/
+void port_init(void);
+osStatus port_thread_create(uint8_t id, struct port_thread* thread);
+osStatus port_message_put(uint8_t id, uint32_t message);
+const struct port_thread* port_thread_get(uint8_t id);
+void port_start(void);
+#ifdef PORT_POSIX
+void port_stop(void);
+uint8_t port_realtime(void);
+#else
+void port_dispatch(uint32_t events);
+#endif
+
+#endif // __rtos_port_H
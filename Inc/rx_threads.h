@@ -0,0 +1,56 @@
+/*
+********************************************************************************
+* @file    rx_threads.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for rx_threads.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __rx_threads_H
+#define __rx_threads_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "rtos_port.h"
+#include "pkt_queue.h"
+#include "stats.h"
+#include "histogram.h"
+#include "seq_tracker.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define RX_THREADS_QUEUE_DEPTH 16          // messages per thread, power of two
+
+/* Types ---------------------------------------------------------------------*/
+/* Port thread ids, in the order packages flow through them */
+enum rx_thread_id
+{
+	RX_THREAD_RADIO,           // osPriorityHigh, takes packages off the queue
+	RX_THREAD_STATS,           // osPriorityLow, updates the statistics
+	RX_THREAD_LCD,             // osPriorityLow, shows the package count
+	RX_THREAD_COUNT
+};
+
+/* Structs -------------------------------------------------------------------*/
+struct rx_threads_config
+{
+	struct pkt_queue* queue;             // filled by the radio interrupt
+	uint32_t limit;                      // packages to take, 0 for no limit
+	struct stats_acc* rssi_stats;        // written by the stats thread
+	struct stats_acc* snr_stats;
+	struct histogram* rssi_hist;
+	struct histogram* snr_hist;
+	struct seq_tracker* seq_tracker;
+	void (*packet)(const struct pkt_desc* packet); // radio thread, may be 0,
+	                                     // only given packages with an ID
+	void (*show)(uint32_t packets);      // lcd thread, may be 0
+};
+
+/* Function declarations -----------------------------------------------------*/
+void rx_threads_init(const struct rx_threads_config* config);
+void rx_threads_radio_irq(void);
+void rx_threads_stop(void);
+uint32_t rx_threads_short_packets(void);
+
+#endif // __rx_threads_H
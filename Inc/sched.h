@@ -0,0 +1,47 @@
+/*
+********************************************************************************
+* @file    sched.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for sched.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __sched_H
+#define __sched_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32l1xx_hal.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define SCHED_MAX_TASKS        8           // tasks in a table, highest priority first
+
+/* Events published to every task subscribed to them, the low bits are free
+ * for events a task is signalled with directly */
+#define SCHED_EVENT_RADIO      (1UL << 31) // DIO0 interrupt or transmit timeout
+#define SCHED_EVENT_BUTTON     (1UL << 30) // button events queued
+
+/* Types ---------------------------------------------------------------------*/
+typedef void (*sched_entry)(uint32_t events);
+
+/* Structs -------------------------------------------------------------------*/
+struct sched_task
+{
+	const char* name;            // up to six characters, shown on the LCD
+	sched_entry entry;           // runs to completion with the taken events
+	uint32_t subscribed;         // published events delivered to this task
+	volatile uint32_t events;    // pending, taken when the task runs
+	uint32_t ready_cycles;       // cycle counter when the task became ready
+	uint32_t runs;
+	uint32_t max_latency_us;     // worst ready to dispatch time
+	uint32_t max_run_us;         // worst time spent in entry
+};
+
+/* Function declarations -----------------------------------------------------*/
+void sched_init(struct sched_task* tasks, uint8_t count);
+void sched_signal(uint8_t task, uint32_t events);
+void sched_publish(uint32_t events);
+void sched_run(void);
+
+#endif // __sched_H
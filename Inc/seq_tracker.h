@@ -0,0 +1,50 @@
+/*
+********************************************************************************
+* @file    seq_tracker.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for seq_tracker.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __seq_tracker_H
+#define __seq_tracker_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define SEQ_TRACKER_WINDOW        32 // packets, late arrivals within are accepted
+#define SEQ_TRACKER_BURST_BUCKETS 7  // loss runs of 1, 2, 3-4, 5-8, ..., 33+
+
+/* Types ---------------------------------------------------------------------*/
+struct seq_tracker
+{
+	uint32_t first;      // sequence number of the first packet, extended
+	uint32_t highest;    // newest sequence number, extended past 16 bits
+	uint32_t window;     // bit n set if highest - n has been received
+	uint32_t received;   // unique packets
+	uint32_t duplicates;
+	uint32_t reordered;  // packets older than highest that filled a gap
+	uint32_t late;       // packets too old for the window, ignored
+	uint32_t restarts;   // the transmitter started its numbering over
+	uint32_t run;        // length of the loss run being retired
+	uint32_t longest_run;
+	uint32_t bursts[SEQ_TRACKER_BURST_BUCKETS];
+	uint16_t restart_seq; // last packet too old for the window
+	uint8_t restart_pending;
+	uint8_t started;
+};
+
+/* Function prototypes -------------------------------------------------------*/
+void seq_tracker_init(struct seq_tracker* tracker);
+void seq_tracker_add(struct seq_tracker* tracker, uint16_t seq);
+void seq_tracker_flush(struct seq_tracker* tracker);
+uint32_t seq_tracker_expected(const struct seq_tracker* tracker);
+uint32_t seq_tracker_lost(const struct seq_tracker* tracker);
+float seq_tracker_pdr(const struct seq_tracker* tracker);
+uint32_t seq_tracker_longest_outage(const struct seq_tracker* tracker);
+uint16_t seq_tracker_burst_lower(uint8_t bucket);
+
+#endif /*__ seq_tracker_H */
@@ -22,12 +22,38 @@
 /* Defines -------------------------------------------------------------------*/
 #define SPI_WAIT_TIME 5000
 
+/* Build time transport selection, set to 0 to only use the polled transport */
+#ifndef SPI_USE_DMA
+#define SPI_USE_DMA 1
+#endif
+
+/* Transfers shorter than this are cheaper to poll than to set up DMA for */
+#define SPI_DMA_MIN_BYTES 8
+
+/* Types ---------------------------------------------------------------------*/
+struct spi_transport
+{
+	void (*transmit)(uint8_t* tx_data, size_t num_bytes);
+	void (*receive)(uint8_t* rx_data, size_t num_bytes);
+	void (*transmit_receive)(uint8_t* tx_data, uint8_t* rx_data, size_t num_bytes);
+};
+
 /* External variables --------------------------------------------------------*/
 extern SPI_HandleTypeDef hspi1;
+extern const struct spi_transport spi_transport_polled;
+#if SPI_USE_DMA
+extern DMA_HandleTypeDef hdma_spi1_rx;
+extern DMA_HandleTypeDef hdma_spi1_tx;
+extern const struct spi_transport spi_transport_dma;
+#endif
 
 /* Function declarations -----------------------------------------------------*/
 void spi_init(void);
+void spi_set_transport(const struct spi_transport* transport);
+void spi_set_prescaler(uint32_t prescaler);
+uint32_t spi_get_clock(void);
 void spi_transmit(uint8_t* tx_data, size_t num_bytes);
+void spi_receive(uint8_t* rx_data, size_t num_bytes);
 void spi_transmit_receive(uint8_t* tx_data, uint8_t* rx_data, size_t num_bytes);
 
 #ifdef __cplusplus
@@ -0,0 +1,50 @@
+/*
+********************************************************************************
+* @file    stats.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for stats.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __stats_H
+#define __stats_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+/* 1 to build the CMSIS-DSP fixed point batch statistics, benchmarked 
+ * against the plain double precision loops */
+#ifndef STATS_USE_CMSIS_DSP
+#define STATS_USE_CMSIS_DSP      1
+#endif
+#define STATS_BATCH_CHUNK        32 // samples converted per CMSIS-DSP call
+#define STATS_BATCH_HEADROOM     1  // bits the q31 samples are shifted down
+
+/* Types ---------------------------------------------------------------------*/
+struct stats_acc
+{
+	uint32_t count;
+	float mean;
+	float m2;    // sum of squared differences from the mean
+	float min;
+	float max;
+};
+
+/* Function prototypes -------------------------------------------------------*/
+void stats_reset(struct stats_acc* acc);
+void stats_add(struct stats_acc* acc, float sample);
+float stats_mean(const struct stats_acc* acc);
+float stats_variance(const struct stats_acc* acc);
+float stats_std_dev(const struct stats_acc* acc);
+void stats_merge(struct stats_acc* acc, const struct stats_acc* other);
+
+/* Batch statistics over stored samples */
+void stats_batch_double(struct stats_acc* acc, const int8_t* samples, uint16_t n);
+#if STATS_USE_CMSIS_DSP
+void stats_batch_cmsis(struct stats_acc* acc, const int8_t* samples, uint16_t n);
+#endif
+
+#endif /*__ stats_H */
@@ -466,6 +466,9 @@ typedef enum
 
 #define C_FULL                ((uint16_t) 0xffdd)
 
+/* Longest wait for a pending display update before a frame is dropped (ms) */
+#define LCD_UPDATE_TIMEOUT    1000
+
 /**
   * @}
   */   
@@ -486,6 +489,8 @@ void BSP_LCD_GLASS_DisplayBar(uint32_t BarId);
 void BSP_LCD_GLASS_ClearBar(uint32_t BarId);
 void BSP_LCD_GLASS_BarLevelConfig(uint8_t BarLevel);
 void BSP_LCD_GLASS_Clear(void);
+void BSP_LCD_GLASS_FrameBegin(void);
+void BSP_LCD_GLASS_FrameEnd(void);
 /**
   * @}
   */
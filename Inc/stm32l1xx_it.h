@@ -46,6 +46,13 @@
 /* Exported functions ------------------------------------------------------- */
 
 void SysTick_Handler(void);
+void RTC_WKUP_IRQHandler(void);
+void EXTI0_IRQHandler(void);
+void EXTI9_5_IRQHandler(void);
+void DMA1_Channel2_IRQHandler(void);
+void DMA1_Channel3_IRQHandler(void);
+void DMA1_Channel4_IRQHandler(void);
+void USART1_IRQHandler(void);
 
 #ifdef __cplusplus
 }
@@ -5,14 +5,16 @@
 #include "stm32l152c_discovery.h"
 #include "stm32l152c_discovery_glass_lcd.h"
 #include "spi.h"
-#include "math.h"
+#include "power.h"
+#include "button.h"
+#include "timer_wheel.h"
+#include "sched.h"
 
 /* Function declarations -----------------------------------------------------*/
 void SystemClock_Config(void);
 void Error_Handler(void);
 void system_init(void);
-double mean(int8_t a[], uint8_t n);
-double std_dev(int8_t a[], uint8_t n, double mean);
-void wait_for_user_button(void);
-uint32_t wait_for_user_button_timed(void);
+void cycle_counter_init(void);
+uint32_t cycle_counter_read(void);
+enum button_event wait_for_user_button(void);
 
@@ -0,0 +1,47 @@
+/*
+********************************************************************************
+* @file    telemetry.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for telemetry.c, shared with the host decoder
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __telemetry_H
+#define __telemetry_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+
+/* Defines -------------------------------------------------------------------*/
+/* Record types */
+#define TELEMETRY_PACKET        1 // package received in this session
+#define TELEMETRY_LOG           2 // package read back from the EEPROM log
+
+/* Frame layout: COBS(record, CRC-16 little endian) followed by a 0 byte */
+#define TELEMETRY_RECORD_SIZE   15
+#define TELEMETRY_CRC_SIZE      2
+#define TELEMETRY_FRAME_MAX     (TELEMETRY_RECORD_SIZE + TELEMETRY_CRC_SIZE + 2)
+#define TELEMETRY_DELIMITER     0x00
+
+/* Types ---------------------------------------------------------------------*/
+struct telemetry_record
+{
+	uint8_t type;        // TELEMETRY_*
+	uint8_t session;     // boot the package was received in
+	uint16_t seq;        // package ID
+	uint32_t tick;       // ms since boot
+	int32_t freq_error;  // Hz
+	int16_t rssi;        // dBm
+	int8_t snr;          // dB
+};
+
+/* Function prototypes -------------------------------------------------------*/
+size_t telemetry_encode(const struct telemetry_record* record, uint8_t* frame);
+uint8_t telemetry_decode(const uint8_t* frame, size_t size, struct telemetry_record* record);
+size_t cobs_encode(const uint8_t* src, size_t size, uint8_t* dst);
+size_t cobs_decode(const uint8_t* src, size_t size, uint8_t* dst);
+
+#endif /*__ telemetry_H */
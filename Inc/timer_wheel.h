@@ -0,0 +1,46 @@
+/*
+********************************************************************************
+* @file    timer_wheel.h
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Header file for timer_wheel.c
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __timer_wheel_H
+#define __timer_wheel_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32l1xx_hal.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define TIMER_WHEEL_BITS       6   // log2 of the slots per level
+#define TIMER_WHEEL_SLOTS      (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS     3   // 1 ms, 64 ms and 4.1 s slots, 4.4 min reach
+#define TIMER_NO_DEADLINE      0xFFFFFFFF // timer_wheel_time_left: nothing armed
+
+/* Types ---------------------------------------------------------------------*/
+typedef void (*timer_callback)(void* arg);
+
+/* Structs -------------------------------------------------------------------*/
+struct timer
+{
+	struct timer* next;       // slot list, managed by the wheel
+	struct timer** pprev;     // link pointing at this timer, 0 when stopped
+	uint32_t expires;         // HAL tick of the next expiry
+	uint32_t period;          // ms between expiries, 0 for a one-shot timer
+	timer_callback callback;
+	void* arg;
+};
+
+/* Function declarations -----------------------------------------------------*/
+void timer_wheel_init(void);
+void timer_wheel_process(void);
+uint32_t timer_wheel_time_left(void);
+void timer_init(struct timer* timer, timer_callback callback, void* arg);
+void timer_start(struct timer* timer, uint32_t delay, uint32_t period);
+void timer_stop(struct timer* timer);
+uint8_t timer_active(const struct timer* timer);
+
+#endif // __timer_wheel_H
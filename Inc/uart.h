@@ -0,0 +1,36 @@
+/*
+********************************************************************************
+* File Name          : UART.h
+* Description        : This file provides code for the configuration
+*                      of the USART1 instance used for telemetry.
+********************************************************************************
+*/
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __uart_H
+#define __uart_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32l1xx_hal.h"
+#include "system_util.h"
+#include "string.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define UART_BAUD_RATE       115200
+#define UART_TX_BUFFER_SIZE  256    // bytes, power of two
+
+/* External variables --------------------------------------------------------*/
+extern UART_HandleTypeDef huart1;
+extern DMA_HandleTypeDef hdma_usart1_tx;
+
+/* Function declarations -----------------------------------------------------*/
+void uart_init(void);
+void uart_write(const uint8_t* data, size_t size);
+void uart_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__ uart_H */
@@ -0,0 +1,121 @@
+/*
+********************************************************************************
+* @file    airtime.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Time on air and duty cycle calculations for LoRa packets, following
+*          the Semtech SX1276 datasheet. Plain C without HAL dependencies
+********************************************************************************
+*/
+
+#include "airtime.h"
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief            : calculates the duration of one symbol, 2^SF / BW
+ * spreading_factor : 6 - 12
+ * bandwidth        : Hz
+ * retval           : symbol time in us
+ */
+uint32_t airtime_symbol_time_us(uint8_t spreading_factor, uint32_t bandwidth)
+{
+	return (uint32_t)(((uint64_t)1000000 << spreading_factor) / bandwidth);
+}
+
+/*
+ * brief  : checks if the symbol time is long enough to require low data rate 
+ *          optimization 
+ * retval : 1 if required, else 0
+ */
+uint8_t airtime_ldro_required(uint8_t spreading_factor, uint32_t bandwidth)
+{
+	return airtime_symbol_time_us(spreading_factor, bandwidth) > AIRTIME_LDRO_SYMBOL_TIME;
+}
+
+/*
+ * brief  : calculates the preamble duration, (n_preamble + 4.25) symbols
+ * retval : preamble duration in us
+ */
+uint32_t airtime_preamble_us(const struct airtime_params* params)
+{
+	uint64_t quarter_symbols = 4 * (uint64_t)params->preamble_length + 17;
+	return (uint32_t)(((quarter_symbols * 1000000) << params->spreading_factor) / (4 * (uint64_t)params->bandwidth));
+}
+
+/*
+ * brief  : calculates the number of payload symbols, including the header
+ *          8 + max(ceil((8PL - 4SF + 28 + 16CRC - 20IH) / 4(SF - 2DE)) * CR, 0)
+ * retval : number of symbols after the preamble
+ */
+uint32_t airtime_payload_symbols(const struct airtime_params* params)
+{
+	int32_t sf = params->spreading_factor;
+	int32_t numerator = 8 * (int32_t)params->payload_length - 4 * sf + 28
+		+ (params->crc_on ? 16 : 0) - (params->implicit_header ? 20 : 0);
+	int32_t denominator = 4 * (sf - (params->low_data_rate_opt ? 2 : 0));
+	int32_t blocks = 0;
+
+	if(numerator > 0)
+	{
+		blocks = (numerator + denominator - 1) / denominator;
+	}
+
+	return 8 + blocks * params->coding_rate;
+}
+
+/*
+ * brief  : calculates the time a packet occupies the channel
+ * retval : preamble plus payload duration in us
+ */
+uint32_t airtime_time_on_air_us(const struct airtime_params* params)
+{
+	uint64_t quarter_symbols = 4 * (uint64_t)params->preamble_length + 17
+		+ 4 * (uint64_t)airtime_payload_symbols(params);
+	return (uint32_t)(((quarter_symbols * 1000000) << params->spreading_factor) / (4 * (uint64_t)params->bandwidth));
+}
+
+/*
+ * brief  : calculates the effective payload bit rate of back to back packets
+ * retval : payload bits per second
+ */
+uint32_t airtime_throughput_bps(const struct airtime_params* params)
+{
+	uint32_t time_on_air = airtime_time_on_air_us(params);
+	if(time_on_air == 0)
+	{
+		return 0;
+	}
+	return (uint32_t)((uint64_t)params->payload_length * 8 * 1000000 / time_on_air);
+}
+
+/*
+ * brief          : calculates how often packets may start without exceeding 
+ *                  a duty cycle limit
+ * time_on_air_us : time on air of one packet
+ * duty_cycle     : allowed fraction of time on air, per mille
+ * retval         : minimum time between packet starts in ms
+ */
+uint32_t airtime_min_interval_ms(uint32_t time_on_air_us, uint16_t duty_cycle)
+{
+	if(duty_cycle == 0)
+	{
+		return UINT32_MAX;
+	}
+	return (uint32_t)(((uint64_t)time_on_air_us * AIRTIME_DUTY_CYCLE_FULL / duty_cycle + 999) / 1000);
+}
+
+/*
+ * brief          : calculates the packet budget per hour for a duty cycle limit
+ * time_on_air_us : time on air of one packet
+ * duty_cycle     : allowed fraction of time on air, per mille
+ * retval         : maximum number of packets per hour
+ */
+uint32_t airtime_max_packets_per_hour(uint32_t time_on_air_us, uint16_t duty_cycle)
+{
+	if(time_on_air_us == 0)
+	{
+		return UINT32_MAX;
+	}
+	return (uint32_t)((uint64_t)3600000000UL * duty_cycle / AIRTIME_DUTY_CYCLE_FULL / time_on_air_us);
+}
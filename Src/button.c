@@ -0,0 +1,248 @@
+/*
+********************************************************************************
+* @file    button.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Interrupt driven user button. Edges are timestamped by the EXTI
+*          interrupt, debounced and classified into short, long and double
+*          presses in the SysTick interrupt, and queued for the main loop.
+*          While a press is being classified the mcu is kept out of STOP
+*          mode so the tick keeps running
+********************************************************************************
+*/
+
+#include "button.h"
+#include "power.h"
+#include "sched.h"
+
+/* Private types -------------------------------------------------------------*/
+enum button_state
+{
+	BUTTON_STATE_IDLE,
+	BUTTON_STATE_PRESSED,    // first press down, long press not reached
+	BUTTON_STATE_RELEASED,   // short press released, double press window open
+	BUTTON_STATE_HELD        // event sent, waiting for the release
+};
+
+/* Private variables ---------------------------------------------------------*/
+static volatile uint8_t events[BUTTON_QUEUE_SIZE];
+static volatile uint8_t events_head;      // written by button_tick
+static volatile uint8_t events_tail;      // read by the main loop
+static volatile uint32_t edge_tick;       // last edge, debouncing ends after it
+static volatile uint32_t first_edge_tick; // first edge of a bounce burst
+static volatile uint8_t debouncing;
+static uint8_t pressed;                   // debounced level, 1 if down
+static uint8_t locked;                    // holding a power STOP lock
+static enum button_state state;
+static uint32_t press_tick;
+static uint32_t release_tick;
+
+/* Private function prototypes -----------------------------------------------*/
+static void button_edge(uint8_t down, uint32_t tick);
+static uint8_t button_settling(uint32_t since, uint32_t window);
+static void button_push(enum button_event event);
+static void button_update_lock(void);
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief : configures the button for interrupts on both edges. Call after
+ *         power_init
+ */
+void button_init(void)
+{
+	/* The BSP only interrupts on presses, releases are needed as well */
+	BSP_PB_Init(BUTTON_USER, BUTTON_MODE_EXTI);
+	SET_BIT(EXTI->FTSR, USER_BUTTON_PIN);
+
+	events_head = 0;
+	events_tail = 0;
+	debouncing = 0;
+	locked = 0;
+
+	/* A button held through boot gives no event when let go */
+	pressed = (uint8_t)BSP_PB_GetState(BUTTON_USER);
+	state = pressed ? BUTTON_STATE_HELD : BUTTON_STATE_IDLE;
+	button_update_lock();
+}
+
+/*
+ * brief : timestamps a button edge, called from the EXTI interrupt. The
+ *         level is read once the bouncing has settled
+ */
+void button_exti_irq_handler(void)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	/* The tick interrupt reads these, keep it out while both are updated */
+	__disable_irq();
+	edge_tick = HAL_GetTick();
+	if(!debouncing)
+	{
+		first_edge_tick = edge_tick;
+		debouncing = 1;
+	}
+	button_update_lock();
+	__set_PRIMASK(primask);
+}
+
+/*
+ * brief : debounces and classifies presses, called from the SysTick
+ *         interrupt. Returns at once while the button is idle
+ */
+void button_tick(void)
+{
+	uint32_t now;
+	uint8_t level;
+
+	if(!locked)
+	{
+		return;
+	}
+
+	now = HAL_GetTick();
+	if(debouncing && now - edge_tick >= BUTTON_DEBOUNCE_TIME)
+	{
+		debouncing = 0;
+		level = (uint8_t)BSP_PB_GetState(BUTTON_USER);
+		if(level != pressed)
+		{
+			pressed = level;
+			button_edge(pressed, first_edge_tick);
+		}
+	}
+
+	/* An edge that came inside a window decides it once it has settled */
+	if(state == BUTTON_STATE_PRESSED && now - press_tick >= BUTTON_LONG_TIME
+		&& !button_settling(press_tick, BUTTON_LONG_TIME))
+	{
+		button_push(BUTTON_LONG);
+		state = BUTTON_STATE_HELD;
+	}
+	else if(state == BUTTON_STATE_RELEASED && now - release_tick >= BUTTON_DOUBLE_TIME
+		&& !button_settling(release_tick, BUTTON_DOUBLE_TIME))
+	{
+		button_push(BUTTON_SHORT);
+		state = BUTTON_STATE_IDLE;
+	}
+
+	button_update_lock();
+}
+
+/*
+ * brief  : takes the oldest button event, main loop use only
+ * retval : the event, BUTTON_NONE if there is none
+ */
+enum button_event button_get_event(void)
+{
+	enum button_event event;
+
+	if(events_tail == events_head)
+	{
+		return BUTTON_NONE;
+	}
+	event = (enum button_event)events[events_tail];
+	events_tail = (events_tail + 1) & (BUTTON_QUEUE_SIZE - 1);
+	return event;
+}
+
+/*
+ * brief : drops the queued events, a press being classified is kept
+ */
+void button_clear(void)
+{
+	events_tail = events_head;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief : advances the press state machine on a debounced edge
+ * down  : 1 for a press, 0 for a release
+ * tick  : when the edge happened
+ */
+static void button_edge(uint8_t down, uint32_t tick)
+{
+	switch(state)
+	{
+		case BUTTON_STATE_RELEASED:
+			if(tick - release_tick < BUTTON_DOUBLE_TIME)
+			{
+				button_push(BUTTON_DOUBLE);
+				state = BUTTON_STATE_HELD;
+				break;
+			}
+
+			/* Too late for a double press, this is a new one */
+			button_push(BUTTON_SHORT);
+			/* no break */
+
+		case BUTTON_STATE_IDLE:
+			if(down)
+			{
+				press_tick = tick;
+				state = BUTTON_STATE_PRESSED;
+			}
+			break;
+
+		case BUTTON_STATE_PRESSED:
+			if(!down)
+			{
+				release_tick = tick;
+				state = BUTTON_STATE_RELEASED;
+			}
+			break;
+
+		case BUTTON_STATE_HELD:
+		default:
+			if(!down)
+			{
+				state = BUTTON_STATE_IDLE;
+			}
+			break;
+	}
+}
+
+/*
+ * brief  : checks for an edge still being debounced that started within
+ *          window ms of since
+ * retval : 1 if there is one
+ */
+static uint8_t button_settling(uint32_t since, uint32_t window)
+{
+	return debouncing && first_edge_tick - since < window;
+}
+
+/*
+ * brief : queues an event, dropped if the main loop has fallen behind
+ */
+static void button_push(enum button_event event)
+{
+	uint8_t next = (events_head + 1) & (BUTTON_QUEUE_SIZE - 1);
+
+	if(next != events_tail)
+	{
+		events[events_head] = (uint8_t)event;
+		events_head = next;
+	}
+	sched_publish(SCHED_EVENT_BUTTON);
+}
+
+/*
+ * brief : holds a STOP lock while an edge is settling or a press is being
+ *         classified, SysTick does not run in STOP mode
+ */
+static void button_update_lock(void)
+{
+	uint8_t busy = debouncing || state != BUTTON_STATE_IDLE;
+
+	if(busy && !locked)
+	{
+		power_stop_lock();
+		locked = 1;
+	}
+	else if(!busy && locked)
+	{
+		power_stop_unlock();
+		locked = 0;
+	}
+}
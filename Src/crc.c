@@ -0,0 +1,36 @@
+/*
+********************************************************************************
+* @file    crc.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   CRC-16-CCITT (polynomial 0x1021, msb first), computed bitwise since
+*          only short headers and frames are checked
+********************************************************************************
+*/
+
+#include "crc.h"
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief  : updates a CRC with a block of data, start with CRC16_CCITT_INIT
+ * crc    : CRC of the preceding data
+ * data   : bytes to add
+ * size   : number of bytes
+ * retval : CRC including data
+ */
+uint16_t crc16_ccitt(uint16_t crc, const void* data, size_t size)
+{
+	const uint8_t* bytes = data;
+
+	while(size--)
+	{
+		crc ^= (uint16_t)(*bytes++) << 8;
+		for(int i = 0; i < 8; i++)
+		{
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+		}
+	}
+
+	return crc;
+}
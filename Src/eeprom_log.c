@@ -0,0 +1,267 @@
+/*
+********************************************************************************
+* @file    eeprom_log.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Append only log of received packets in the data EEPROM, so results
+*          of unattended range tests survive resets.
+*
+*          Records are buffered in RAM and written a batch at a time, by the
+*          caller once eeprom_log_batch_ready says so. A batch of 8 records
+*          and its header is up to 28 word programs of about 3 ms each, and
+*          the core stalls on flash reads while one is in progress, so the
+*          write belongs in an idle task and not in the receive path. The 
+*          batch goes in before the header that commits it, and the header 
+*          alternates between two copies protected by a CRC, so a reset 
+*          during a write loses at most the uncommitted batch. A cleared log
+*          starts after the end of the previous one, spreading writes over 
+*          the whole record area. A full log drops new records instead of 
+*          overwriting committed ones, dropped records are counted
+********************************************************************************
+*/
+
+#include "eeprom_log.h"
+
+/* Private variables ---------------------------------------------------------*/
+static struct eeprom_log_header header;
+static uint32_t header_addr = EEPROM_LOG_HEADER_A; // copy holding header
+static struct eeprom_log_record batch[EEPROM_LOG_BUFFER];
+static uint8_t batch_count;
+static uint32_t dropped;           // records lost since init or clear
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t eeprom_log_header_valid(const struct eeprom_log_header* hdr);
+static HAL_StatusTypeDef eeprom_log_commit(void);
+static HAL_StatusTypeDef eeprom_log_write(uint32_t address, const void* data, uint32_t size);
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief : restores the log from the newest valid header and starts a new 
+ *         session, an EEPROM without valid headers gets an empty log
+ */
+void eeprom_log_init(void)
+{
+	const struct eeprom_log_header* a = (const struct eeprom_log_header*)EEPROM_LOG_HEADER_A;
+	const struct eeprom_log_header* b = (const struct eeprom_log_header*)EEPROM_LOG_HEADER_B;
+	uint8_t a_valid = eeprom_log_header_valid(a);
+	uint8_t b_valid = eeprom_log_header_valid(b);
+
+	batch_count = 0;
+	dropped = 0;
+
+	if(a_valid && (!b_valid || (int32_t)(a->generation - b->generation) > 0))
+	{
+		header = *a;
+		header_addr = EEPROM_LOG_HEADER_A;
+	}
+	else if(b_valid)
+	{
+		header = *b;
+		header_addr = EEPROM_LOG_HEADER_B;
+	}
+	else
+	{
+		memset(&header, 0, sizeof(header));
+		header.magic = EEPROM_LOG_MAGIC;
+		header_addr = EEPROM_LOG_HEADER_B; // first commit goes to A
+	}
+
+	header.session++;
+}
+
+/*
+ * brief  : buffers a record without touching the EEPROM
+ * retval : HAL_OK, or HAL_BUSY if the buffer is full and the record dropped
+ */
+HAL_StatusTypeDef eeprom_log_append(const struct eeprom_log_record* record)
+{
+	if(batch_count == EEPROM_LOG_BUFFER)
+	{
+		dropped++;
+		return HAL_BUSY;
+	}
+
+	batch[batch_count] = *record;
+	batch[batch_count].session = header.session;
+	batch_count++;
+	return HAL_OK;
+}
+
+/*
+ * brief  : a full batch is buffered and should be flushed
+ * retval : 1 if ready, else 0
+ */
+uint8_t eeprom_log_batch_ready(void)
+{
+	return batch_count >= EEPROM_LOG_BATCH;
+}
+
+/*
+ * brief  : writes buffered records and commits them, call from an idle task
+ *          and at the end of a run. Records that don't fit in the log are 
+ *          dropped, and so is the whole batch on a write error
+ * retval : HAL_OK, HAL_ERROR if the log is full and records were dropped, 
+ *          or the EEPROM write error
+ */
+HAL_StatusTypeDef eeprom_log_flush(void)
+{
+	HAL_StatusTypeDef status = HAL_OK;
+	uint16_t slot;
+	uint8_t written = 0;
+
+	if(batch_count == 0)
+	{
+		return HAL_OK;
+	}
+
+	HAL_FLASHEx_DATAEEPROM_Unlock();
+	for(int i = 0; i < batch_count && status == HAL_OK; i++)
+	{
+		if(header.count + written >= EEPROM_LOG_CAPACITY)
+		{
+			break;
+		}
+		slot = (header.head + header.count + written) % EEPROM_LOG_CAPACITY;
+		status = eeprom_log_write(EEPROM_LOG_RECORDS + slot * sizeof(struct eeprom_log_record),
+		                          &batch[i], sizeof(struct eeprom_log_record));
+		written++;
+	}
+
+	/* Records are in place, now commit them */
+	if(status == HAL_OK && written > 0)
+	{
+		header.count += written;
+		status = eeprom_log_commit();
+	}
+	HAL_FLASHEx_DATAEEPROM_Lock();
+
+	/* An uncommitted batch is lost as a whole */
+	if(status != HAL_OK)
+	{
+		written = 0;
+	}
+	else if(written < batch_count)
+	{
+		status = HAL_ERROR;
+	}
+	dropped += batch_count - written;
+
+	batch_count = 0;
+	return status;
+}
+
+/*
+ * brief  : empties the log, the next record goes in the slot after the 
+ *          last one so every slot is used in turn
+ * retval : HAL_OK, or the EEPROM write error
+ */
+HAL_StatusTypeDef eeprom_log_clear(void)
+{
+	HAL_StatusTypeDef status;
+
+	batch_count = 0;
+	dropped = 0;
+	header.head = (header.head + header.count) % EEPROM_LOG_CAPACITY;
+	header.count = 0;
+
+	HAL_FLASHEx_DATAEEPROM_Unlock();
+	status = eeprom_log_commit();
+	HAL_FLASHEx_DATAEEPROM_Lock();
+
+	return status;
+}
+
+/*
+ * brief  : number of committed records
+ */
+uint16_t eeprom_log_count(void)
+{
+	return header.count;
+}
+
+/*
+ * brief  : number of records dropped since init or the last clear, because 
+ *          the buffer or the log was full or a write failed
+ */
+uint32_t eeprom_log_dropped(void)
+{
+	return dropped;
+}
+
+/*
+ * brief  : session number stamped on records logged since boot
+ */
+uint8_t eeprom_log_session(void)
+{
+	return header.session;
+}
+
+/*
+ * brief  : reads a committed record, oldest first
+ * index  : 0 - eeprom_log_count() - 1
+ * retval : 1 if the record was read, 0 if index is out of range
+ */
+uint8_t eeprom_log_read(uint16_t index, struct eeprom_log_record* record)
+{
+	uint16_t slot;
+
+	if(index >= header.count)
+	{
+		return 0;
+	}
+
+	slot = (header.head + index) % EEPROM_LOG_CAPACITY;
+	memcpy(record, (const void*)(EEPROM_LOG_RECORDS + slot * sizeof(struct eeprom_log_record)), 
+	       sizeof(struct eeprom_log_record));
+	return 1;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief  : checks the magic number and CRC of a header copy
+ * retval : 1 if valid, else 0
+ */
+static uint8_t eeprom_log_header_valid(const struct eeprom_log_header* hdr)
+{
+	return hdr->magic == EEPROM_LOG_MAGIC
+		&& hdr->crc == crc16_ccitt(CRC16_CCITT_INIT, hdr, offsetof(struct eeprom_log_header, crc))
+		&& hdr->head < EEPROM_LOG_CAPACITY && hdr->count <= EEPROM_LOG_CAPACITY;
+}
+
+/*
+ * brief  : writes the header to the copy not holding the current one, the 
+ *          current copy stays valid until the new one is complete. The 
+ *          EEPROM must be unlocked
+ */
+static HAL_StatusTypeDef eeprom_log_commit(void)
+{
+	header.generation++;
+	header.crc = crc16_ccitt(CRC16_CCITT_INIT, &header, offsetof(struct eeprom_log_header, crc));
+	header_addr = header_addr == EEPROM_LOG_HEADER_A ? EEPROM_LOG_HEADER_B : EEPROM_LOG_HEADER_A;
+
+	return eeprom_log_write(header_addr, &header, sizeof(header));
+}
+
+/*
+ * brief   : programs whole words, skipping words that already hold the data 
+ *           to save erase/program cycles. The EEPROM must be unlocked
+ * address : word aligned EEPROM address
+ * data    : word aligned source
+ * size    : multiple of 4 bytes
+ */
+static HAL_StatusTypeDef eeprom_log_write(uint32_t address, const void* data, uint32_t size)
+{
+	const uint32_t* src = data;
+	HAL_StatusTypeDef status = HAL_OK;
+
+	for(uint32_t i = 0; i < size / 4 && status == HAL_OK; i++)
+	{
+		if(*(volatile const uint32_t*)(address + 4 * i) != src[i])
+		{
+			status = HAL_FLASHEx_DATAEEPROM_Program(FLASH_TYPEPROGRAMDATA_WORD, address + 4 * i, src[i]);
+		}
+	}
+
+	return status;
+}
@@ -0,0 +1,88 @@
+/*
+********************************************************************************
+* @file    histogram.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Fixed bin histograms with 1 dB resolution for link quality values. 
+*          Memory use depends only on the value range, so any number of 
+*          samples can be added and percentiles are answered from the counts
+********************************************************************************
+*/
+
+#include "histogram.h"
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief   : sets up an empty histogram
+ * bins    : HISTOGRAM_BINS(lowest, highest) counters
+ * lowest  : smallest value with its own bin
+ * highest : largest value with its own bin
+ */
+void histogram_init(struct histogram* hist, uint32_t* bins, int16_t lowest, int16_t highest)
+{
+	hist->bins = bins;
+	hist->num_bins = HISTOGRAM_BINS(lowest, highest);
+	hist->lowest = lowest;
+	hist->count = 0;
+
+	for(int i = 0; i < hist->num_bins; i++)
+	{
+		bins[i] = 0;
+	}
+}
+
+/*
+ * brief : counts one value, values outside the range go to the edge bins
+ */
+void histogram_add(struct histogram* hist, int16_t value)
+{
+	int32_t index = (int32_t)value - hist->lowest;
+
+	if(index < 0)
+	{
+		index = 0;
+	}
+	else if(index >= hist->num_bins)
+	{
+		index = hist->num_bins - 1;
+	}
+
+	hist->bins[index]++;
+	hist->count++;
+}
+
+/*
+ * brief   : finds the nearest rank percentile by walking the bins
+ * percent : 0 - 100
+ * retval  : smallest value with at least percent of the samples at or 
+ *           below it, the lowest value if the histogram is empty
+ */
+int16_t histogram_percentile(const struct histogram* hist, uint8_t percent)
+{
+	uint32_t rank;
+	uint32_t cumulative = 0;
+
+	if(percent > 100)
+	{
+		percent = 100;
+	}
+
+	/* Rank of the sample sought, rounded up and at least the first one */
+	rank = (uint32_t)(((uint64_t)hist->count * percent + 99) / 100);
+	if(rank == 0)
+	{
+		rank = 1;
+	}
+
+	for(int i = 0; i < hist->num_bins; i++)
+	{
+		cumulative += hist->bins[i];
+		if(cumulative >= rank)
+		{
+			return hist->lowest + i;
+		}
+	}
+
+	return hist->lowest;
+}
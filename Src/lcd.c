@@ -38,96 +38,58 @@
 
 LCD_HandleTypeDef hlcd;
 
-/* helper function */
-static int quick_pow10(int n)
+/* shows one formatted screen, composed and committed as one frame */
+void lcd_display_text(const struct lcd_text* text)
 {
-    static int pow10[10] = {
-        1, 10, 100, 1000, 10000, 
-        100000, 1000000, 10000000, 100000000, 1000000000
-    };
-
-    return pow10[n];
+	BSP_LCD_GLASS_FrameBegin();
+	BSP_LCD_GLASS_Clear();
+	for(uint8_t i = 0; i < LCD_FORMAT_WIDTH && text->chars[i] != 0; i++)
+	{
+		BSP_LCD_GLASS_WriteChar((uint8_t*)&text->chars[i], 
+			i == text->point ? POINT_ON : POINT_OFF, DOUBLEPOINT_OFF, i + 1);
+	}
+	BSP_LCD_GLASS_FrameEnd();
 }
 
-/* wrapper function */
+/* wrapper function, the screen is composed and committed as one frame */
 void lcd_display_str(uint8_t* ptr)
 {
+	BSP_LCD_GLASS_FrameBegin();
 	BSP_LCD_GLASS_Clear();
 	BSP_LCD_GLASS_DisplayString(ptr); 
+	BSP_LCD_GLASS_FrameEnd();
 }
 
-/* wrapper function */
+/* prints an integer, saturating at -99999 and 999999 */
 void lcd_display_int(int val)
 {
-	uint8_t string[6]; 
-	sprintf((char*)string, "%d", val); 
-	BSP_LCD_GLASS_Clear();  
-	BSP_LCD_GLASS_DisplayString(string);
+	struct lcd_text text;
+	lcd_format_int(val, &text);
+	lcd_display_text(&text);
 }
 
-/* prints a float to the display with decimal point, a little hacky */
-void lcd_display_float(float val)
+/* prints a fixed point number, value is scaled by 10^decimals */
+void lcd_display_fixed(int32_t val, uint8_t decimals)
 {
-	int i = 0;
-	double fraction, integer;
-	uint8_t frac_str[6], int_str[6];
-	int integer_digits;
-	
-	/* Clear display */
-	BSP_LCD_GLASS_Clear();  
-
-	/* Split float into integer and fraction parts */
-	fraction = modf(val, &integer);
-	fraction = fraction < 0 ? -fraction : fraction; // take absolute value 
-
-	/* Convert integer and fractional number parts into strings */
-	sprintf((char*)int_str, "%g", integer);
-	fraction *= quick_pow10(strlen((char*)int_str)); // shift decimal places 
-	sprintf((char*)frac_str, "%d", ((int)fraction));
-	integer_digits = strlen((char*)int_str);
-
-	/* Print integer part, with a decimal point behind last digit */
-	while(i < integer_digits - 1)
-	{
-		BSP_LCD_GLASS_WriteChar(&int_str[i], POINT_OFF, DOUBLEPOINT_OFF, i+1);	
-		i++;
-	}
-	BSP_LCD_GLASS_WriteChar(&int_str[i], POINT_ON, DOUBLEPOINT_OFF, i+1);	
-	i++;
+	struct lcd_text text;
+	lcd_format_fixed(val, decimals, &text);
+	lcd_display_text(&text);
+}
 
-	/* Print fraction part */
-	while(i < 6)
-	{
-		BSP_LCD_GLASS_WriteChar(&frac_str[i-integer_digits], POINT_OFF, DOUBLEPOINT_OFF, i+1);	
-		i++;
-	}
+/* prints a float with as many decimals as fit */
+void lcd_display_float(float val)
+{
+	struct lcd_text text;
+	lcd_format_float(val, &text);
+	lcd_display_text(&text);
 }
 
-/* prints a float with a percentage sign after */
+/* prints a fraction 0 - 1 as a percentage with one decimal and a percent sign */
 void lcd_display_percentage(float val)
 {
-	BSP_LCD_GLASS_Clear();
-	uint8_t ch1[2] = "°";
-	uint8_t ch2 = '/';
-	uint8_t ch3 = '%';
-
-	/* Turn input value into a 3 digit string */
-	int integer_val = (int)(val * 100);
-	uint8_t str[3];
-	sprintf((char*)str, "%d", integer_val);
-
-	/* Print percentage value */
-	int i;
-	for(i = 0; i < strlen((char*)str); i++)
-	{
-		BSP_LCD_GLASS_WriteChar(&str[i], POINT_OFF, DOUBLEPOINT_OFF, i+1);	
-	}
-	i++;
-
-	BSP_LCD_GLASS_WriteChar(&ch1[1], POINT_OFF, DOUBLEPOINT_OFF, i++);
-	BSP_LCD_GLASS_WriteChar(&ch2, POINT_OFF, DOUBLEPOINT_OFF, i++);
-	BSP_LCD_GLASS_WriteChar(&ch3, POINT_OFF, DOUBLEPOINT_OFF, i++);
-
+	struct lcd_text text;
+	lcd_format_ratio(val, &text);
+	lcd_display_text(&text);
 }
 
 /* wrapper function, waits before returning  */
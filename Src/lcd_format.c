@@ -0,0 +1,211 @@
+/*
+********************************************************************************
+* @file    lcd_format.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Number formatting for the six character glass LCD without sprintf.
+*          Values are fixed point integers rendered straight into character
+*          positions. Fractional digits that do not fit are rounded away, 
+*          integer parts that do not fit saturate to all nines
+********************************************************************************
+*/
+
+#include "lcd_format.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define GLYPH_DEGREE   0xB0 // small raised o, first glyph of the percent sign
+
+/* Private variables ---------------------------------------------------------*/
+static const uint32_t pow10[] = 
+{
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void format_fixed(int32_t value, uint8_t decimals, uint8_t width, struct lcd_text* text);
+static uint8_t count_digits(uint32_t value);
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief : formats an integer, -99999 to 999999
+ */
+void lcd_format_int(int32_t value, struct lcd_text* text)
+{
+	format_fixed(value, 0, LCD_FORMAT_WIDTH, text);
+}
+
+/*
+ * brief    : formats a fixed point number
+ * value    : number scaled by 10^decimals, e.g. -1234 with 2 decimals is -12.34
+ * decimals : fractional digits in value, 0 - 9
+ */
+void lcd_format_fixed(int32_t value, uint8_t decimals, struct lcd_text* text)
+{
+	format_fixed(value, decimals, LCD_FORMAT_WIDTH, text);
+}
+
+/*
+ * brief : formats a float with as many decimals as fit on the glass
+ */
+void lcd_format_float(float value, struct lcd_text* text)
+{
+	float magnitude = value < 0 ? -value : value;
+	uint8_t decimals = LCD_FORMAT_WIDTH - 1;
+
+	if(value != value)
+	{
+		text->chars[0] = 'N';
+		text->chars[1] = 'A';
+		text->chars[2] = 'N';
+		text->chars[3] = 0;
+		text->point = LCD_FORMAT_NO_POINT;
+		return;
+	}
+
+	/* Keep the scaled value within six digits, format_fixed rounds 
+	 * further if the sign needs the room */
+	while(decimals > 0 && magnitude * pow10[decimals] >= pow10[LCD_FORMAT_WIDTH])
+	{
+		decimals--;
+	}
+	if(magnitude >= (float)INT32_MAX)
+	{
+		format_fixed(value < 0 ? -INT32_MAX : INT32_MAX, 0, LCD_FORMAT_WIDTH, text);
+		return;
+	}
+
+	format_fixed((int32_t)(value * pow10[decimals] + (value < 0 ? -0.5f : 0.5f)), 
+		decimals, LCD_FORMAT_WIDTH, text);
+}
+
+/*
+ * brief    : formats a percentage followed by the three glyph percent sign
+ * value    : percent scaled by 10^decimals, e.g. 995 with 1 decimal is 99.5%
+ */
+void lcd_format_percent(int32_t value, uint8_t decimals, struct lcd_text* text)
+{
+	uint8_t i = 0;
+
+	format_fixed(value, decimals, LCD_FORMAT_PERCENT_WIDTH, text);
+	while(text->chars[i] != 0)
+	{
+		i++;
+	}
+	text->chars[i++] = GLYPH_DEGREE;
+	text->chars[i++] = '/';
+	text->chars[i++] = '%';
+	text->chars[i] = 0;
+}
+
+/*
+ * brief : formats a ratio, 1.0 being 100%, as a percentage with one decimal
+ */
+void lcd_format_ratio(float ratio, struct lcd_text* text)
+{
+	lcd_format_percent((int32_t)(ratio * 1000.0f + (ratio < 0 ? -0.5f : 0.5f)), 1, text);
+}
+
+/*
+ * brief  : writes an integer from a position on, for labels mixing text and
+ *          numbers such as "P95" or "9-16". Saturates to the room left
+ * pos    : first position to write, the text before it is kept
+ * retval : position after the last digit, where the text is terminated
+ */
+uint8_t lcd_format_append_int(int32_t value, uint8_t pos, struct lcd_text* text)
+{
+	struct lcd_text part;
+	uint8_t i = 0;
+
+	text->point = LCD_FORMAT_NO_POINT;
+	if(pos >= LCD_FORMAT_WIDTH)
+	{
+		text->chars[LCD_FORMAT_WIDTH] = 0;
+		return LCD_FORMAT_WIDTH;
+	}
+
+	format_fixed(value, 0, LCD_FORMAT_WIDTH - pos, &part);
+	while(part.chars[i] != 0)
+	{
+		text->chars[pos++] = part.chars[i++];
+	}
+	text->chars[pos] = 0;
+	return pos;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief : renders value into the first width positions of text
+ */
+static void format_fixed(int32_t value, uint8_t decimals, uint8_t width, struct lcd_text* text)
+{
+	uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+	uint8_t sign = value < 0 ? 1 : 0;
+	uint8_t digits;
+
+	/* Round away fractional digits until the number fits */
+	while(decimals > 0)
+	{
+		digits = count_digits(magnitude);
+		if(digits < decimals + 1)
+		{
+			digits = decimals + 1;
+		}
+		if(sign + digits <= width)
+		{
+			break;
+		}
+		magnitude = magnitude / 10 + (magnitude % 10 >= 5 ? 1 : 0);
+		decimals--;
+	}
+
+	/* Rounding may have left nothing to show a sign for */
+	if(magnitude == 0)
+	{
+		sign = 0;
+	}
+
+	/* Saturate integers that are too wide */
+	digits = count_digits(magnitude);
+	if(decimals == 0 && sign + digits > width)
+	{
+		/* With no room for a digit the sign alone shows the value is out 
+		 * of range */
+		if(width <= sign)
+		{
+			text->chars[0] = '-';
+			text->chars[1] = 0;
+			text->point = LCD_FORMAT_NO_POINT;
+			return;
+		}
+		digits = width - sign;
+		magnitude = pow10[digits] - 1;
+	}
+	if(digits < decimals + 1)
+	{
+		digits = decimals + 1;
+	}
+
+	/* Digits right to left, leading zeros pad a pure fraction */
+	text->chars[sign + digits] = 0;
+	for(uint8_t i = sign + digits; i > sign; i--)
+	{
+		text->chars[i - 1] = '0' + magnitude % 10;
+		magnitude /= 10;
+	}
+	if(sign)
+	{
+		text->chars[0] = '-';
+	}
+	text->point = decimals > 0 ? sign + digits - decimals - 1 : LCD_FORMAT_NO_POINT;
+}
+
+static uint8_t count_digits(uint32_t value)
+{
+	uint8_t digits = 1;
+	while(digits < 10 && value >= pow10[digits])
+	{
+		digits++;
+	}
+	return digits;
+}
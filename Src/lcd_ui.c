@@ -0,0 +1,234 @@
+/*
+********************************************************************************
+* @file    lcd_ui.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Non-blocking display task. Screens are queued with a duration and
+*          shown one after the other from a timer on the timer wheel, so 
+*          timed messages and scrolling never stall the radio. Main loop use
+*          only, nothing here is interrupt safe
+********************************************************************************
+*/
+
+#include "lcd_ui.h"
+
+/* Private variables ---------------------------------------------------------*/
+static struct lcd_ui_screen queue[LCD_UI_QUEUE_SIZE];
+static uint8_t head;               // next screen to show
+static uint8_t tail;               // next free entry
+static struct lcd_ui_screen current;
+static uint8_t active;             // 1 while current is on the glass
+static struct timer screen_timer;  // ends current, or steps its scroll
+static uint16_t scroll_pos;        // first sentence character shown
+static uint8_t scroll_pass;
+
+/* Private function prototypes -----------------------------------------------*/
+static void lcd_ui_next(void* arg);
+static uint8_t lcd_ui_push(const struct lcd_ui_screen* screen);
+static void lcd_ui_render_scroll(void);
+
+/* Function definitions ------------------------------------------------------*/
+void lcd_ui_init(void)
+{
+	head = 0;
+	tail = 0;
+	active = 0;
+	timer_init(&screen_timer, lcd_ui_next, 0);
+}
+
+/*
+ * brief  : checks if the queue has run out
+ * retval : 1 if nothing is queued and the last screen is done or held
+ */
+uint8_t lcd_ui_idle(void)
+{
+	return head == tail 
+		&& (!active || (current.kind == LCD_UI_TEXT && current.duration == LCD_UI_HOLD));
+}
+
+/*
+ * brief : drops every queued screen and ends the current one, the glass 
+ *         keeps showing it until something new is queued
+ */
+void lcd_ui_clear(void)
+{
+	head = tail;
+	active = 0;
+	timer_stop(&screen_timer);
+}
+
+/*
+ * brief  : queues a string of up to six characters
+ * retval : 1 if queued, 0 if the queue is full
+ */
+uint8_t lcd_ui_show_str(const uint8_t* str, uint32_t duration)
+{
+	struct lcd_ui_screen screen;
+	uint8_t i;
+
+	for(i = 0; i < LCD_FORMAT_WIDTH && str[i] != 0; i++)
+	{
+		screen.text.chars[i] = str[i];
+	}
+	screen.text.chars[i] = 0;
+	screen.text.point = LCD_FORMAT_NO_POINT;
+	screen.kind = LCD_UI_TEXT;
+	screen.duration = duration;
+	return lcd_ui_push(&screen);
+}
+
+uint8_t lcd_ui_show_int(int32_t value, uint32_t duration)
+{
+	struct lcd_ui_screen screen;
+
+	lcd_format_int(value, &screen.text);
+	screen.kind = LCD_UI_TEXT;
+	screen.duration = duration;
+	return lcd_ui_push(&screen);
+}
+
+uint8_t lcd_ui_show_float(float value, uint32_t duration)
+{
+	struct lcd_ui_screen screen;
+
+	lcd_format_float(value, &screen.text);
+	screen.kind = LCD_UI_TEXT;
+	screen.duration = duration;
+	return lcd_ui_push(&screen);
+}
+
+uint8_t lcd_ui_show_percent(float ratio, uint32_t duration)
+{
+	struct lcd_ui_screen screen;
+
+	lcd_format_ratio(ratio, &screen.text);
+	screen.kind = LCD_UI_TEXT;
+	screen.duration = duration;
+	return lcd_ui_push(&screen);
+}
+
+/*
+ * brief    : queues a sentence scrolling right to left
+ * sentence : not copied, must stay valid until the scroll is done
+ * step     : ms per character
+ * repeats  : passes over the sentence
+ * retval   : 1 if queued, 0 if the queue is full
+ */
+uint8_t lcd_ui_show_scroll(const uint8_t* sentence, uint32_t step, uint8_t repeats)
+{
+	struct lcd_ui_screen screen;
+
+	screen.kind = LCD_UI_SCROLL;
+	screen.sentence = sentence;
+	screen.length = (uint16_t)strlen((const char*)sentence);
+	screen.duration = step;
+	screen.repeats = repeats;
+	if(screen.length == 0 || repeats == 0)
+	{
+		return 1;
+	}
+	return lcd_ui_push(&screen);
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief : screen timer callback, steps the scroll of the current screen or
+ *         ends it and shows the next queued one
+ */
+static void lcd_ui_next(void* arg)
+{
+	(void)arg;
+
+	if(active && current.kind == LCD_UI_SCROLL)
+	{
+		if(++scroll_pos == current.length + LCD_UI_SCROLL_GAP)
+		{
+			scroll_pos = 0;
+			scroll_pass++;
+		}
+		if(scroll_pass != current.repeats)
+		{
+			lcd_ui_render_scroll();
+			return;
+		}
+	}
+
+	active = 0;
+	timer_stop(&screen_timer);
+	if(head == tail)
+	{
+		return;
+	}
+
+	current = queue[head];
+	head = (head + 1) & (LCD_UI_QUEUE_SIZE - 1);
+	active = 1;
+
+	if(current.kind == LCD_UI_SCROLL)
+	{
+		scroll_pos = 0;
+		scroll_pass = 0;
+		lcd_ui_render_scroll();
+		timer_start(&screen_timer, current.duration, current.duration);
+	}
+	else
+	{
+		lcd_display_text(&current.text);
+		if(current.duration != LCD_UI_HOLD)
+		{
+			timer_start(&screen_timer, current.duration, 0);
+		}
+	}
+}
+
+/*
+ * brief  : appends a screen, a held text screen that has not been shown yet 
+ *          is replaced by a newer held one so live values never pile up
+ * retval : 1 if queued, 0 if the queue is full
+ */
+static uint8_t lcd_ui_push(const struct lcd_ui_screen* screen)
+{
+	uint8_t last = (tail - 1) & (LCD_UI_QUEUE_SIZE - 1);
+
+	if(head != tail && screen->kind == LCD_UI_TEXT && screen->duration == LCD_UI_HOLD
+		&& queue[last].kind == LCD_UI_TEXT && queue[last].duration == LCD_UI_HOLD)
+	{
+		queue[last] = *screen;
+		return 1;
+	}
+
+	if(((tail + 1) & (LCD_UI_QUEUE_SIZE - 1)) == head)
+	{
+		return 0;
+	}
+	queue[tail] = *screen;
+	tail = (tail + 1) & (LCD_UI_QUEUE_SIZE - 1);
+
+	/* Nothing timed on the glass, show it on the next timer service */
+	if(!active || (current.kind == LCD_UI_TEXT && current.duration == LCD_UI_HOLD))
+	{
+		timer_start(&screen_timer, 0, 0);
+	}
+	return 1;
+}
+
+/*
+ * brief : shows six characters of the scrolled sentence from scroll_pos, 
+ *         with LCD_UI_SCROLL_GAP blanks between the end and the start
+ */
+static void lcd_ui_render_scroll(void)
+{
+	struct lcd_text text;
+	uint16_t period = current.length + LCD_UI_SCROLL_GAP;
+	uint16_t index;
+
+	for(uint8_t i = 0; i < LCD_FORMAT_WIDTH; i++)
+	{
+		index = (scroll_pos + i) % period;
+		text.chars[i] = index < current.length ? current.sentence[index] : ' ';
+	}
+	text.chars[LCD_FORMAT_WIDTH] = 0;
+	text.point = LCD_FORMAT_NO_POINT;
+	lcd_display_text(&text);
+}
@@ -8,7 +8,72 @@
 ********************************************************************************
 */
 
-#include "LoRa.h"
+#include "lora.h"
+
+/* Private types -------------------------------------------------------------*/
+enum rfm96_tx_state
+{
+	TX_IDLE,
+	TX_BEGIN,
+	TX_WRITE,
+	TX_SEND,
+	TX_WAIT_DONE
+};
+
+/* Private variables ---------------------------------------------------------*/
+static enum rfm96_tx_state tx_state = TX_IDLE;
+static uint8_t tx_buff[MAX_PKT_LENGTH];
+static size_t tx_size;
+static rfm96_tx_callback tx_cb;
+static struct timer tx_timeout_timer;
+static uint8_t tx_timed_out;
+static uint8_t reg_shadow[RFM96_NUM_REGS];
+static uint32_t reg_valid[RFM96_NUM_REGS / 32];
+static struct rfm96_cache_stats cache_stats;
+static uint8_t dio0_mapping = DIO0_RX_DONE;
+static volatile uint8_t rfm96_events;
+static volatile uint8_t dio0_lock_depth;
+static uint8_t rx_rearm = 1;
+static struct timer rx_check_timer;
+static uint8_t rx_next_addr;
+static struct pkt_queue rx_queue;
+static struct rfm96_rx_stats rx_stats;
+
+/* Private function prototypes -----------------------------------------------*/
+static void rfm96_dio0_lock(void);
+static void rfm96_dio0_unlock(void);
+static void rfm96_rx_drain(void);
+static void rfm96_rx_read_packet(uint8_t addr, uint8_t length);
+static void rfm96_rx_check(void* arg);
+static void rfm96_tx_expired(void* arg);
+
+/* Modem profiles ------------------------------------------------------------*/
+/* Time on air for a 2 byte package with explicit header and CRC:           */
+/* fast 15.5 ms, balanced 103.4 ms, long range 925.7 ms                     */
+const struct rfm96_modem_profile rfm96_profile_fast =
+{
+	RFM96_FREQUENCY, 7, BW_250_KHZ, 5, RFM96_PREAMBLE_LENGTH, RFM96_SYNC_WORD,
+	RFM96_TX_POWER, 1
+};
+
+const struct rfm96_modem_profile rfm96_profile_balanced =
+{
+	RFM96_FREQUENCY, 9, BW_125_KHZ, 5, RFM96_PREAMBLE_LENGTH, RFM96_SYNC_WORD,
+	RFM96_TX_POWER, 1
+};
+
+const struct rfm96_modem_profile rfm96_profile_long_range =
+{
+	RFM96_FREQUENCY, 12, BW_125_KHZ, 8, RFM96_PREAMBLE_LENGTH, RFM96_SYNC_WORD,
+	RFM96_TX_POWER, 1
+};
+
+static const uint32_t bandwidth_hz[] = 
+{
+	7800, 10400, 15600, 20800, 31250, 41700, 62500, 125000, 250000, 500000
+};
+
+static struct rfm96_modem_profile active_profile;
 
 /* Function definitions ------------------------------------------------------*/
 /* 
@@ -25,43 +90,30 @@ uint8_t rfm96_init(void)
 	HAL_GPIO_WritePin(RFM96_RESET_PORT, RFM96_RESET_PIN, GPIO_PIN_SET);
 	HAL_Delay(10);
 
+	/* Reset puts all registers back to defaults */
+	rfm96_cache_invalidate();
+	dio0_mapping = DIO0_RX_DONE;
+	rx_rearm = 1;
+	timer_init(&rx_check_timer, rfm96_rx_check, 0);
+	timer_init(&tx_timeout_timer, rfm96_tx_expired, 0);
+	pkt_queue_init(&rx_queue);
+	memset(&rx_stats, 0, sizeof(rx_stats));
+
 	/* Put radio chip in sleep mode */
 	rfm96_sleep_mode();
 
-	/* Calculate frequency register value given 32 MHz radio chip oscillator */
-	uint64_t frf = ((uint64_t)RFM96_FREQUENCY << 19) / 32000000;
-	
-	/* Set frequency */
-	rfm96_write_reg(REG_FRF_MSB, (uint8_t)(frf >> 16));
-	rfm96_write_reg(REG_FRF_MID, (uint8_t)(frf >> 8));
-	rfm96_write_reg(REG_FRF_LSB, (uint8_t)(frf >> 0));
-
 	/* Set FIFO pointer base addresses */
 	rfm96_write_reg(REG_FIFO_TX_BASE_ADDR, 0);
   	rfm96_write_reg(REG_FIFO_RX_BASE_ADDR, 0);
 	
 	/* Set Low Noise Amplifier boost */
-	rfm96_write_reg(REG_LNA, rfm96_read_reg(REG_LNA) | 0x03);
-	
-	/* Turn on automatic gain control */
-	rfm96_write_reg(REG_MODEM_CONFIG_3, 0x04);
-	
-	/* Set output power to 8 dBm */
-	rfm96_write_reg(REG_PA_CONFIG, PA_BOOST | (RFM96_TX_POWER - 2));
-
-	/* Set code rate, bandwidth and header mode */
-	uint8_t config_1_val = rfm96_read_reg(REG_MODEM_CONFIG_1);
-	config_1_val = (config_1_val & 0x0F) | (0x7 << 4); //0x7 = bandwidth 125kHz
-	config_1_val = (config_1_val & 0xF1) | (0x4 << 1); //0x4 = code rate 4/8
-	rfm96_write_reg(REG_MODEM_CONFIG_1, config_1_val);
-
-	/* Set spread factor and CRC mode */
-	uint8_t config_2_val = rfm96_read_reg(REG_MODEM_CONFIG_2);
-	config_2_val = (config_2_val & 0x0F) | (0xA << 4); //0xA = spread factor 12
-	config_2_val = (config_2_val & 0xFB) | (0x1 << 2); //0x1 = CRC on
-	rfm96_write_reg(REG_MODEM_CONFIG_2, config_2_val);
-
-	/* Read register value for status */
+	rfm96_write_reg(REG_LNA, rfm96_read_reg_cached(REG_LNA) | 0x03);
+
+	/* Set frequency, modulation, output power and packet format */
+	memset(&active_profile, 0, sizeof(active_profile));
+	rfm96_apply_profile(&RFM96_DEFAULT_PROFILE);
+
+	/* Read register value for status, bypassing the cache to verify SPI */
 	uint8_t reg_status = 0x00;
 	reg_status = rfm96_read_reg(REG_MODEM_CONFIG_2);
 
@@ -70,6 +122,101 @@ uint8_t rfm96_init(void)
 
 	return reg_status;
 }
+/* Modem configuration functions ---------------------------------------------*/
+/*
+ *  brief   : reconfigures the radio chip modem, only writing the registers 
+ *            whose value changes. Call in sleep or standby mode
+ *  profile : the modem settings to apply
+ */
+void rfm96_apply_profile(const struct rfm96_modem_profile* profile)
+{
+	uint8_t reg_val;
+
+	/* Frequency, given 32 MHz radio chip oscillator */
+	if(profile->frequency != active_profile.frequency)
+	{
+		uint64_t frf = ((uint64_t)profile->frequency << 19) / 32000000;
+		rfm96_write_reg_if_changed(REG_FRF_MSB, (uint8_t)(frf >> 16));
+		rfm96_write_reg_if_changed(REG_FRF_MID, (uint8_t)(frf >> 8));
+		rfm96_write_reg_if_changed(REG_FRF_LSB, (uint8_t)(frf >> 0));
+	}
+
+	/* Output power on PA_BOOST pin, 2 - 17 dBm */
+	int8_t tx_power = profile->tx_power;
+	tx_power = tx_power < 2 ? 2 : (tx_power > 17 ? 17 : tx_power);
+	rfm96_write_reg_if_changed(REG_PA_CONFIG, PA_BOOST | (tx_power - 2));
+
+	/* Bandwidth and code rate, header mode is kept */
+	reg_val = rfm96_read_reg_cached(REG_MODEM_CONFIG_1) & MC1_IMPLICIT_HEADER;
+	reg_val |= (profile->bandwidth << 4) | ((profile->coding_rate - 4) << 1);
+	rfm96_write_reg_if_changed(REG_MODEM_CONFIG_1, reg_val);
+
+	/* Spreading factor and CRC, continuous TX and symbol timeout are kept */
+	reg_val = rfm96_read_reg_cached(REG_MODEM_CONFIG_2) & (MC2_TX_CONTINUOUS | MC2_SYMB_TIMEOUT_MSB);
+	reg_val |= (profile->spreading_factor << 4) | (profile->crc_on ? MC2_RX_CRC_ON : 0);
+	rfm96_write_reg_if_changed(REG_MODEM_CONFIG_2, reg_val);
+
+	/* Automatic gain control, low data rate optimization for long symbols */
+	uint8_t ldro = airtime_ldro_required(profile->spreading_factor, rfm96_bandwidth_hz(profile->bandwidth));
+	reg_val = MC3_AGC_AUTO_ON | (ldro ? MC3_LOW_DATA_RATE_OPT : 0);
+	rfm96_write_reg_if_changed(REG_MODEM_CONFIG_3, reg_val);
+
+	/* Spreading factor 6 needs its own detection settings */
+	rfm96_write_reg_if_changed(REG_DETECTION_OPTIMIZE, profile->spreading_factor == 6 ? 0xC5 : 0xC3);
+	rfm96_write_reg_if_changed(REG_DETECTION_THRESHOLD, profile->spreading_factor == 6 ? 0x0C : 0x0A);
+
+	/* Preamble length and sync word */
+	rfm96_write_reg_if_changed(REG_PREAMBLE_MSB, (uint8_t)(profile->preamble_length >> 8));
+	rfm96_write_reg_if_changed(REG_PREAMBLE_LSB, (uint8_t)(profile->preamble_length >> 0));
+	rfm96_write_reg_if_changed(REG_SYNC_WORD, profile->sync_word);
+
+	active_profile = *profile;
+}
+
+/*
+ *  brief  : returns the modem profile last applied 
+ */
+const struct rfm96_modem_profile* rfm96_get_profile(void)
+{
+	return &active_profile;
+}
+
+/*
+ *  brief          : calculates the time on air of a packet sent with a profile
+ *  profile        : modem settings, explicit header is assumed
+ *  payload_length : payload size in bytes
+ *  retval         : time on air in us
+ */
+uint32_t rfm96_time_on_air(const struct rfm96_modem_profile* profile, uint8_t payload_length)
+{
+	struct airtime_params params;
+
+	params.spreading_factor = profile->spreading_factor;
+	params.bandwidth = rfm96_bandwidth_hz(profile->bandwidth);
+	params.coding_rate = profile->coding_rate;
+	params.preamble_length = profile->preamble_length;
+	params.implicit_header = 0;
+	params.crc_on = profile->crc_on;
+	params.low_data_rate_opt = airtime_ldro_required(params.spreading_factor, params.bandwidth);
+	params.payload_length = payload_length;
+
+	return airtime_time_on_air_us(&params);
+}
+
+/*
+ *  brief     : converts a BW_* register code to Hz
+ *  bandwidth : BW_* register code
+ *  retval    : bandwidth in Hz 
+ */
+uint32_t rfm96_bandwidth_hz(uint8_t bandwidth)
+{
+	if(bandwidth >= COUNTOF(bandwidth_hz))
+	{
+		bandwidth = BW_125_KHZ;
+	}
+	return bandwidth_hz[bandwidth];
+}
+
 /* SPI communication functions -----------------------------------------------*/
 /*
  * brief     : wrapper function for GPIO_WritePin when enabling rfm96 chip spi
@@ -87,6 +234,80 @@ void rfm96_spi_disable(void)
 	HAL_GPIO_WritePin(SPI_NSS_GPIO_Port, SPI_NSS_Pin, GPIO_PIN_SET);
 }
 
+/*
+ * brief  : checks that register writes and reads survive the current SPI 
+ *          clock, using the sync word register as scratch space
+ * retval : 1 if all patterns were read back correctly, else 0
+ */
+static uint8_t rfm96_spi_check(void)
+{
+	static const uint8_t patterns[] = { 0x00, 0xFF, 0x55, 0xAA, 0x0F, 0xF0, 0x81 };
+
+	for(int round = 0; round < RFM96_SPI_TEST_ROUNDS; round++)
+	{
+		if(rfm96_read_reg(REG_VERSION) != RFM96_VERSION)
+		{
+			return 0;
+		}
+
+		for(uint32_t i = 0; i < sizeof(patterns); i++)
+		{
+			rfm96_write_reg(REG_SYNC_WORD, patterns[i]);
+			if(rfm96_read_reg(REG_SYNC_WORD) != patterns[i])
+			{
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+/*
+ * brief  : walks the SPI prescaler down from the boot setting and keeps the 
+ *          fastest clock that passes write/readback checks, staying within 
+ *          what the radio chip accepts. Call at boot, after rfm96_init
+ * retval : the selected SPI clock in Hz, 0 if no setting was reliable
+ */
+uint32_t rfm96_spi_speed_test(void)
+{
+	static const uint32_t prescalers[] = 
+	{
+		SPI_BAUDRATEPRESCALER_256, SPI_BAUDRATEPRESCALER_128,
+		SPI_BAUDRATEPRESCALER_64,  SPI_BAUDRATEPRESCALER_32,
+		SPI_BAUDRATEPRESCALER_16,  SPI_BAUDRATEPRESCALER_8,
+		SPI_BAUDRATEPRESCALER_4,   SPI_BAUDRATEPRESCALER_2
+	};
+	uint32_t best = 0;
+	uint8_t found = 0;
+
+	/* Save sync word at the known good boot clock */
+	uint8_t sync_word = rfm96_read_reg(REG_SYNC_WORD);
+
+	for(uint32_t i = 0; i < COUNTOF(prescalers); i++)
+	{
+		spi_set_prescaler(prescalers[i]);
+		if(spi_get_clock() > RFM96_SPI_MAX_CLOCK)
+		{
+			break;
+		}
+
+		if(!rfm96_spi_check())
+		{
+			break;
+		}
+
+		best = prescalers[i];
+		found = 1;
+	}
+
+	/* Settle on the fastest passing clock, or fall back to the slowest */
+	spi_set_prescaler(found ? best : SPI_BAUDRATEPRESCALER_256);
+	rfm96_write_reg(REG_SYNC_WORD, sync_word);
+
+	return found ? spi_get_clock() : 0;
+}
+
 /* 
  * brief   : wrapper for SPI write access of one byte to radio chip 
  * address : rfm96 register to write to
@@ -95,16 +316,56 @@ void rfm96_spi_disable(void)
 void rfm96_write_reg(uint8_t address, uint8_t value)
 {
 	rfm96_single_transfer(address | WNR_WRITE_ACCESS, value);
+	rfm96_cache_update(address, value);
 }
 
 /* 
- * brief   : wrapper for SPI read access of one byte to radio chip
+ * brief   : wrapper for SPI read access of one byte to radio chip, always 
+ *           goes to the bus and refreshes the shadow register
  * address : rfm96 register to read from 
  * retval  : the read value  
  */
 uint8_t rfm96_read_reg(uint8_t address)
 {
-  return rfm96_single_transfer(address & WNR_READ_ACCESS, 0x00);
+	uint8_t value = rfm96_single_transfer(address & WNR_READ_ACCESS, 0x00);
+	rfm96_cache_update(address, value);
+	return value;
+}
+
+/* 
+ * brief   : writes a register only if the shadow cache shows a different value
+ * address : rfm96 register to write to
+ * value   : byte value to write to register 
+ * retval  : 1 if the register was written, else 0
+ */
+uint8_t rfm96_write_reg_if_changed(uint8_t address, uint8_t value)
+{
+	if(rfm96_read_reg_cached(address) == value)
+	{
+		return 0;
+	}
+
+	rfm96_write_reg(address, value);
+	return 1;
+}
+
+/* 
+ * brief   : reads a register from the shadow cache, only going to the bus 
+ *           if the shadow is not valid. Use for registers only the driver 
+ *           changes, such as the configuration registers
+ * address : rfm96 register to read from 
+ * retval  : the register value  
+ */
+uint8_t rfm96_read_reg_cached(uint8_t address)
+{
+	if(address < RFM96_NUM_REGS && (reg_valid[address / 32] & (1UL << (address % 32))))
+	{
+		cache_stats.hits++;
+		return reg_shadow[address];
+	}
+
+	cache_stats.misses++;
+	return rfm96_read_reg(address);
 }
 
 /* 
@@ -117,6 +378,7 @@ uint8_t rfm96_single_transfer(uint8_t address, uint8_t value)
 	uint8_t response;
 
 	/* Enable radio chip */
+	rfm96_dio0_lock();
   	rfm96_spi_enable();
 
   	/* Transfer address byte, then exchange data in duplex mode */
@@ -125,10 +387,229 @@ uint8_t rfm96_single_transfer(uint8_t address, uint8_t value)
 
 	/* Disable radio chip */
   	rfm96_spi_disable();
+	rfm96_dio0_unlock();
 	
 	return response;
 }
 
+/* 
+ * brief   : writes a block of bytes to consecutive (or FIFO) register 
+ *           addresses in a single SPI transaction, NSS is held low throughout
+ * address : rfm96 register to start writing at
+ * data    : pointer to first byte to write
+ * size    : number of bytes to write
+ */
+void rfm96_burst_write(uint8_t address, const uint8_t* data, size_t size)
+{
+	address |= WNR_WRITE_ACCESS;
+
+	/* Enable radio chip */
+	rfm96_dio0_lock();
+	rfm96_spi_enable();
+
+	/* Transfer address byte once, then stream the data bytes */
+	spi_transmit(&address, 1);
+	spi_transmit((uint8_t*)data, size);
+
+	/* Disable radio chip */
+	rfm96_spi_disable();
+	rfm96_dio0_unlock();
+}
+
+/* 
+ * brief   : reads a block of bytes from consecutive (or FIFO) register 
+ *           addresses in a single SPI transaction, NSS is held low throughout
+ * address : rfm96 register to start reading from
+ * data    : pointer to buffer receiving the bytes
+ * size    : number of bytes to read
+ */
+void rfm96_burst_read(uint8_t address, uint8_t* data, size_t size)
+{
+	address &= WNR_READ_ACCESS;
+
+	/* Enable radio chip */
+	rfm96_dio0_lock();
+	rfm96_spi_enable();
+
+	/* Transfer address byte once, then clock in the data bytes */
+	spi_transmit(&address, 1);
+	spi_receive(data, size);
+
+	/* Disable radio chip */
+	rfm96_spi_disable();
+	rfm96_dio0_unlock();
+}
+
+/* 
+ * brief : writes a block of bytes to the radio chip FIFO buffer, starting at 
+ *         the current FIFO address pointer 
+ */
+void rfm96_write_fifo(const uint8_t* data, size_t size)
+{
+	rfm96_burst_write(REG_FIFO, data, size);
+}
+
+/* 
+ * brief : reads a block of bytes from the radio chip FIFO buffer, starting at 
+ *         the current FIFO address pointer 
+ */
+void rfm96_read_fifo(uint8_t* data, size_t size)
+{
+	rfm96_burst_read(REG_FIFO, data, size);
+}
+
+/* Shadow register cache functions -------------------------------------------*/
+/*
+ * brief   : checks if a register only changes when written by the driver. 
+ *           Status, FIFO and packet registers are never cached 
+ */
+static uint8_t rfm96_reg_cacheable(uint8_t address)
+{
+	switch(address)
+	{
+		case REG_OP_MODE:
+		case REG_FRF_MSB:
+		case REG_FRF_MID:
+		case REG_FRF_LSB:
+		case REG_PA_CONFIG:
+		case REG_LNA:
+		case REG_FIFO_TX_BASE_ADDR:
+		case REG_FIFO_RX_BASE_ADDR:
+		case REG_MODEM_CONFIG_1:
+		case REG_MODEM_CONFIG_2:
+		case REG_PREAMBLE_MSB:
+		case REG_PREAMBLE_LSB:
+		case REG_PAYLOAD_LENGTH:
+		case REG_MODEM_CONFIG_3:
+		case REG_DETECTION_OPTIMIZE:
+		case REG_DETECTION_THRESHOLD:
+		case REG_SYNC_WORD:
+		case REG_DIO_MAPPING_1:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+/*
+ * brief : marks all shadow registers invalid, call after the radio chip has 
+ *         been reset or put to sleep 
+ */
+void rfm96_cache_invalidate(void)
+{
+	memset(reg_valid, 0, sizeof(reg_valid));
+}
+
+/*
+ * brief   : records a known register value in the shadow cache, also used 
+ *           when the radio chip changes a register on its own, such as the 
+ *           op mode falling back to standby after TX done
+ * address : rfm96 register
+ * value   : the register's current value
+ */
+void rfm96_cache_update(uint8_t address, uint8_t value)
+{
+	if(rfm96_reg_cacheable(address))
+	{
+		reg_shadow[address] = value;
+		reg_valid[address / 32] |= (1UL << (address % 32));
+	}
+}
+
+/*
+ * brief : copies the cache hit and miss counters 
+ */
+void rfm96_cache_get_stats(struct rfm96_cache_stats* stats)
+{
+	*stats = cache_stats;
+}
+
+/*
+ * brief : clears the cache hit and miss counters 
+ */
+void rfm96_cache_reset_stats(void)
+{
+	cache_stats.hits = 0;
+	cache_stats.misses = 0;
+}
+
+/* Interrupt functions -------------------------------------------------------*/
+/*
+ *  brief   : selects which radio event is routed to the DIO0 pin
+ *  mapping : DIO0_RX_DONE or DIO0_TX_DONE
+ */
+void rfm96_dio0_map(uint8_t mapping)
+{
+	if(mapping == dio0_mapping)
+	{
+		return;
+	}
+
+	uint8_t reg_val = rfm96_read_reg_cached(REG_DIO_MAPPING_1);
+	reg_val = (reg_val & ~DIO0_MAPPING_MASK) | mapping;
+	rfm96_write_reg(REG_DIO_MAPPING_1, reg_val);
+	dio0_mapping = mapping;
+}
+
+/*
+ *  brief : DIO0 rising edge handler, called from EXTI interrupt context. 
+ *          TX done is only recorded. RX done drains the FIFO over SPI and 
+ *          calls rfm96_rx_callback from here, which is why SPI use in main 
+ *          context is made with this interrupt masked
+ */
+void rfm96_dio0_irq_handler(void)
+{
+	if(dio0_mapping == DIO0_TX_DONE)
+	{
+		rfm96_events |= RFM96_EVENT_TX_DONE;
+	}
+	else
+	{
+		rfm96_rx_drain();
+	}
+}
+
+/*
+ *  brief : keeps the DIO0 interrupt out of a main context SPI transaction or
+ *          register sequence, so its FIFO drain can not split one. Nests, 
+ *          and is balanced within the interrupt itself
+ */
+static void rfm96_dio0_lock(void)
+{
+	HAL_NVIC_DisableIRQ(RFM96_DIO0_EXTI_IRQn);
+	dio0_lock_depth++;
+}
+
+/*
+ *  brief : undoes rfm96_dio0_lock, an edge seen meanwhile stays pending in 
+ *          the EXTI and is taken when the outermost lock is released
+ */
+static void rfm96_dio0_unlock(void)
+{
+	if(--dio0_lock_depth == 0)
+	{
+		HAL_NVIC_EnableIRQ(RFM96_DIO0_EXTI_IRQn);
+	}
+}
+
+/*
+ *  brief  : atomically fetches and clears pending radio events
+ *  mask   : RFM96_EVENT_* bits to take
+ *  retval : the requested events that were pending
+ */
+uint8_t rfm96_take_events(uint8_t mask)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint8_t events;
+
+	__disable_irq();
+	events = rfm96_events & mask;
+	rfm96_events &= ~mask;
+	__set_PRIMASK(primask);
+
+	return events;
+}
+
 /* RFM96 mode selection functions --------------------------------------------*/
 /*
  *  brief : wrapper function, sets radio chip in standby mode
@@ -143,6 +624,7 @@ void rfm96_standby_mode(void)
  */
 void rfm96_sleep_mode(void)
 {
+	rfm96_cache_invalidate();
 	rfm96_write_reg(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_SLEEP);
 }
 
@@ -152,7 +634,7 @@ void rfm96_sleep_mode(void)
  */
 void rfm96_continous_tx(void)
 {
-	rfm96_write_reg(REG_MODEM_CONFIG_2, rfm96_read_reg(REG_MODEM_CONFIG_2)|0x8);
+	rfm96_write_reg(REG_MODEM_CONFIG_2, rfm96_read_reg_cached(REG_MODEM_CONFIG_2)|0x8);
 }
 /* Packet transmission functions ---------------------------------------------*/ 
 /*
@@ -174,7 +656,7 @@ void rfm96_begin_packet(void)
 size_t rfm96_write_packet(const uint8_t *payload, size_t size)
 {
 	/* Get current payload size */
-	int current_length = rfm96_read_reg(REG_PAYLOAD_LENGTH);
+	int current_length = rfm96_read_reg_cached(REG_PAYLOAD_LENGTH);
 	
 	/* Check if new data would overflow FIFO buffer */
 	if ((current_length + size) > MAX_PKT_LENGTH) 
@@ -182,10 +664,10 @@ size_t rfm96_write_packet(const uint8_t *payload, size_t size)
 		size = MAX_PKT_LENGTH - current_length;
 	}
 	
-	/* Write payload data to FIFO buffer */
-	for (size_t i = 0; i < size; i++) 
+	/* Write payload data to FIFO buffer in one burst */
+	if (size > 0)
 	{
-		rfm96_write_reg(REG_FIFO, payload[i]);
+		rfm96_write_fifo(payload, size);
 	}
 	
 	/* Update playload length register in radio chip */
@@ -195,59 +677,342 @@ size_t rfm96_write_packet(const uint8_t *payload, size_t size)
 }
 
 /*
- *  brief : sends packet by setting radio chip in transmission mode 
+ *  brief : starts transmission of the FIFO contents, TX done is signalled 
+ *          through DIO0 
  */
-void rfm96_send_packet(void)
+static void rfm96_start_tx(void)
 {
+	/* Route TX done to DIO0 and drop any stale event */
+	rfm96_dio0_map(DIO0_TX_DONE);
+	rfm96_take_events(RFM96_EVENT_TX_DONE);
+
 	/* Put radio chip in transmission mode */
 	rfm96_write_reg(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_TX);
+}
+
+/*
+ *  brief : sends packet by setting radio chip in transmission mode 
+ */
+void rfm96_send_packet(void)
+{
+	rfm96_start_tx();
 	
-	/* Wait for tranmission to complete */
-	while ((rfm96_read_reg(REG_IRQ_FLAGS) & IRQ_TX_DONE_MASK) == 0) 
+	/* Stop until DIO0 signals that transmission is complete */
+	while (rfm96_take_events(RFM96_EVENT_TX_DONE) == 0) 
 	{
+		power_wait(POWER_WAIT_FOREVER);
 	}
 	
 	/* Clear interrupt request flags */
 	rfm96_write_reg(REG_IRQ_FLAGS, IRQ_TX_DONE_MASK);
+
+	/* Radio chip returns to standby by itself after TX done */
+	rfm96_cache_update(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_STDBY);
 }
 
-/* Package receive functions -------------------------------------------------*/
 /*
- *  brief   : receives package from RFM96 if available, else turns on RX mode
- *  rx_buff : pointer to buffer to receive data, caller is responsible for 
- *            allocaing enough data for the buffer! Max payload is 255 bytes
- *  retval  : length of received package in byte, 0 if no package arrived
+ *  brief  : queues a packet for transmission without blocking. The packet is
+ *           copied, so buf may be reused as soon as this returns. Progress 
+ *           is made by calling rfm96_tx_process from the main loop
+ *  buf    : payload to send
+ *  size   : payload size in bytes, truncated to MAX_PKT_LENGTH
+ *  cb     : called with RFM96_TX_OK or RFM96_TX_TIMEOUT when done, may be 0.
+ *           The timeout is the time on air plus RFM96_TX_TIMEOUT_MARGIN
+ *  retval : 1 if the packet was accepted, 0 if a transmission is in progress
  */
-uint8_t rfm96_receive_package(uint8_t* rx_buff)
+uint8_t rfm96_send_async(const uint8_t* buf, size_t size, rfm96_tx_callback cb)
 {
-	/* Setup variables  */
-	uint8_t packet_length = 0;
-	uint8_t irq_flags = rfm96_read_reg(REG_IRQ_FLAGS);
+	if(tx_state != TX_IDLE)
+	{
+		return 0;
+	}
+
+	if(size > MAX_PKT_LENGTH)
+	{
+		size = MAX_PKT_LENGTH;
+	}
+
+	memcpy(tx_buff, buf, size);
+	tx_size = size;
+	tx_cb = cb;
+	tx_state = TX_BEGIN;
+
+	return 1;
+}
 
-	/* Clear IRQ's */
-	rfm96_write_reg(REG_IRQ_FLAGS, irq_flags);
+/*
+ *  brief : advances the asynchronous transmission one step, 
+ *          call this repeatedly from the main loop 
+ */
+void rfm96_tx_process(void)
+{
+	uint8_t status;
 
-	/* Check if a package has arrived */
-	if((irq_flags & IRQ_RX_DONE_MASK) && (irq_flags & IRQ_PAYLOAD_CRC_ERROR_MASK) == 0)
+	switch(tx_state)
 	{
-		/* Read payload length from package header */
+		case TX_BEGIN:
+			rfm96_begin_packet();
+			tx_state = TX_WRITE;
+			break;
+
+		case TX_WRITE:
+			rfm96_write_packet(tx_buff, tx_size);
+			tx_state = TX_SEND;
+			break;
+
+		case TX_SEND:
+			rfm96_start_tx();
+			tx_timed_out = 0;
+			timer_start(&tx_timeout_timer, 
+				rfm96_time_on_air(&active_profile, tx_size) / 1000 + RFM96_TX_TIMEOUT_MARGIN, 0);
+			tx_state = TX_WAIT_DONE;
+			break;
+
+		case TX_WAIT_DONE:
+			if(rfm96_take_events(RFM96_EVENT_TX_DONE))
+			{
+				/* Clear interrupt request flags */
+				rfm96_write_reg(REG_IRQ_FLAGS, IRQ_TX_DONE_MASK);
+				rfm96_cache_update(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_STDBY);
+				timer_stop(&tx_timeout_timer);
+				status = RFM96_TX_OK;
+			}
+			else if(tx_timed_out)
+			{
+				/* Abort transmission */
+				rfm96_standby_mode();
+				status = RFM96_TX_TIMEOUT;
+			}
+			else
+			{
+				break;
+			}
+
+			/* Go idle before the callback so it may queue the next packet */
+			tx_state = TX_IDLE;
+			if(tx_cb)
+			{
+				tx_cb(status);
+			}
+			break;
+
+		case TX_IDLE:
+		default:
+			break;
+	}
+}
+
+/*
+ *  brief  : checks if an asynchronous transmission is in progress
+ *  retval : 1 if busy, 0 if a new packet can be queued
+ */
+uint8_t rfm96_tx_busy(void)
+{
+	return tx_state != TX_IDLE;
+}
+
+/*
+ *  brief  : checks if rfm96_tx_process has a step to take now, otherwise the
+ *           main loop may sleep until the DIO0 interrupt or the timeout timer
+ *  retval : 1 if rfm96_tx_process should be called again without waiting
+ */
+uint8_t rfm96_tx_step_due(void)
+{
+	return tx_state == TX_BEGIN || tx_state == TX_WRITE || tx_state == TX_SEND;
+}
+
+/*
+ *  brief : transmit timeout timer callback, rfm96_tx_process aborts the 
+ *          transmission on its next call, which the radio event asks for
+ */
+static void rfm96_tx_expired(void* arg)
+{
+	(void)arg;
+
+	tx_timed_out = 1;
+	sched_publish(SCHED_EVENT_RADIO);
+}
+
+/* Package receive functions -------------------------------------------------*/
+/*
+ *  brief : moves the packets signalled on DIO0 from the radio FIFO into the 
+ *          receive queue, called from the DIO0 interrupt while the radio 
+ *          keeps listening
+ */
+static void rfm96_rx_drain(void)
+{
+	uint8_t irq_flags;
+	uint8_t current_addr;
+	uint8_t packet_length;
+
+	irq_flags = rfm96_read_reg(REG_IRQ_FLAGS);
+	while(irq_flags & IRQ_RX_DONE_MASK)
+	{
+		current_addr = rfm96_read_reg(REG_FIFO_RX_CURRENT_ADDR);
 		packet_length = rfm96_read_reg(REG_RX_NB_BYTES);
 
-		/* Set FIFO buffer pointer to current RX address */
-		rfm96_write_reg(REG_FIFO_ADDR_PTR, rfm96_read_reg(REG_FIFO_RX_CURRENT_ADDR));
+		/* Packets are stored back to back in the FIFO. A gap before this 
+		 * one holds a packet whose flag was cleared along with the last, 
+		 * its length, CRC status and signal quality are gone with it */
+		if(current_addr != rx_next_addr)
+		{
+			rx_stats.fifo_overruns++;
+		}
+		rx_next_addr = (uint8_t)(current_addr + packet_length);
 
-		/* Rx done, return radio chip to standby mode */
-		rfm96_standby_mode();
+		if(irq_flags & IRQ_PAYLOAD_CRC_ERROR_MASK)
+		{
+			rx_stats.crc_errors++;
+		}
+		else
+		{
+			rfm96_rx_read_packet(current_addr, packet_length);
+		}
+
+		/* Clear IRQ's, then look again. A packet that landed meanwhile is 
+		 * read now with its own registers, without waiting for an edge */
+		rfm96_write_reg(REG_IRQ_FLAGS, irq_flags);
+		irq_flags = rfm96_read_reg(REG_IRQ_FLAGS);
+	}
+}
+
+/*
+ *  brief  : queues the packet at a FIFO address, with the signal quality 
+ *           the radio holds for the newest packet
+ *  addr   : FIFO address of the first payload byte
+ *  length : payload bytes
+ */
+static void rfm96_rx_read_packet(uint8_t addr, uint8_t length)
+{
+	struct pkt_desc* packet;
+
+	packet = pkt_queue_reserve(&rx_queue);
+	if(packet == 0)
+	{
+		rx_stats.queue_drops++;
+		return;
 	}
-	/* If not already in receive mode, switch to it if no package's arrived */ 
-	else if(rfm96_read_reg(REG_OP_MODE) != (MODE_LONG_RANGE_MODE | MODE_RX_SINGLE))
+
+	/* Read out the payload, the FIFO address pointer wraps at 256 
+	 * bytes the same way the radio wrote it */
+	rfm96_write_reg(REG_FIFO_ADDR_PTR, addr);
+	rfm96_read_fifo(packet->payload, length);
+	packet->length = length;
+	packet->rssi = rfm96_packet_rssi();
+	packet->snr = rfm96_packet_snr();
+	packet->freq_error = rfm96_packet_frequency_error();
+	packet->tick = HAL_GetTick();
+	pkt_queue_commit(&rx_queue);
+	rx_stats.packets++;
+	rfm96_rx_callback();
+}
+
+/*
+ *  brief : called from the DIO0 interrupt after a packet has been queued. 
+ *          Does nothing, the application may override it
+ */
+__weak void rfm96_rx_callback(void)
+{
+}
+
+/*
+ *  brief : puts the radio in continuous receive and keeps it there, checking
+ *          the mode every RFM96_RX_MODE_CHECK_TIME ms from the timer wheel. 
+ *          Packets are queued by the DIO0 interrupt and taken from the queue
+ *          returned by rfm96_rx_queue
+ */
+void rfm96_rx_start(void)
+{
+	timer_start(&rx_check_timer, 0, RFM96_RX_MODE_CHECK_TIME);
+}
+
+/*
+ *  brief : receive mode check timer callback, rearms the receiver if the 
+ *          radio has left continuous receive, as it does on transmit
+ */
+static void rfm96_rx_check(void* arg)
+{
+	(void)arg;
+
+	/* The DIO0 interrupt uses the FIFO addresses, keep it out until the 
+	 * receiver is rearmed */
+	rfm96_dio0_lock();
+
+	if(rx_rearm || rfm96_read_reg(REG_OP_MODE) != (MODE_LONG_RANGE_MODE | MODE_RX_CONTINUOUS))
 	{
-		/* Reset the FIFO buffer address pointer */
-		rfm96_write_reg(REG_FIFO_ADDR_PTR, 0);
+		/* Route RX done to DIO0 */
+		rfm96_dio0_map(DIO0_RX_DONE);
+
+		/* The radio restarts writing packets at the RX base address */
+		rfm96_standby_mode();
+		rx_next_addr = rfm96_read_reg_cached(REG_FIFO_RX_BASE_ADDR);
+
+		/* Set radio chip to continuous receive mode */
+		rfm96_write_reg(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_RX_CONTINUOUS);
+		rx_rearm = 0;
+	}
+
+	rfm96_dio0_unlock();
+}
+
+/*
+ *  brief  : the queue received packets are delivered to, the main loop is
+ *           the only consumer
+ */
+struct pkt_queue* rfm96_rx_queue(void)
+{
+	return &rx_queue;
+}
+
+/*
+ *  brief : copies the receiver counters
+ *  stats : destination for the counters
+ */
+void rfm96_rx_get_stats(struct rfm96_rx_stats* stats)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	/* The counters are updated from the DIO0 interrupt */
+	__disable_irq();
+	*stats = rx_stats;
+	__set_PRIMASK(primask);
+}
+
+/*
+ *  brief  : RSSI of the last received packet
+ *  retval : dBm
+ */
+int16_t rfm96_packet_rssi(void)
+{
+	return RFM96_RSSI_OFFSET + rfm96_read_reg(REG_PKT_RSSI_VALUE);
+}
 
-		/* Set radio chip to single receive mode */
-		rfm96_write_reg(REG_OP_MODE, MODE_LONG_RANGE_MODE | MODE_RX_SINGLE);
-	}	
+/*
+ *  brief  : SNR of the last received packet, the register holds quarter dB
+ *  retval : dB
+ */
+int8_t rfm96_packet_snr(void)
+{
+	return (int8_t)rfm96_read_reg(REG_PKT_SNR_VALUE) / 4;
+}
+
+/*
+ *  brief  : frequency error of the last received packet, from the 20 bit 
+ *           signed estimate scaled by 2^24 / Fxtal * BW / 500 kHz
+ *  retval : Hz, positive if the transmitter is above our frequency
+ */
+int32_t rfm96_packet_frequency_error(void)
+{
+	uint8_t buf[3];
+	int32_t raw;
+
+	rfm96_burst_read(REG_FREQ_ERROR_MSB, buf, sizeof(buf));
+	raw = ((int32_t)(buf[0] & 0x0F) << 16) | ((int32_t)buf[1] << 8) | buf[2];
+	if(raw & 0x80000)
+	{
+		raw -= 0x100000;
+	}
 
-	return packet_length;
+	return (int32_t)((int64_t)raw * (1 << 24) * rfm96_bandwidth_hz(active_profile.bandwidth)
+		/ ((int64_t)RFM96_XTAL_FREQ * 500000));
 }
\ No newline at end of file
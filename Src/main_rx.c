@@ -9,16 +9,132 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h" 
 
+/* Private defines -----------------------------------------------------------*/
+#define RX_EVENT_MORE          (1UL << 0)  // packages left in the queue
+#define UI_EVENT_RX_DONE       (1UL << 0)  // the chosen number was received
+#define LOG_EVENT_FLUSH        (1UL << 0)  // a batch of log records is buffered
+
+/* Private types -------------------------------------------------------------*/
+enum rx_task_id
+{
+	RX_TASK,                   // highest priority, keeps the queue drained
+	UI_TASK,
+#if RTOS_PORT
+	STATS_TASK,
+	LCD_TASK,
+#endif
+	LOG_TASK,                  // lowest priority, EEPROM writes wait for idle
+	RX_TASK_COUNT
+};
+
+enum ui_state
+{
+	UI_MENU,                   // choosing the number of packages
+	UI_RECEIVING,
+	UI_RESULTS
+};
+
+enum result_page
+{
+	RESULT_LASTID,
+	RESULT_PDR,
+	RESULT_LOST,
+	RESULT_DUPS,
+	RESULT_MAXGAP,
+	RESULT_BURST,              // one item per burst length range
+	RESULT_RXLOST,
+	RESULT_SHORT,
+	RESULT_TOA,
+	RESULT_WAKEUS,
+	RESULT_LATENCY,            // one item per task
+	RESULT_LOGMS,
+	RESULT_LOGDRP,
+	RESULT_RSSI_MEAN,
+	RESULT_RSSI_STD,
+	RESULT_SNR_MEAN,
+	RESULT_SNR_STD,
+	RESULT_RSSI_PERCENTILE,    // one item per percentile
+	RESULT_SNR_PERCENTILE,
+	RESULT_PAGE_COUNT
+};
+
+/* Private function prototypes -----------------------------------------------*/
+#if RTOS_PORT
+static void rx_packet(const struct pkt_desc* packet);
+static void rx_show(uint32_t packets);
+#else
+static void rx_task(uint32_t events);
+#endif
+static void rx_log(const struct pkt_desc* packet, uint16_t id);
+static void log_task(uint32_t events);
+static void ui_task(uint32_t events);
+static void ui_menu_event(enum button_event event);
+static void ui_receiving_event(enum button_event event);
+static void ui_results_event(enum button_event event);
+static void ui_start_rx(void);
+static void ui_finish_rx(void);
+static uint8_t rx_complete(void);
+static void display_live_view(void);
+static void next_expected_pkts(uint32_t* expected_pkts, enum button_event event);
+static void display_expected_pkts(uint32_t expected_pkts);
+static void next_result(void);
+static uint8_t result_items(enum result_page page);
+static void display_result(void);
+static uint32_t task_latency_us(uint8_t task);
+static void display_percentile(uint8_t* name, const struct histogram* hist, uint8_t item);
+static void display_burst(uint8_t bucket);
+#if TELEMETRY_STREAM
+static void telemetry_send(const struct telemetry_record* record);
+static void telemetry_dump_log(void);
+#endif
+#if STATS_BENCHMARK
+static void stats_benchmark(void);
+#endif
+#if LCD_FORMAT_BENCHMARK
+static void lcd_format_benchmark(void);
+#endif
+
 /* Private variables ---------------------------------------------------------*/
-static union two_byte_union package_id; 
-static uint16_t num_pkts;
-static int8_t rssi_list[MAX_EXPECTED_NUM_PACKAGES];
-static int8_t snr_list[MAX_EXPECTED_NUM_PACKAGES];
-static double rssi_mean;
-static double rssi_std;
-static double snr_mean;
-static double snr_std;
-static float pdr; // packet delivery rate 
+static uint16_t last_id; 
+static uint32_t num_pkts;
+static uint32_t short_pkts;        // too short to carry an ID, skipped
+static uint32_t expected_pkts = 10;
+static struct stats_acc rssi_stats;
+static struct stats_acc snr_stats;
+static uint32_t rssi_bins[HISTOGRAM_BINS(RSSI_HISTOGRAM_LOWEST, RSSI_HISTOGRAM_HIGHEST)];
+static uint32_t snr_bins[HISTOGRAM_BINS(SNR_HISTOGRAM_LOWEST, SNR_HISTOGRAM_HIGHEST)];
+static struct histogram rssi_hist;
+static struct histogram snr_hist;
+static uint8_t live_view;
+#if STATS_BENCHMARK
+static int8_t bench_samples[1000];
+#endif
+static struct seq_tracker seq_tracker;
+static struct rfm96_rx_stats rx_stats;
+static enum ui_state ui_state;
+static enum result_page result_page;
+static uint8_t result_item;
+static struct sched_task tasks[RX_TASK_COUNT] =
+{
+#if RTOS_PORT
+	PORT_TASK(RX_THREAD_RADIO, "RADIO"),
+	{ "UI", ui_task, SCHED_EVENT_BUTTON },
+	PORT_TASK(RX_THREAD_STATS, "STATS"),
+	PORT_TASK(RX_THREAD_LCD, "LCD"),
+#else
+	{ "RX", rx_task, SCHED_EVENT_RADIO },
+	{ "UI", ui_task, SCHED_EVENT_BUTTON },
+#endif
+	{ "LOG", log_task, 0 }
+};
+#if RTOS_PORT
+static struct rx_threads_config rx_config =
+{
+	0, RX_UNBOUNDED, &rssi_stats, &snr_stats, &rssi_hist, &snr_hist, 
+	&seq_tracker, rx_packet, rx_show
+};
+#endif
+static const uint8_t percents[] = {5, 50, 95};
 
 /* Function declarations -----------------------------------------------------*/
 /**
@@ -30,6 +146,12 @@ int main(void)
 {
 	/* Initialize mcu system, gpio and spi peripherals */
 	system_init();
+	lcd_ui_init();
+
+#if TELEMETRY_STREAM
+	/* Telemetry UART, takes over the blue LED pin */
+	uart_init();
+#endif
 
 	/* Initialize the RFM96 LoRa radio chip */
 	if(rfm96_init() == 0)
@@ -45,124 +167,848 @@ int main(void)
 		HAL_Delay(1000);
 	}
 
-	/* User selects number of expected packages*/
-	uint32_t ticks_held = 0;
-	uint32_t expected_pkts = 10;
-	lcd_display_str_delayed("CHOOSE", 500);
-	lcd_display_str_delayed("NUM", 500); 
-	lcd_display_str_delayed("PKTS", 600); 
-	while(ticks_held < BUTTON_HELD_LONG)
-	{
-		/* Display current mode */
-		lcd_display_int(expected_pkts);
-		/* Poll button */
-		ticks_held = wait_for_user_button_timed();
-		/* If short press, update mode */
-		if(ticks_held < BUTTON_HELD_LONG)
+	/* Restore the packet log, holding the button through boot clears it */
+	eeprom_log_init();
+	if(BSP_PB_GetState(BUTTON_USER) == 1)
+	{
+		eeprom_log_clear();
+		lcd_display_str_delayed("LOGCLR", 1000);
+	}
+	lcd_display_str_delayed("LOGGED", 500);
+	lcd_display_int_delayed(eeprom_log_count(), 1000);
+
+#if TELEMETRY_STREAM
+	/* Send the stored log to the host before this session adds to it */
+	telemetry_dump_log();
+#endif
+
+	/* Find the fastest reliable SPI clock and report it in kHz */
+	lcd_display_str_delayed("SPIKHZ", 500);
+	lcd_display_int_delayed(rfm96_spi_speed_test() / 1000, 1000);
+
+#if STATS_BENCHMARK
+	/* Compare the batch statistics backends */
+	stats_benchmark();
+#endif
+
+#if LCD_FORMAT_BENCHMARK
+	/* Compare sprintf with the fixed point formatter */
+	lcd_format_benchmark();
+#endif
+
+	/* User selects number of expected packages, short pushes step forward 
+	 * through the modes, double pushes back and a long push confirms. From
+	 * here on the receiver runs as tasks, woken by the radio and the button */
+	lcd_ui_show_scroll("CHOOSE NUM PKTS", 200, 1);
+	display_expected_pkts(expected_pkts);
+	button_clear();
+	ui_state = UI_MENU;
+	sched_init(tasks, RX_TASK_COUNT);
+	sched_run();
+}
+
+#if RTOS_PORT
+/**
+	* @brief  Radio thread hook, logs a package before it leaves the queue
+	* @param  packet: the package, the radio thread skips those without an ID
+	* @retval None
+	*/
+static void rx_packet(const struct pkt_desc* packet)
+{
+	last_id = packet->payload[0] | (packet->payload[1] << 8);
+	rx_log(packet, last_id);
+}
+
+/**
+	* @brief  Lcd thread hook, shows the live view and ends the run once the 
+	*         chosen number of packages has gone through the statistics
+	* @param  packets: packages counted by the stats thread
+	* @retval None
+	*/
+static void rx_show(uint32_t packets)
+{
+	num_pkts = packets;
+	display_live_view();
+	if(rx_complete())
+	{
+		sched_signal(UI_TASK, UI_EVENT_RX_DONE);
+	}
+}
+
+/**
+	* @brief  Radio interrupt hook, wakes the radio thread
+	* @param  None
+	* @retval None
+	*/
+void rfm96_rx_callback(void)
+{
+	rx_threads_radio_irq();
+}
+#else
+/**
+	* @brief  Receive task, takes one package per run from the queue filled by
+	*         the DIO0 interrupt and signals itself while more are left
+	* @param  events: RX_EVENT_MORE and SCHED_EVENT_RADIO flags
+	* @retval None
+	*/
+static void rx_task(uint32_t events)
+{
+	struct pkt_queue* rx_queue = rfm96_rx_queue();
+	const struct pkt_desc* packet;
+
+	if(ui_state != UI_RECEIVING || rx_complete())
+	{
+		return;
+	}
+
+	/* Extract payload if a package is queued */
+	packet = pkt_queue_peek(rx_queue);
+	if(packet == 0)
+	{
+		return;
+	}
+
+	/* A package too short to carry an ID is counted and skipped */
+	if(packet->length < sizeof(last_id))
+	{
+		short_pkts++;
+		pkt_queue_release(rx_queue);
+		if(pkt_queue_peek(rx_queue) != 0)
+		{
+			sched_signal(RX_TASK, RX_EVENT_MORE);
+		}
+		return;
+	}
+
+	/* Extract little endian package ID from payload */
+	last_id = packet->payload[0] | (packet->payload[1] << 8);
+	seq_tracker_add(&seq_tracker, last_id);
+
+	/* Increment received package counter */
+	num_pkts++;
+
+	/* Update running RSSI and SNR statistics */
+	stats_add(&rssi_stats, packet->rssi);
+	stats_add(&snr_stats, packet->snr);
+	histogram_add(&rssi_hist, packet->rssi);
+	histogram_add(&snr_hist, packet->snr);
+
+	rx_log(packet, last_id);
+	pkt_queue_release(rx_queue);
+
+	/* Display the package count or a running statistic */
+	display_live_view();
+
+	if(rx_complete())
+	{
+		sched_signal(UI_TASK, UI_EVENT_RX_DONE);
+	}
+	else if(pkt_queue_peek(rx_queue) != 0)
+	{
+		sched_signal(RX_TASK, RX_EVENT_MORE);
+	}
+}
+#endif
+
+/**
+	* @brief  Buffers a package for the EEPROM log, waking the log task once 
+	*         a batch is full, and streams it as telemetry
+	* @param  packet: the package, still in the receive queue
+	* @param  id: package ID read from the payload by the caller
+	* @retval None
+	*/
+static void rx_log(const struct pkt_desc* packet, uint16_t id)
+{
+	struct eeprom_log_record record;
+#if TELEMETRY_STREAM
+	struct telemetry_record telemetry;
+#endif
+
+	/* Log the package, saturating the frequency error to 16 bits */
+	record.tick = packet->tick;
+	record.freq_error = packet->freq_error > INT16_MAX ? INT16_MAX :
+		packet->freq_error < INT16_MIN ? INT16_MIN : (int16_t)packet->freq_error;
+	record.seq = id;
+	record.rssi = packet->rssi;
+	record.snr = packet->snr;
+
+	/* A full buffer drops the record, the log counts it. Wake the log task 
+	 * again in case it has not been signalled since the batch filled */
+	if(eeprom_log_append(&record) != HAL_OK || eeprom_log_batch_ready())
+	{
+		sched_signal(LOG_TASK, LOG_EVENT_FLUSH);
+	}
+
+#if TELEMETRY_STREAM
+	telemetry.type = TELEMETRY_PACKET;
+	telemetry.session = eeprom_log_session();
+	telemetry.seq = id;
+	telemetry.tick = packet->tick;
+	telemetry.freq_error = packet->freq_error;
+	telemetry.rssi = packet->rssi;
+	telemetry.snr = packet->snr;
+	telemetry_send(&telemetry);
+#endif
+}
+
+/**
+	* @brief  Log task, writes the buffered records to the EEPROM. Running 
+	*         last keeps the write stall out of the receive path, packages 
+	*         arriving meanwhile wait in the receive queue
+	* @param  events: LOG_EVENT_FLUSH flag
+	* @retval None
+	*/
+static void log_task(uint32_t events)
+{
+	(void)events;
+
+	/* Records lost to a full log are counted there and shown as LOGDRP */
+	eeprom_log_flush();
+}
+
+/**
+	* @brief  User interface task, handles the button events of the current 
+	*         screen and the end of a receive run
+	* @param  events: UI_EVENT_RX_DONE and SCHED_EVENT_BUTTON flags
+	* @retval None
+	*/
+static void ui_task(uint32_t events)
+{
+	enum button_event event;
+
+	if((events & UI_EVENT_RX_DONE) && ui_state == UI_RECEIVING)
+	{
+		ui_finish_rx();
+		return;
+	}
+
+	while((event = button_get_event()) != BUTTON_NONE)
+	{
+		switch(ui_state)
 		{
-			expected_pkts *= 10; // modes are 10, 100, 1000
-			if(expected_pkts > 1000) // mode after 1000 is 10 
-				expected_pkts = 10; 
+			case UI_MENU:
+				ui_menu_event(event);
+				break;
+
+			case UI_RECEIVING:
+				ui_receiving_event(event);
+				break;
+
+			default:
+				ui_results_event(event);
+				break;
 		}
 	}
-	lcd_display_str_delayed("YOU", 250);
-	lcd_display_str_delayed("CHOSE", 250);
-	lcd_display_int_delayed(expected_pkts, 500);
+}
+
+/**
+	* @brief  Steps the package count mode, a long push starts receiving
+	* @param  event: the button event
+	* @retval None
+	*/
+static void ui_menu_event(enum button_event event)
+{
+	if(event == BUTTON_LONG)
+	{
+		ui_start_rx();
+	}
+	else
+	{
+		next_expected_pkts(&expected_pkts, event);
+		lcd_ui_clear();
+		display_expected_pkts(expected_pkts);
+	}
+}
+
+/**
+	* @brief  Short pushes step through the live views, double pushes step 
+	*         back and long ones end the run
+	* @param  event: the button event
+	* @retval None
+	*/
+static void ui_receiving_event(enum button_event event)
+{
+	static const char* view_names[] = {"COUNT", "RSSI", "SNR", "PDR"};
+
+	if(event == BUTTON_LONG)
+	{
+		ui_finish_rx();
+	}
+	else
+	{
+		/* Name the new view briefly, the value follows */
+		live_view = (live_view + (event == BUTTON_DOUBLE ? 3 : 1)) % 4;
+		lcd_ui_clear();
+		lcd_ui_show_str((const uint8_t*)view_names[live_view], DISPLAY_DELAY);
+		display_live_view();
+	}
+}
+
+/**
+	* @brief  Any push shows the next result, screens still queued are 
+	*         skipped by it
+	* @param  event: the button event
+	* @retval None
+	*/
+static void ui_results_event(enum button_event event)
+{
+	lcd_ui_clear();
+	next_result();
+	display_result();
+
+	/* Pushes made while the screens were queued do not count */
+	button_clear();
+}
+
+/**
+	* @brief  Confirms the chosen number of packages and starts receiving
+	* @param  None
+	* @retval None
+	*/
+static void ui_start_rx(void)
+{
+	lcd_ui_clear();
+	lcd_ui_show_str("YOU", 250);
+	lcd_ui_show_str("CHOSE", 250);
+	if(expected_pkts == RX_UNBOUNDED)
+		lcd_ui_show_str("NOLIM", 500);
+	else
+		lcd_ui_show_int(expected_pkts, 500);
 
 	/* Signal start of receive mode, waiting for first packet */
-	lcd_display_str("RXWAIT");
-	
-	/* Set up variables */
-	uint8_t packet_length;
-	uint8_t packet_index;
-	uint8_t rx_buff[MAX_PKT_LENGTH];
-
-	/* Receive packages */
-	while(num_pkts < expected_pkts)
-	{	
-		/* Receive package if available, else set radio chip in RX mode */
-		packet_length = rfm96_receive_package(rx_buff);
-		
- 		/* Extract payload if package is ready */
-  		if(packet_length > 0)
-  		{
-			/* Read received package */
-  			while(rfm96_read_reg(REG_RX_NB_BYTES) - packet_index)
-  			{
-  				/* Read next received byte from FIFO */
-  				package_id.buffer[packet_index] = rfm96_read_reg(REG_FIFO);
-  				packet_index++;
-  			}
-
-  			/* Increment received package counter */
-  			num_pkts++;
-			
-			/* Read package RSSI and SNR */
-			rssi_list[num_pkts-1] = -137 + rfm96_read_reg(REG_PKT_RSSI_VALUE);
-			snr_list[num_pkts-1] = (int8_t)(rfm96_read_reg(REG_PKT_SNR_VALUE) * 0.25);
-
-			/* Display current number of received packages */
-			lcd_display_int(num_pkts);
-		
-			/* Reset package index */
-			packet_index = 0;
-  		}  		
-  	}
-
-  	/* Mean and standard deviation for RSSI */
-  	rssi_mean = mean(rssi_list, expected_pkts);
-  	rssi_std = std_dev(rssi_list, expected_pkts, rssi_mean);
-
-  	/* Mean and standard deviation for SNR */
-	snr_mean = mean(snr_list, expected_pkts);
-  	snr_std = std_dev(snr_list, expected_pkts, rssi_mean);
-  	
-  	/* Packet delivery rate */
-  	pdr = (double)expected_pkts / (double)package_id.num;
-
-  	/* Signal results ready to be displayed */
-  	BSP_LED_On(LED_GREEN);
-	lcd_display_str_delayed("RXDONE", DISPLAY_DELAY); 
-	wait_for_user_button();
-
-  	/* Show results on display */
-  	while(1)
-  	{
-  		/* Last Package ID*/
-		lcd_display_str_delayed("LASTID", DISPLAY_DELAY);
-		lcd_display_int(package_id.num); 
-  		wait_for_user_button();
-
-  		/* Payload Delivery Rate */
-		lcd_display_str_delayed("PDR", DISPLAY_DELAY);
-		lcd_display_percentage(pdr); 
-  		wait_for_user_button();
-
-  		/* Arithmetic mean for RSSI */
-		lcd_display_str_delayed("RSSI", DISPLAY_DELAY);
-		lcd_display_str_delayed("MEAN", DISPLAY_DELAY);
-		lcd_display_float(rssi_mean); 
-  		wait_for_user_button();
-
-  		/* Standard deviation for RSSI */
-		lcd_display_str_delayed("RSSI", DISPLAY_DELAY);
-		lcd_display_str_delayed("STD", DISPLAY_DELAY);
-		lcd_display_float(rssi_std);
-  		wait_for_user_button();
-
-  		/* Arithmetic mean SNR */
-		lcd_display_str_delayed("SNR", DISPLAY_DELAY);
-		lcd_display_str_delayed("MEAN", DISPLAY_DELAY);
-		lcd_display_float(snr_mean);
-  		wait_for_user_button();
-
-  		/* Standard deviation for SNR */
-		lcd_display_str_delayed("SNR", DISPLAY_DELAY);
-		lcd_display_str_delayed("STD", DISPLAY_DELAY);
-		lcd_display_float(snr_std);
-  		wait_for_user_button();
- 	}
+	lcd_ui_show_str("RXWAIT", LCD_UI_HOLD);
+
+	stats_reset(&rssi_stats);
+	stats_reset(&snr_stats);
+	histogram_init(&rssi_hist, rssi_bins, RSSI_HISTOGRAM_LOWEST, RSSI_HISTOGRAM_HIGHEST);
+	histogram_init(&snr_hist, snr_bins, SNR_HISTOGRAM_LOWEST, SNR_HISTOGRAM_HIGHEST);
+	seq_tracker_init(&seq_tracker);
+
+	/* Packages are queued by the DIO0 interrupt, which wakes the rx task, 
+	 * or the radio thread when the receive path runs as port threads */
+	ui_state = UI_RECEIVING;
+#if RTOS_PORT
+	rx_config.queue = rfm96_rx_queue();
+	rx_config.limit = expected_pkts;
+	port_init();
+	rx_threads_init(&rx_config);
+	port_start();
+#endif
+	rfm96_rx_start();
+}
+
+/**
+	* @brief  Ends the receive run and waits for a push to show the results
+	* @param  None
+	* @retval None
+	*/
+static void ui_finish_rx(void)
+{
+#if RTOS_PORT
+	rx_threads_stop();
+	short_pkts = rx_threads_short_packets();
+#endif
+
+	/* Gaps still in the sequence window are final now */
+	seq_tracker_flush(&seq_tracker);
+
+	/* Commit the last partial batch of the packet log */
+	eeprom_log_flush();
+
+	/* Receiver loss counters */
+	rfm96_rx_get_stats(&rx_stats);
+
+	/* Signal results ready to be displayed */
+	BSP_LED_On(LED_GREEN);
+	lcd_ui_clear();
+	lcd_ui_show_str("RXDONE", LCD_UI_HOLD);
+	ui_state = UI_RESULTS;
+	result_page = RESULT_PAGE_COUNT;
+	button_clear();
+}
+
+/**
+	* @brief  Tells if the chosen number of packages has been received
+	* @param  None
+	* @retval 1 if so, 0 if not or if the run has no limit
+	*/
+static uint8_t rx_complete(void)
+{
+	return expected_pkts != RX_UNBOUNDED && num_pkts >= expected_pkts;
+}
+
+/**
+	* @brief  Shows a package count mode on the display
+	* @param  expected_pkts: number of packages, or RX_UNBOUNDED
+	* @retval None
+	*/
+static void display_expected_pkts(uint32_t expected_pkts)
+{
+	if(expected_pkts == RX_UNBOUNDED)
+	{
+		lcd_ui_show_str("NOLIM", LCD_UI_HOLD);
+	}
+	else
+	{
+		lcd_ui_show_int(expected_pkts, LCD_UI_HOLD);
+	}
+}
+
+/**
+	* @brief  Steps the package count mode, modes are 10, 100, 1000 and 
+	*         unbounded
+	* @param  expected_pkts: the mode to step
+	* @param  event: BUTTON_SHORT steps forward, BUTTON_DOUBLE back
+	* @retval None
+	*/
+static void next_expected_pkts(uint32_t* expected_pkts, enum button_event event)
+{
+	if(event == BUTTON_DOUBLE)
+	{
+		if(*expected_pkts == RX_UNBOUNDED)
+			*expected_pkts = 1000;
+		else if(*expected_pkts == 10)
+			*expected_pkts = RX_UNBOUNDED;
+		else
+			*expected_pkts /= 10;
+	}
+	else
+	{
+		if(*expected_pkts == RX_UNBOUNDED)
+			*expected_pkts = 10;
+		else if(*expected_pkts == 1000)
+			*expected_pkts = RX_UNBOUNDED;
+		else
+			*expected_pkts *= 10;
+	}
+}
+
+/**
+	* @brief  Steps to the next result, wrapping around after the last. Empty 
+	*         burst length ranges are skipped
+	* @param  None
+	* @retval None
+	*/
+static void next_result(void)
+{
+	do
+	{
+		if(result_page == RESULT_PAGE_COUNT)
+		{
+			/* First push after RXDONE */
+			result_page = RESULT_LASTID;
+			result_item = 0;
+		}
+		else if(++result_item >= result_items(result_page))
+		{
+			result_page = (enum result_page)((result_page + 1) % RESULT_PAGE_COUNT);
+			result_item = 0;
+		}
+	}
+	while(result_page == RESULT_BURST && seq_tracker.bursts[result_item] == 0);
+}
+
+/**
+	* @brief  Number of results on a page
+	* @param  page: the page
+	* @retval Number of button pushes the page takes
+	*/
+static uint8_t result_items(enum result_page page)
+{
+	switch(page)
+	{
+		case RESULT_BURST:
+			return SEQ_TRACKER_BURST_BUCKETS;
+
+		case RESULT_LATENCY:
+			return RX_TASK_COUNT;
+
+		case RESULT_RSSI_PERCENTILE:
+		case RESULT_SNR_PERCENTILE:
+			return COUNTOF(percents);
+
+		default:
+			return 1;
+	}
+}
+
+/**
+	* @brief  Shows the current result, its name first and then the value 
+	*         until the next push
+	* @param  None
+	* @retval None
+	*/
+static void display_result(void)
+{
+	struct power_stats power_stats;
+
+	switch(result_page)
+	{
+		/* Last Package ID*/
+		case RESULT_LASTID:
+			lcd_ui_show_str("LASTID", DISPLAY_DELAY);
+			lcd_ui_show_int(last_id, LCD_UI_HOLD);
+			break;
+
+		/* Payload Delivery Rate */
+		case RESULT_PDR:
+			lcd_ui_show_str("PDR", DISPLAY_DELAY);
+			lcd_ui_show_percent(seq_tracker_pdr(&seq_tracker), LCD_UI_HOLD);
+			break;
+
+		/* Packages lost, duplicated and the longest run of losses */
+		case RESULT_LOST:
+			lcd_ui_show_str("LOST", DISPLAY_DELAY);
+			lcd_ui_show_int((int)seq_tracker_lost(&seq_tracker), LCD_UI_HOLD);
+			break;
+
+		case RESULT_DUPS:
+			lcd_ui_show_str("DUPS", DISPLAY_DELAY);
+			lcd_ui_show_int((int)seq_tracker.duplicates, LCD_UI_HOLD);
+			break;
+
+		case RESULT_MAXGAP:
+			lcd_ui_show_str("MAXGAP", DISPLAY_DELAY);
+			lcd_ui_show_int((int)seq_tracker_longest_outage(&seq_tracker), LCD_UI_HOLD);
+			break;
+
+		/* Distribution of loss burst lengths */
+		case RESULT_BURST:
+			display_burst(result_item);
+			break;
+
+		/* Packages lost in the radio FIFO or the receive queue */
+		case RESULT_RXLOST:
+			lcd_ui_show_str("RXLOST", DISPLAY_DELAY);
+			lcd_ui_show_int((int)(rx_stats.fifo_overruns + rx_stats.queue_drops), LCD_UI_HOLD);
+			break;
+
+		/* Packages skipped for being too short to carry an ID */
+		case RESULT_SHORT:
+			lcd_ui_show_str("SHORT", DISPLAY_DELAY);
+			lcd_ui_show_int((int)short_pkts, LCD_UI_HOLD);
+			break;
+
+		/* Time on air per package in ms */
+		case RESULT_TOA:
+			lcd_ui_show_str("TOA MS", DISPLAY_DELAY);
+			lcd_ui_show_int((rfm96_time_on_air(rfm96_get_profile(), sizeof(last_id)) + 500) / 1000, LCD_UI_HOLD);
+			break;
+
+		/* Worst wakeup from STOP mode until running at 32 MHz, in us */
+		case RESULT_WAKEUS:
+			power_get_stats(&power_stats);
+			lcd_ui_show_str("WAKEUS", DISPLAY_DELAY);
+			lcd_ui_show_int((int)power_stats.wake_us_max, LCD_UI_HOLD);
+			break;
+
+		/* Worst time from a task being signalled until it ran, in us */
+		case RESULT_LATENCY:
+			lcd_ui_show_str((const uint8_t*)tasks[result_item].name, DISPLAY_DELAY);
+			lcd_ui_show_str("LATUS", DISPLAY_DELAY);
+			lcd_ui_show_int((int)task_latency_us(result_item), LCD_UI_HOLD);
+			break;
+
+		/* Worst EEPROM log flush, the longest the receive path waits on it */
+		case RESULT_LOGMS:
+			lcd_ui_show_str("LOGMS", DISPLAY_DELAY);
+			lcd_ui_show_int((int)((tasks[LOG_TASK].max_run_us + 500) / 1000), LCD_UI_HOLD);
+			break;
+
+		/* Packages missing from the EEPROM log, buffer or log full */
+		case RESULT_LOGDRP:
+			lcd_ui_show_str("LOGDRP", DISPLAY_DELAY);
+			lcd_ui_show_int((int)eeprom_log_dropped(), LCD_UI_HOLD);
+			break;
+
+		/* Arithmetic mean and standard deviation for RSSI */
+		case RESULT_RSSI_MEAN:
+			lcd_ui_show_str("RSSI", DISPLAY_DELAY);
+			lcd_ui_show_str("MEAN", DISPLAY_DELAY);
+			lcd_ui_show_float(stats_mean(&rssi_stats), LCD_UI_HOLD);
+			break;
+
+		case RESULT_RSSI_STD:
+			lcd_ui_show_str("RSSI", DISPLAY_DELAY);
+			lcd_ui_show_str("STD", DISPLAY_DELAY);
+			lcd_ui_show_float(stats_std_dev(&rssi_stats), LCD_UI_HOLD);
+			break;
+
+		/* Arithmetic mean and standard deviation for SNR */
+		case RESULT_SNR_MEAN:
+			lcd_ui_show_str("SNR", DISPLAY_DELAY);
+			lcd_ui_show_str("MEAN", DISPLAY_DELAY);
+			lcd_ui_show_float(stats_mean(&snr_stats), LCD_UI_HOLD);
+			break;
+
+		case RESULT_SNR_STD:
+			lcd_ui_show_str("SNR", DISPLAY_DELAY);
+			lcd_ui_show_str("STD", DISPLAY_DELAY);
+			lcd_ui_show_float(stats_std_dev(&snr_stats), LCD_UI_HOLD);
+			break;
+
+		/* Fading tails */
+		case RESULT_RSSI_PERCENTILE:
+			display_percentile("RSSI", &rssi_hist, result_item);
+			break;
+
+		case RESULT_SNR_PERCENTILE:
+		default:
+			display_percentile("SNR", &snr_hist, result_item);
+			break;
+	}
+}
+
+/**
+	* @brief  Worst latency of a task. Port threads count from the interrupt 
+	*         or thread putting the message, so queueing is included
+	* @param  task: index into the task table
+	* @retval us
+	*/
+static uint32_t task_latency_us(uint8_t task)
+{
+#if RTOS_PORT
+	static const int8_t task_threads[RX_TASK_COUNT] = 
+	{
+		RX_THREAD_RADIO, -1, RX_THREAD_STATS, RX_THREAD_LCD, -1
+	};
+
+	if(task_threads[task] >= 0)
+	{
+		return port_thread_get(task_threads[task])->max_latency_us;
+	}
+#endif
+	return tasks[task].max_latency_us;
+}
+
+/**
+	* @brief  Shows the 5th, 50th or 95th percentile of a histogram
+	* @param  name: quantity shown before the percentile
+	* @param  hist: histogram to query
+	* @param  item: index into percents
+	* @retval None
+	*/
+static void display_percentile(uint8_t* name, const struct histogram* hist, uint8_t item)
+{
+	struct lcd_text label;
+
+	label.chars[0] = 'P';
+	lcd_format_append_int(percents[item], 1, &label);
+	lcd_ui_show_str(name, DISPLAY_DELAY);
+	lcd_ui_show_str(label.chars, DISPLAY_DELAY);
+	lcd_ui_show_int(histogram_percentile(hist, percents[item]), LCD_UI_HOLD);
+}
+
+/**
+	* @brief  Shows how many loss bursts of a length range occurred
+	* @param  bucket: the burst length range
+	* @retval None
+	*/
+static void display_burst(uint8_t bucket)
+{
+	struct lcd_text label;
+	uint16_t lower = seq_tracker_burst_lower(bucket);
+	uint16_t upper = seq_tracker_burst_lower(bucket + 1) - 1;
+	uint8_t end;
+
+	/* "33+" for the open ended range, "1" or "9-16" for the others */
+	end = lcd_format_append_int(lower, 0, &label);
+	if(bucket == SEQ_TRACKER_BURST_BUCKETS - 1)
+	{
+		label.chars[end++] = '+';
+		label.chars[end] = 0;
+	}
+	else if(lower != upper)
+	{
+		label.chars[end++] = '-';
+		lcd_format_append_int(upper, end, &label);
+	}
+
+	lcd_ui_show_str("BURST", DISPLAY_DELAY);
+	lcd_ui_show_str(label.chars, DISPLAY_DELAY);
+	lcd_ui_show_int((int32_t)seq_tracker.bursts[bucket], LCD_UI_HOLD);
+}
+
+/**
+	* @brief  Shows the selected live view while receiving: the package count,
+	*         the running RSSI mean, the running SNR mean or the running PDR
+	* @param  None
+	* @retval None
+	*/
+static void display_live_view(void)
+{
+	switch(live_view)
+	{
+		case 1:
+			lcd_ui_show_float(stats_mean(&rssi_stats), LCD_UI_HOLD);
+			break;
+
+		case 2:
+			lcd_ui_show_float(stats_mean(&snr_stats), LCD_UI_HOLD);
+			break;
+
+		case 3:
+			lcd_ui_show_percent(seq_tracker_pdr(&seq_tracker), LCD_UI_HOLD);
+			break;
+
+		default:
+			lcd_ui_show_int(num_pkts, LCD_UI_HOLD);
+			break;
+	}
+}
+#if TELEMETRY_STREAM
+/*
+ * brief : queues one telemetry frame on the UART
+ */
+static void telemetry_send(const struct telemetry_record* record)
+{
+	uint8_t frame[TELEMETRY_FRAME_MAX];
+	uart_write(frame, telemetry_encode(record, frame));
+}
+
+/*
+ * brief : sends every record in the EEPROM log, oldest first
+ */
+static void telemetry_dump_log(void)
+{
+	struct eeprom_log_record record;
+	struct telemetry_record telemetry;
+
+	telemetry.type = TELEMETRY_LOG;
+	for(uint16_t i = 0; eeprom_log_read(i, &record); i++)
+	{
+		telemetry.session = record.session;
+		telemetry.seq = record.seq;
+		telemetry.tick = record.tick;
+		telemetry.freq_error = record.freq_error;
+		telemetry.rssi = record.rssi;
+		telemetry.snr = record.snr;
+		telemetry_send(&telemetry);
+	}
+	uart_flush();
+}
+#endif
+
+#if STATS_BENCHMARK
+/**
+	* @brief  Measures the batch statistics backends with the DWT cycle counter
+	*         on 10, 100 and 1000 samples and shows the cycles per sample. 
+	*         Labels read D for double precision and Q for CMSIS-DSP fixed point
+	* @param  None
+	* @retval None
+	*/
+static void stats_benchmark(void)
+{
+	static const uint16_t sizes[] = {10, 100, 1000};
+	static const char* labels[][2] = 
+	{
+		{"D 10", "Q 10"}, {"D 100", "Q 100"}, {"D 1000", "Q 1000"}
+	};
+	struct stats_acc acc;
+	uint32_t seed = 1;
+	uint32_t start;
+	uint32_t cycles;
+
+	/* Link quality like samples from a fixed pseudo random sequence */
+	for(uint32_t i = 0; i < COUNTOF(bench_samples); i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		bench_samples[i] = -120 + (int8_t)((seed >> 16) % 60);
+	}
+
+	cycle_counter_init();
+	lcd_display_str_delayed("BENCH", DISPLAY_DELAY);
+	for(uint32_t i = 0; i < COUNTOF(sizes); i++)
+	{
+		start = cycle_counter_read();
+		stats_batch_double(&acc, bench_samples, sizes[i]);
+		cycles = cycle_counter_read() - start;
+		lcd_display_str_delayed((uint8_t*)labels[i][0], DISPLAY_DELAY);
+		lcd_display_int_delayed(cycles / sizes[i], DISPLAY_DELAY * 2);
+
+#if STATS_USE_CMSIS_DSP
+		start = cycle_counter_read();
+		stats_batch_cmsis(&acc, bench_samples, sizes[i]);
+		cycles = cycle_counter_read() - start;
+		lcd_display_str_delayed((uint8_t*)labels[i][1], DISPLAY_DELAY);
+		lcd_display_int_delayed(cycles / sizes[i], DISPLAY_DELAY * 2);
+#endif
+	}
+}
+#endif
+
+#if LCD_FORMAT_BENCHMARK
+/**
+	* @brief  Measures number formatting with the DWT cycle counter and shows
+	*         the cycles per value. Labels read S for the sprintf and modf 
+	*         conversion the display functions used before, F for lcd_format. 
+	*         Flash footprint is compared in the linker map file
+	* @param  None
+	* @retval None
+	*/
+static void lcd_format_benchmark(void)
+{
+	static const int32_t ints[] = {0, 7, -42, 100, 4095, -99999, 123456, 1000000};
+	static const float floats[] = {-85.3f, -120.456f, 7.25f, 0.5f, -3.0f, 99999.9f};
+	volatile uint32_t sink = 0;
+	struct lcd_text text;
+	uint8_t int_str[12];
+	uint8_t frac_str[12];
+	double fraction;
+	double integer;
+	uint32_t start;
+	uint32_t cycles;
+
+	cycle_counter_init();
+	lcd_display_str_delayed("BENCH", DISPLAY_DELAY);
+
+	/* Integers */
+	start = cycle_counter_read();
+	for(uint32_t i = 0; i < COUNTOF(ints); i++)
+	{
+		sprintf((char*)int_str, "%d", (int)ints[i]);
+		sink += int_str[0];
+	}
+	cycles = cycle_counter_read() - start;
+	lcd_display_str_delayed("S INT", DISPLAY_DELAY);
+	lcd_display_int_delayed(cycles / COUNTOF(ints), DISPLAY_DELAY * 2);
+
+	start = cycle_counter_read();
+	for(uint32_t i = 0; i < COUNTOF(ints); i++)
+	{
+		lcd_format_int(ints[i], &text);
+		sink += text.chars[0];
+	}
+	cycles = cycle_counter_read() - start;
+	lcd_display_str_delayed("F INT", DISPLAY_DELAY);
+	lcd_display_int_delayed(cycles / COUNTOF(ints), DISPLAY_DELAY * 2);
+
+	/* Floats */
+	start = cycle_counter_read();
+	for(uint32_t i = 0; i < COUNTOF(floats); i++)
+	{
+		fraction = modf(floats[i], &integer);
+		fraction = fraction < 0 ? -fraction : fraction;
+		sprintf((char*)int_str, "%g", integer);
+		fraction *= 1000;
+		sprintf((char*)frac_str, "%d", (int)fraction);
+		sink += int_str[0] + frac_str[0];
+	}
+	cycles = cycle_counter_read() - start;
+	lcd_display_str_delayed("S FLT", DISPLAY_DELAY);
+	lcd_display_int_delayed(cycles / COUNTOF(floats), DISPLAY_DELAY * 2);
+
+	start = cycle_counter_read();
+	for(uint32_t i = 0; i < COUNTOF(floats); i++)
+	{
+		lcd_format_float(floats[i], &text);
+		sink += text.chars[0];
+	}
+	cycles = cycle_counter_read() - start;
+	lcd_display_str_delayed("F FLT", DISPLAY_DELAY);
+	lcd_display_int_delayed(cycles / COUNTOF(floats), DISPLAY_DELAY * 2);
 }
+#endif
 
 /**
 	* @brief  Reports the name of the source file and the source line number
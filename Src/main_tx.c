@@ -9,8 +9,34 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h" 
 
+/* Private defines -----------------------------------------------------------*/
+#define TX_EVENT_DUE           (1UL << 0)  // pacing timer expired
+#define TX_EVENT_STEP          (1UL << 1)  // transmission has a step to take
+
+/* Private types -------------------------------------------------------------*/
+enum tx_task_id
+{
+	TX_TASK,
+	TX_TASK_COUNT
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void tx_task(uint32_t events);
+static void tx_done(uint8_t status);
+static void tx_due(void* arg);
+static void tx_send(void);
+
 /* Private variables ---------------------------------------------------------*/
 static union two_byte_union package_id;
+static uint32_t tx_timeouts;
+static uint32_t tx_interval;
+static struct timer tx_timer;
+static uint8_t tx_pending;
+static struct sched_task tasks[TX_TASK_COUNT] =
+{
+	{ "TX", tx_task, SCHED_EVENT_RADIO }
+};
+
 
 /* Function declarations -----------------------------------------------------*/
 /**
@@ -36,23 +62,104 @@ int main(void)
 		lcd_display_str("BOOTOK");
 		HAL_Delay(1000);
 	}
+
+	/* Find the fastest reliable SPI clock and report it in kHz */
+	lcd_display_str_delayed("SPIKHZ", 500);
+	lcd_display_int_delayed(rfm96_spi_speed_test() / 1000, 1000);
+
+	/* Report the time on air in ms and pace packets to the duty cycle limit */
+	uint32_t time_on_air = rfm96_time_on_air(rfm96_get_profile(), sizeof(package_id.buffer));
+	tx_interval = airtime_min_interval_ms(time_on_air, TX_DUTY_CYCLE);
+	lcd_display_str_delayed("TOA MS", 500);
+	lcd_display_int_delayed((time_on_air + 500) / 1000, 1000);
 	
 	/* Wait for button push */
 	lcd_display_str("ready");
-	while(BSP_PB_GetState(BUTTON_USER) != 0);
-	while(BSP_PB_GetState(BUTTON_USER) != 1);
+	wait_for_user_button();
 		
-	/* Continously transmit packages until reset */
-	while(1)
-	{	
-	  	/* Display number of sent packages */
-		package_id.num++;
-		lcd_display_int((int)package_id.num);
-
-		/* Send a package */
-		rfm96_begin_packet();
-		rfm96_write_packet(package_id.buffer, 2);
-		rfm96_send_packet();
+	/* Continously transmit packages until reset, one per tx_interval. The 
+	 * scheduler sleeps until the pacing timer or the radio needs the task */
+	sched_init(tasks, TX_TASK_COUNT);
+	timer_init(&tx_timer, tx_due, 0);
+	timer_start(&tx_timer, 0, tx_interval);
+	sched_run();
+}
+
+/**
+	* @brief  Transmit task, sends paced packages and advances the 
+	*         transmission on radio events
+	* @param  events: TX_EVENT_* and SCHED_EVENT_RADIO flags
+	* @retval None
+	*/
+static void tx_task(uint32_t events)
+{
+	/* Send now or, if the last package is still on air, have tx_done send it */
+	if(events & TX_EVENT_DUE)
+	{
+		if(rfm96_tx_busy())
+		{
+			tx_pending = 1;
+		}
+		else
+		{
+			tx_send();
+		}
+	}
+
+	/* Steps that need no interrupt are taken one per run, so the task never 
+	 * holds up the scheduler for a whole transmission */
+	rfm96_tx_process();
+	if(rfm96_tx_step_due())
+	{
+		sched_signal(TX_TASK, TX_EVENT_STEP);
+	}
+}
+
+/**
+	* @brief  Pacing timer callback, signals the transmit task
+	* @param  arg: unused
+	* @retval None
+	*/
+static void tx_due(void* arg)
+{
+	(void)arg;
+
+	sched_signal(TX_TASK, TX_EVENT_DUE);
+}
+
+/**
+	* @brief  Queues the next package
+	* @param  None
+	* @retval None
+	*/
+static void tx_send(void)
+{
+	package_id.num++;
+	rfm96_send_async(package_id.buffer, 2, tx_done);
+
+	/* Display number of sent packages while package is on air */
+	lcd_display_int((int)package_id.num);
+}
+
+/**
+	* @brief  Transmission complete callback
+	* @param  status: RFM96_TX_OK or RFM96_TX_TIMEOUT
+	* @retval None
+	*/
+static void tx_done(uint8_t status)
+{
+	if(status == RFM96_TX_TIMEOUT)
+	{
+		tx_timeouts++;
+	}
+
+	/* A late package goes now, the pacing restarts from it to keep the duty 
+	 * cycle */
+	if(tx_pending)
+	{
+		tx_pending = 0;
+		tx_send();
+		timer_start(&tx_timer, tx_interval, tx_interval);
 	}
 }
 
@@ -0,0 +1,89 @@
+/*
+********************************************************************************
+* @file    pkt_queue.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Lock free queue of received packets, filled from the radio 
+*          interrupt and emptied by the main loop. Entries are written and 
+*          read in place, a slot is reserved and committed by the producer 
+*          and peeked and released by the consumer
+********************************************************************************
+*/
+
+#include "pkt_queue.h"
+#include "stm32l1xx.h"
+
+/* Make entry contents visible before the index that publishes them */
+#ifndef PKT_QUEUE_BARRIER
+#define PKT_QUEUE_BARRIER() __DMB()
+#endif
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief : empties the queue, must not race with either side
+ */
+void pkt_queue_init(struct pkt_queue* queue)
+{
+	queue->head = 0;
+	queue->tail = 0;
+}
+
+/*
+ * brief  : number of committed entries not yet released
+ */
+uint32_t pkt_queue_count(const struct pkt_queue* queue)
+{
+	return queue->head - queue->tail;
+}
+
+/*
+ * brief  : gets the next free entry for the producer to fill in
+ * retval : entry, or 0 if the queue is full
+ */
+struct pkt_desc* pkt_queue_reserve(struct pkt_queue* queue)
+{
+	uint32_t head = queue->head;
+
+	if(head - queue->tail >= PKT_QUEUE_LENGTH)
+	{
+		return 0;
+	}
+
+	return &queue->entries[head & (PKT_QUEUE_LENGTH - 1)];
+}
+
+/*
+ * brief : publishes the entry returned by pkt_queue_reserve
+ */
+void pkt_queue_commit(struct pkt_queue* queue)
+{
+	PKT_QUEUE_BARRIER();
+	queue->head = queue->head + 1;
+}
+
+/*
+ * brief  : gets the oldest committed entry without removing it
+ * retval : entry, or 0 if the queue is empty
+ */
+const struct pkt_desc* pkt_queue_peek(struct pkt_queue* queue)
+{
+	if(queue->tail == queue->head)
+	{
+		return 0;
+	}
+
+	/* Don't read the entry before the index that published it */
+	PKT_QUEUE_BARRIER();
+	return &queue->entries[queue->tail & (PKT_QUEUE_LENGTH - 1)];
+}
+
+/*
+ * brief : hands the entry returned by pkt_queue_peek back to the producer
+ */
+void pkt_queue_release(struct pkt_queue* queue)
+{
+	/* Finish reading the entry before the producer may reuse it */
+	PKT_QUEUE_BARRIER();
+	queue->tail = queue->tail + 1;
+}
@@ -0,0 +1,253 @@
+/*
+********************************************************************************
+* @file    power.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Low power waiting for the main loops. Waits that may be long enter
+*          STOP mode, woken by an EXTI line (DIO0, user button) or the RTC
+*          wakeup timer, and the 32 MHz PLL clock is restored before any
+*          interrupt handler runs. Short waits, and waits while a peripheral
+*          depends on the system clock, fall back to sleep mode
+********************************************************************************
+*/
+
+#include "power.h"
+#include "system_util.h"
+
+RTC_HandleTypeDef hrtc;
+
+/* Private variables ---------------------------------------------------------*/
+extern __IO uint32_t uwTick;            // HAL tick, not counted in STOP mode
+static volatile uint8_t stop_locks = 1; // users that need the clocks running,
+                                        // power_init drops the first
+static volatile uint8_t wake_pending;   // set by power_wake
+static struct power_stats stats;
+
+/* Private function prototypes -----------------------------------------------*/
+static void power_stop(void);
+static uint32_t power_rtc_ms(void);
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief : starts the RTC on the LSE clock already running for the LCD, it
+ *         keeps time and wakes the mcu while the other clocks are stopped.
+ *         Call after BSP_LCD_GLASS_Init
+ */
+void power_init(void)
+{
+	HAL_PWR_EnableBkUpAccess();
+
+	hrtc.Instance            = RTC;
+	hrtc.Init.HourFormat     = RTC_HOURFORMAT_24;
+	hrtc.Init.AsynchPrediv   = POWER_RTC_ASYNCH_DIV - 1;
+	hrtc.Init.SynchPrediv    = POWER_RTC_SYNCH_DIV - 1;
+	hrtc.Init.OutPut         = RTC_OUTPUT_DISABLE;
+	hrtc.Init.OutPutPolarity = RTC_OUTPUT_POLARITY_HIGH;
+	hrtc.Init.OutPutType     = RTC_OUTPUT_TYPE_OPENDRAIN;
+	if(HAL_RTC_Init(&hrtc) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	/* Read the calendar directly, the shadow registers are stale after STOP */
+	HAL_RTCEx_EnableBypassShadow(&hrtc);
+
+	/* Wakeup latency is counted in core cycles */
+	cycle_counter_init();
+
+	wake_pending = 0;
+	stats.sleeps = 0;
+	stats.stops = 0;
+	stats.stop_ms = 0;
+	stats.wake_us = 0;
+	stats.wake_us_max = 0;
+
+	/* The wakeup timer is ready, STOP mode may be used from now on */
+	power_stop_unlock();
+}
+
+/*
+ * brief   : sleeps until an interrupt or until timeout ms have passed. The
+ *           interrupt that ends the wait has run when this returns, and a
+ *           power_wake since the last wait makes it return at once
+ * timeout : ms, or POWER_WAIT_FOREVER to wait for an interrupt only
+ */
+void power_wait(uint32_t timeout)
+{
+	uint8_t stop = stop_locks == 0 && timeout >= POWER_STOP_MIN_TIME;
+	uint8_t alarm = stop && timeout != POWER_WAIT_FOREVER;
+
+	if(timeout == 0)
+	{
+		return;
+	}
+
+	if(alarm)
+	{
+		if(timeout > POWER_STOP_MAX_TIME)
+		{
+			timeout = POWER_STOP_MAX_TIME;
+		}
+		HAL_RTCEx_SetWakeUpTimer_IT(&hrtc, timeout * POWER_WAKEUP_CLOCK_HZ / 1000 - 1,
+			RTC_WAKEUPCLOCK_RTCCLK_DIV16);
+	}
+
+	/* With interrupts masked a wakeup source still ends WFI, but its handler
+	 * waits until the clocks are back */
+	__disable_irq();
+	if(wake_pending)
+	{
+		/* Work was handed over after the caller last looked */
+	}
+	else if(stop && stop_locks == 0)
+	{
+		power_stop();
+	}
+	else
+	{
+		/* Sleep mode keeps SysTick, the wait ends within a ms of any timeout */
+		stats.sleeps++;
+		HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+	}
+	wake_pending = 0;
+	__enable_irq();
+
+	if(alarm)
+	{
+		HAL_RTCEx_DeactivateWakeUpTimer(&hrtc);
+	}
+}
+
+/*
+ * brief : makes the next power_wait return at once. Called by interrupts that
+ *         hand work to the main loop, so work queued between the main loop's
+ *         last check and the wait is never slept on
+ */
+void power_wake(void)
+{
+	wake_pending = 1;
+}
+
+/*
+ * brief : keeps power_wait out of STOP mode until the matching unlock, for
+ *         transfers clocked from the system clock such as UART DMA and for
+ *         anything timed by SysTick. Safe to call from interrupts
+ */
+void power_stop_lock(void)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	stop_locks++;
+	__set_PRIMASK(primask);
+}
+
+void power_stop_unlock(void)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	stop_locks--;
+	__set_PRIMASK(primask);
+}
+
+void power_get_stats(struct power_stats* out)
+{
+	*out = stats;
+}
+
+/*
+ * brief : replaces the HAL busy wait, the mcu stops or sleeps until the
+ *         delay is over
+ */
+void HAL_Delay(__IO uint32_t Delay)
+{
+	uint32_t tickstart = HAL_GetTick();
+	uint32_t elapsed;
+
+	while((elapsed = HAL_GetTick() - tickstart) < Delay)
+	{
+		power_wait(Delay - elapsed);
+	}
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief : enters STOP mode with interrupts disabled, then restores the 32 MHz
+ *         clock and the HAL tick. The wakeup latency is timed from the first
+ *         instruction run on MSI until the PLL clock is ready, the regulator 
+ *         and MSI startup before it are not included
+ */
+static void power_stop(void)
+{
+	uint32_t start_ms;
+	uint32_t elapsed_ms;
+	uint32_t start_cycles;
+	uint32_t msi_hz;
+
+	HAL_SuspendTick();
+	start_ms = power_rtc_ms();
+
+	HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+	/* Running from MSI now, the last few cycles at 32 MHz are counted as MSI 
+	 * cycles so the latency errs on the high side */
+	start_cycles = cycle_counter_read();
+	msi_hz = HAL_RCC_GetSysClockFreq();
+	SystemClock_Config();
+	stats.wake_us = (uint32_t)((uint64_t)(cycle_counter_read() - start_cycles) * 1000000 / msi_hz);
+	if(stats.wake_us > stats.wake_us_max)
+	{
+		stats.wake_us_max = stats.wake_us;
+	}
+
+	/* Credit the HAL tick with the time spent stopped */
+	elapsed_ms = power_rtc_ms() - start_ms;
+	if(elapsed_ms >= 86400000)
+	{
+		elapsed_ms += 86400000; // midnight passed
+	}
+	uwTick += elapsed_ms;
+	stats.stop_ms += elapsed_ms;
+	stats.stops++;
+	HAL_ResumeTick();
+}
+
+/*
+ * brief  : reads the RTC calendar time of day, resolution 1/POWER_RTC_SYNCH_DIV s
+ * retval : ms since midnight
+ */
+static uint32_t power_rtc_ms(void)
+{
+	uint32_t ssr;
+	uint32_t tr;
+	uint32_t seconds;
+
+	/* Without shadow registers the time and subseconds must be read twice */
+	do
+	{
+		ssr = RTC->SSR;
+		tr = RTC->TR;
+	} while(ssr != RTC->SSR || tr != RTC->TR);
+
+	seconds = (((tr & RTC_TR_HT) >> RTC_TR_HT_Pos) * 10 + ((tr & RTC_TR_HU) >> RTC_TR_HU_Pos)) * 3600
+		+ (((tr & RTC_TR_MNT) >> RTC_TR_MNT_Pos) * 10 + ((tr & RTC_TR_MNU) >> RTC_TR_MNU_Pos)) * 60
+		+ ((tr & RTC_TR_ST) >> RTC_TR_ST_Pos) * 10 + ((tr & RTC_TR_SU) >> RTC_TR_SU_Pos);
+
+	return seconds * 1000 + (POWER_RTC_SYNCH_DIV - 1 - ssr) * 1000 / POWER_RTC_SYNCH_DIV;
+}
+
+/* RTC MSP -------------------------------------------------------------------*/
+void HAL_RTC_MspInit(RTC_HandleTypeDef* rtcHandle)
+{
+	if(rtcHandle->Instance == RTC)
+	{
+		/* LSE is already selected as RTC clock by the LCD */
+		__HAL_RCC_RTC_ENABLE();
+
+		/* Wakeup timer interrupt, only used to end STOP mode */
+		HAL_NVIC_SetPriority(RTC_WKUP_IRQn, 0x0F, 0);
+		HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
+	}
+}
@@ -0,0 +1,159 @@
+/*
+********************************************************************************
+* @file    rtos_port.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Message driven threads for the target. There is no RTOS kernel,
+*          so a thread is a handler run to completion once per message by the
+*          cooperative scheduler, with the CMSIS-RTOS priority and status
+*          types. Messages may be put from interrupts and are stamped with
+*          the cycle counter, so the time from an interrupt to the handler
+*          running is measured per thread. Host/rtos_port_posix.c implements
+*          the same interface with pthreads
+********************************************************************************
+*/
+
+#include "rtos_port.h"
+#include "system_util.h"
+
+/* Private variables ---------------------------------------------------------*/
+static struct port_thread* threads[PORT_MAX_THREADS];
+static uint32_t cycles_per_us;
+
+/* Private function prototypes -----------------------------------------------*/
+static void port_thread_run(uint8_t id);
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief : forgets every thread, call after power_init which starts the
+ *         cycle counter
+ */
+void port_init(void)
+{
+	for(uint8_t id = 0; id < PORT_MAX_THREADS; id++)
+	{
+		threads[id] = 0;
+	}
+	cycles_per_us = HAL_RCC_GetHCLKFreq() / 1000000;
+}
+
+/*
+ * brief  : registers a thread, its task must be in the scheduler's table
+ * retval : osOK, or osErrorParameter for a bad id or queue depth
+ */
+osStatus port_thread_create(uint8_t id, struct port_thread* thread)
+{
+	if(id >= PORT_MAX_THREADS || thread->depth == 0
+		|| (thread->depth & (thread->depth - 1)) != 0)
+	{
+		return osErrorParameter;
+	}
+
+	thread->head = 0;
+	thread->tail = 0;
+	thread->messages = 0;
+	thread->drops = 0;
+	thread->max_latency_us = 0;
+	thread->total_latency_us = 0;
+	threads[id] = thread;
+	return osOK;
+}
+
+/*
+ * brief  : queues a message for a thread and makes its task ready, safe to
+ *          call from interrupts
+ * retval : osOK, osErrorResource if the queue is full or osErrorParameter
+ *          if there is no such thread
+ */
+osStatus port_message_put(uint8_t id, uint32_t message)
+{
+	struct port_thread* thread;
+	uint32_t primask;
+	uint8_t head;
+
+	if(id >= PORT_MAX_THREADS || (thread = threads[id]) == 0)
+	{
+		return osErrorParameter;
+	}
+
+	/* Interrupts and threads may put on the same queue */
+	primask = __get_PRIMASK();
+	__disable_irq();
+	head = thread->head;
+	if((uint8_t)(head - thread->tail) >= thread->depth)
+	{
+		thread->drops++;
+		__set_PRIMASK(primask);
+		return osErrorResource;
+	}
+	thread->queue[head & (thread->depth - 1)].value = message;
+	thread->queue[head & (thread->depth - 1)].stamp = cycle_counter_read();
+	thread->head = head + 1;
+	__set_PRIMASK(primask);
+
+	sched_publish(PORT_EVENT(id));
+	return osOK;
+}
+
+const struct port_thread* port_thread_get(uint8_t id)
+{
+	return id < PORT_MAX_THREADS ? threads[id] : 0;
+}
+
+/*
+ * brief : nothing to start on target, the threads run once sched_run does
+ */
+void port_start(void)
+{
+}
+
+/*
+ * brief : scheduler entry shared by every thread task, the event bits say
+ *         which threads have messages
+ */
+void port_dispatch(uint32_t events)
+{
+	for(uint8_t id = 0; id < PORT_MAX_THREADS; id++)
+	{
+		if(events & PORT_EVENT(id))
+		{
+			port_thread_run(id);
+		}
+	}
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief : handles one message, the task is made ready again while more are
+ *         queued so other tasks get to run in between
+ */
+static void port_thread_run(uint8_t id)
+{
+	struct port_thread* thread = threads[id];
+	struct port_message message;
+	uint32_t latency_us;
+
+	if(thread == 0 || thread->tail == thread->head)
+	{
+		return;
+	}
+
+	message = thread->queue[thread->tail & (thread->depth - 1)];
+	thread->tail++;
+
+	latency_us = (cycle_counter_read() - message.stamp) / cycles_per_us;
+	if(latency_us > thread->max_latency_us)
+	{
+		thread->max_latency_us = latency_us;
+	}
+	thread->total_latency_us += latency_us;
+	thread->messages++;
+
+	thread->handler(message.value);
+
+	if(thread->tail != thread->head)
+	{
+		sched_publish(PORT_EVENT(id));
+	}
+}
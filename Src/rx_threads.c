@@ -0,0 +1,149 @@
+/*
+********************************************************************************
+* @file    rx_threads.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   The receive path as port threads. The radio interrupt puts a
+*          message for every queued package to the high priority radio
+*          thread, which takes the package and passes its sequence number,
+*          RSSI and SNR on to the low priority stats thread. That one feeds
+*          the statistics and has the low priority lcd thread show the
+*          count. Nothing here touches hardware, so the same code runs on
+*          target and on the host port
+********************************************************************************
+*/
+
+#include "rx_threads.h"
+
+/* Private defines -----------------------------------------------------------*/
+/* A package summary packed in one message: sequence number in bits 0-15, 
+ * RSSI in 16-24 and SNR in 25-31, both two's complement */
+#define RX_SAMPLE(seq, rssi, snr) ((uint32_t)(seq) | ((uint32_t)(rssi) & 0x1FF) << 16 \
+	| ((uint32_t)(snr) & 0x7F) << 25)
+#define RX_SAMPLE_SEQ(sample)  ((uint16_t)(sample))
+#define RX_SAMPLE_RSSI(sample) ((int16_t)((int32_t)((sample) << 7) >> 23))
+#define RX_SAMPLE_SNR(sample)  ((int8_t)((int32_t)(sample) >> 25))
+#define RX_ID_SIZE             2   // little endian package ID opens the payload
+
+/* Private function prototypes -----------------------------------------------*/
+static void rx_radio_thread(uint32_t message);
+static void rx_stats_thread(uint32_t message);
+static void rx_lcd_thread(uint32_t message);
+
+/* Private variables ---------------------------------------------------------*/
+PORT_THREAD_DEF(radio_thread, "RADIO", osPriorityHigh, rx_radio_thread, RX_THREADS_QUEUE_DEPTH);
+PORT_THREAD_DEF(stats_thread, "STATS", osPriorityLow, rx_stats_thread, RX_THREADS_QUEUE_DEPTH);
+PORT_THREAD_DEF(lcd_thread, "LCD", osPriorityLow, rx_lcd_thread, RX_THREADS_QUEUE_DEPTH);
+static const struct rx_threads_config* config;
+static volatile uint8_t running;
+static uint32_t taken;      // radio thread
+static uint32_t short_packets; // radio thread, skipped without an ID
+static uint32_t counted;    // stats thread
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief : registers the threads after port_init. The config must stay valid
+ *         and the statistics be reset by the caller
+ */
+void rx_threads_init(const struct rx_threads_config* rx_config)
+{
+	config = rx_config;
+	taken = 0;
+	short_packets = 0;
+	counted = 0;
+	port_thread_create(RX_THREAD_RADIO, &radio_thread);
+	port_thread_create(RX_THREAD_STATS, &stats_thread);
+	port_thread_create(RX_THREAD_LCD, &lcd_thread);
+	running = 1;
+}
+
+/*
+ * brief : call from the radio interrupt when a package has been queued
+ */
+void rx_threads_radio_irq(void)
+{
+	if(running)
+	{
+		port_message_put(RX_THREAD_RADIO, 0);
+	}
+}
+
+/*
+ * brief : stops taking packages, messages already put are still handled
+ */
+void rx_threads_stop(void)
+{
+	running = 0;
+}
+
+/*
+ * brief  : packages skipped for being too short to carry an ID
+ */
+uint32_t rx_threads_short_packets(void)
+{
+	return short_packets;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief : takes one package, packages past the limit are left queued
+ */
+static void rx_radio_thread(uint32_t message)
+{
+	const struct pkt_desc* packet;
+	uint32_t sample;
+
+	(void)message;
+
+	if(config->limit != 0 && taken >= config->limit)
+	{
+		return;
+	}
+
+	packet = pkt_queue_peek(config->queue);
+	if(packet == 0)
+	{
+		return;
+	}
+
+	/* Nothing to count without an ID, the package is skipped */
+	if(packet->length < RX_ID_SIZE)
+	{
+		short_packets++;
+		pkt_queue_release(config->queue);
+		return;
+	}
+
+	/* Little endian package ID from the payload */
+	sample = RX_SAMPLE(packet->payload[0] | (packet->payload[1] << 8), 
+		packet->rssi, packet->snr);
+	if(config->packet != 0)
+	{
+		config->packet(packet);
+	}
+	pkt_queue_release(config->queue);
+	taken++;
+
+	port_message_put(RX_THREAD_STATS, sample);
+}
+
+static void rx_stats_thread(uint32_t message)
+{
+	seq_tracker_add(config->seq_tracker, RX_SAMPLE_SEQ(message));
+	stats_add(config->rssi_stats, RX_SAMPLE_RSSI(message));
+	stats_add(config->snr_stats, RX_SAMPLE_SNR(message));
+	histogram_add(config->rssi_hist, RX_SAMPLE_RSSI(message));
+	histogram_add(config->snr_hist, RX_SAMPLE_SNR(message));
+	counted++;
+
+	port_message_put(RX_THREAD_LCD, counted);
+}
+
+static void rx_lcd_thread(uint32_t message)
+{
+	if(config->show != 0)
+	{
+		config->show(message);
+	}
+}
@@ -0,0 +1,158 @@
+/*
+********************************************************************************
+* @file    sched.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Cooperative run-to-completion scheduler. Tasks live in a static
+*          table in priority order and become ready when signalled with event
+*          flags, from interrupts, timer callbacks or other tasks. The highest
+*          priority ready task runs next, so a task waits at most for the
+*          longest run of any other task. Due timers are run before every
+*          dispatch and the mcu sleeps when nothing is ready
+********************************************************************************
+*/
+
+#include "sched.h"
+#include "system_util.h"
+
+/* Private variables ---------------------------------------------------------*/
+static struct sched_task* table;
+static uint8_t table_size;
+static volatile uint32_t ready;    // bit n set while task n has events
+static uint32_t cycles_per_us;
+
+/* Private function prototypes -----------------------------------------------*/
+static void sched_make_ready(uint8_t task, uint32_t events);
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief : takes over a task table, the first task has the highest priority.
+ *         The table must stay valid, nothing is copied
+ */
+void sched_init(struct sched_task* tasks, uint8_t count)
+{
+	if(count > SCHED_MAX_TASKS)
+	{
+		count = SCHED_MAX_TASKS;
+	}
+
+	for(uint8_t i = 0; i < count; i++)
+	{
+		tasks[i].events = 0;
+		tasks[i].runs = 0;
+		tasks[i].max_latency_us = 0;
+		tasks[i].max_run_us = 0;
+	}
+
+	ready = 0;
+	table = tasks;
+	table_size = count;
+	cycles_per_us = HAL_RCC_GetHCLKFreq() / 1000000;
+}
+
+/*
+ * brief : sets event flags on a task and makes it ready, safe to call from
+ *         interrupts
+ */
+void sched_signal(uint8_t task, uint32_t events)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if(task < table_size)
+	{
+		sched_make_ready(task, events);
+	}
+	__set_PRIMASK(primask);
+	power_wake();
+}
+
+/*
+ * brief : sets event flags on every task subscribed to them, safe to call
+ *         from interrupts and before sched_init
+ */
+void sched_publish(uint32_t events)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	for(uint8_t i = 0; i < table_size; i++)
+	{
+		if(table[i].subscribed & events)
+		{
+			sched_make_ready(i, table[i].subscribed & events);
+		}
+	}
+	__set_PRIMASK(primask);
+	power_wake();
+}
+
+/*
+ * brief : dispatches ready tasks by priority, sleeping in between. Does not
+ *         return
+ */
+void sched_run(void)
+{
+	struct sched_task* task;
+	uint32_t events;
+	uint32_t start;
+	uint32_t time_us;
+	uint32_t time_left;
+	uint8_t index;
+
+	while(1)
+	{
+		/* Timer callbacks signal tasks */
+		timer_wheel_process();
+
+		__disable_irq();
+		if(ready == 0)
+		{
+			/* A signal from here on ends the wait at once */
+			__enable_irq();
+			time_left = timer_wheel_time_left();
+			power_wait(time_left == TIMER_NO_DEADLINE ? POWER_WAIT_FOREVER : time_left);
+			continue;
+		}
+
+		/* Lowest set bit is the highest priority ready task */
+		index = (uint8_t)__CLZ(__RBIT(ready));
+		task = &table[index];
+		events = task->events;
+		task->events = 0;
+		ready &= ~(1UL << index);
+		start = cycle_counter_read();
+		__enable_irq();
+
+		time_us = (start - task->ready_cycles) / cycles_per_us;
+		if(time_us > task->max_latency_us)
+		{
+			task->max_latency_us = time_us;
+		}
+
+		task->entry(events);
+
+		time_us = (cycle_counter_read() - start) / cycles_per_us;
+		if(time_us > task->max_run_us)
+		{
+			task->max_run_us = time_us;
+		}
+		task->runs++;
+	}
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief : call with interrupts disabled, the latency is timed from the
+ *         first signal that finds the task idle
+ */
+static void sched_make_ready(uint8_t task, uint32_t events)
+{
+	if(!(ready & (1UL << task)))
+	{
+		table[task].ready_cycles = cycle_counter_read();
+		ready |= 1UL << task;
+	}
+	table[task].events |= events;
+}
@@ -0,0 +1,248 @@
+/*
+********************************************************************************
+* @file    seq_tracker.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Packet loss tracking from 16 bit sequence numbers. Sequence numbers
+*          are extended to 32 bits to survive wrap around, and the latest 
+*          SEQ_TRACKER_WINDOW packets are kept in a bitmap so duplicates and 
+*          reordered packets are recognised. Packets leaving the window are 
+*          final, and runs of missing ones are counted as loss bursts. A 
+*          transmitter that restarts numbers its packets from 1 again, two 
+*          packets in order from behind the window start a new sequence 
+*          that continues the counts
+********************************************************************************
+*/
+
+#include "seq_tracker.h"
+
+/* Private function prototypes -----------------------------------------------*/
+static void seq_tracker_retire(struct seq_tracker* tracker, uint32_t received);
+static void seq_tracker_end_run(struct seq_tracker* tracker);
+static void seq_tracker_restart(struct seq_tracker* tracker, uint16_t seq);
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief : resets all counters, the next packet starts the sequence
+ */
+void seq_tracker_init(struct seq_tracker* tracker)
+{
+	*tracker = (struct seq_tracker){0};
+}
+
+/*
+ * brief : records a received sequence number
+ * seq   : sequence number from the packet, wraps from 65535 to 0
+ */
+void seq_tracker_add(struct seq_tracker* tracker, uint16_t seq)
+{
+	int16_t diff;
+	uint32_t steps;
+	uint32_t bit;
+
+	if(!tracker->started)
+	{
+		tracker->started = 1;
+		tracker->first = seq;
+		tracker->highest = seq;
+		tracker->window = UINT32_MAX; // nothing before the first packet is missing
+		tracker->received = 1;
+		return;
+	}
+
+	/* Distance from the newest packet, modulo 2^16 */
+	diff = (int16_t)(seq - (uint16_t)tracker->highest);
+
+	if(diff > 0)
+	{
+		tracker->restart_pending = 0;
+
+		/* Slide the window, retiring the oldest packets first. Once the 
+		 * window is empty the remaining steps are all losses */
+		steps = diff;
+		while(steps > 0 && tracker->window != 0)
+		{
+			seq_tracker_retire(tracker, tracker->window >> (SEQ_TRACKER_WINDOW - 1));
+			tracker->window <<= 1;
+			steps--;
+		}
+		tracker->run += steps;
+
+		tracker->highest += diff;
+		tracker->window |= 1;
+		tracker->received++;
+	}
+	else if(-diff >= SEQ_TRACKER_WINDOW || (uint32_t)-diff > tracker->highest - tracker->first)
+	{
+		/* A stray late packet comes alone, a restarted transmitter goes on 
+		 * counting up from it */
+		if(tracker->restart_pending 
+			&& (uint16_t)(seq - tracker->restart_seq - 1) < SEQ_TRACKER_WINDOW)
+		{
+			seq_tracker_restart(tracker, seq);
+		}
+		else
+		{
+			tracker->late++;
+			tracker->restart_seq = seq;
+			tracker->restart_pending = 1;
+		}
+	}
+	else
+	{
+		tracker->restart_pending = 0;
+		bit = 1UL << -diff;
+		if(tracker->window & bit)
+		{
+			tracker->duplicates++;
+		}
+		else
+		{
+			tracker->window |= bit;
+			tracker->reordered++;
+			tracker->received++;
+		}
+	}
+}
+
+/*
+ * brief : retires the whole window at the end of a run, so gaps still in it 
+ *         count as lost bursts
+ */
+void seq_tracker_flush(struct seq_tracker* tracker)
+{
+	for(int i = 0; i < SEQ_TRACKER_WINDOW; i++)
+	{
+		seq_tracker_retire(tracker, tracker->window >> (SEQ_TRACKER_WINDOW - 1));
+		tracker->window <<= 1;
+	}
+	seq_tracker_end_run(tracker);
+
+	/* Everything is final, packets older than the next one are duplicates */
+	tracker->window = UINT32_MAX;
+}
+
+/*
+ * brief  : number of packets sent from the first to the newest received
+ */
+uint32_t seq_tracker_expected(const struct seq_tracker* tracker)
+{
+	if(!tracker->started)
+	{
+		return 0;
+	}
+	return tracker->highest - tracker->first + 1;
+}
+
+/*
+ * brief  : number of packets missing so far, packets still in the window may
+ *          yet arrive
+ */
+uint32_t seq_tracker_lost(const struct seq_tracker* tracker)
+{
+	uint32_t expected = seq_tracker_expected(tracker);
+	return expected > tracker->received ? expected - tracker->received : 0;
+}
+
+/*
+ * brief  : packet delivery ratio
+ * retval : received packets over expected packets, 0 - 1
+ */
+float seq_tracker_pdr(const struct seq_tracker* tracker)
+{
+	uint32_t expected = seq_tracker_expected(tracker);
+
+	if(expected == 0)
+	{
+		return 0.0f;
+	}
+	return (float)(expected - seq_tracker_lost(tracker)) / (float)expected;
+}
+
+/*
+ * brief  : longest run of consecutive lost packets, including the run being 
+ *          retired
+ */
+uint32_t seq_tracker_longest_outage(const struct seq_tracker* tracker)
+{
+	return tracker->run > tracker->longest_run ? tracker->run : tracker->longest_run;
+}
+
+/*
+ * brief  : smallest loss run length counted in a burst bucket
+ * bucket : 0 - SEQ_TRACKER_BURST_BUCKETS - 1
+ */
+uint16_t seq_tracker_burst_lower(uint8_t bucket)
+{
+	return bucket == 0 ? 1 : (1 << (bucket - 1)) + 1;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief    : accounts for a packet leaving the window 
+ * received : 1 if it was received, 0 if it was lost
+ */
+static void seq_tracker_retire(struct seq_tracker* tracker, uint32_t received)
+{
+	if(received)
+	{
+		seq_tracker_end_run(tracker);
+	}
+	else
+	{
+		tracker->run++;
+	}
+}
+
+/*
+ * brief : ends the sequence and starts a new one at the packet held as a 
+ *         restart candidate, followed by seq. The new packets are numbered 
+ *         on from the newest of the old sequence, so nothing between the 
+ *         two counts as lost
+ */
+static void seq_tracker_restart(struct seq_tracker* tracker, uint16_t seq)
+{
+	uint16_t skip;
+
+	/* Gaps in the old window are final */
+	seq_tracker_flush(tracker);
+
+	/* The candidate was counted late, move both ends so that it is the 
+	 * next number after the newest */
+	tracker->late--;
+	tracker->restart_pending = 0;
+	tracker->restarts++;
+	skip = (uint16_t)(tracker->restart_seq - (uint16_t)tracker->highest - 1);
+	tracker->first += skip;
+	tracker->highest += skip;
+
+	seq_tracker_add(tracker, tracker->restart_seq);
+	seq_tracker_add(tracker, seq);
+}
+
+/*
+ * brief : closes the current loss run, if any, and counts it in its bucket
+ */
+static void seq_tracker_end_run(struct seq_tracker* tracker)
+{
+	uint8_t bucket = 0;
+
+	if(tracker->run == 0)
+	{
+		return;
+	}
+
+	if(tracker->run > tracker->longest_run)
+	{
+		tracker->longest_run = tracker->run;
+	}
+
+	/* Bucket n holds runs of 2^(n-1) + 1 to 2^n */
+	while(bucket < SEQ_TRACKER_BURST_BUCKETS - 1 && (1UL << bucket) < tracker->run)
+	{
+		bucket++;
+	}
+	tracker->bursts[bucket]++;
+	tracker->run = 0;
+}
@@ -11,6 +11,41 @@
 
 SPI_HandleTypeDef hspi1;
 
+/* Private function prototypes -----------------------------------------------*/
+static void spi_polled_transmit(uint8_t* tx_data, size_t num_bytes);
+static void spi_polled_receive(uint8_t* rx_data, size_t num_bytes);
+static void spi_polled_transmit_receive(uint8_t* tx_data, uint8_t* rx_data, size_t num_bytes);
+#if SPI_USE_DMA
+static void spi_dma_transmit(uint8_t* tx_data, size_t num_bytes);
+static void spi_dma_receive(uint8_t* rx_data, size_t num_bytes);
+static void spi_dma_transmit_receive(uint8_t* tx_data, uint8_t* rx_data, size_t num_bytes);
+#endif
+
+/* Transports ----------------------------------------------------------------*/
+const struct spi_transport spi_transport_polled =
+{
+	spi_polled_transmit,
+	spi_polled_receive,
+	spi_polled_transmit_receive
+};
+
+#if SPI_USE_DMA
+DMA_HandleTypeDef hdma_spi1_rx;
+DMA_HandleTypeDef hdma_spi1_tx;
+static volatile uint8_t spi_dma_busy;
+
+const struct spi_transport spi_transport_dma =
+{
+	spi_dma_transmit,
+	spi_dma_receive,
+	spi_dma_transmit_receive
+};
+
+static const struct spi_transport* spi_transport = &spi_transport_dma;
+#else
+static const struct spi_transport* spi_transport = &spi_transport_polled;
+#endif
+
 /* SPI1 init function */
 void spi_init(void)
 {
@@ -56,31 +91,209 @@ void spi_init(void)
 	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
 	HAL_GPIO_Init(RFM96_RESET_PORT, &GPIO_InitStruct);
 
+	/* Configure the GPIO RFM96 DIO0 pin as rising edge interrupt */
+	GPIO_InitStruct.Pin   = RFM96_DIO0_PIN;
+	GPIO_InitStruct.Mode  = GPIO_MODE_IT_RISING;
+	GPIO_InitStruct.Pull  = GPIO_PULLDOWN;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	HAL_GPIO_Init(RFM96_DIO0_PORT, &GPIO_InitStruct);
+
+	/* The DIO0 interrupt drains the radio FIFO over SPI, the DMA channels
+	 * must stay at a higher priority, see HAL_SPI_MspInit */
+	HAL_NVIC_SetPriority(RFM96_DIO0_EXTI_IRQn, 0x02, 0);
+	HAL_NVIC_EnableIRQ(RFM96_DIO0_EXTI_IRQn);
+
 	/* Disable slave */
 	rfm96_spi_disable();
 }
 
 /*
- * brief     : wrapper function for HAL library spi transmit function 
+ * brief     : changes the SPI1 clock prescaler, takes effect on next transfer
+ * prescaler : one of SPI_BAUDRATEPRESCALER_2 .. SPI_BAUDRATEPRESCALER_256
+ */
+void spi_set_prescaler(uint32_t prescaler)
+{
+	__HAL_SPI_DISABLE(&hspi1);
+	MODIFY_REG(hspi1.Instance->CR1, SPI_CR1_BR, prescaler);
+	hspi1.Init.BaudRatePrescaler = prescaler;
+}
+
+/*
+ * brief  : calculates the current SPI1 clock frequency
+ * retval : SPI clock in Hz
+ */
+uint32_t spi_get_clock(void)
+{
+	/* SPI1 is clocked from APB2, BR = n divides by 2^(n+1) */
+	uint32_t br = (hspi1.Init.BaudRatePrescaler & SPI_CR1_BR) >> POSITION_VAL(SPI_CR1_BR);
+	return HAL_RCC_GetPCLK2Freq() >> (br + 1);
+}
+
+/*
+ * brief     : selects the transport used by the spi_* transfer functions 
+ * transport : spi_transport_polled, or spi_transport_dma if built with DMA
+ */
+void spi_set_transport(const struct spi_transport* transport)
+{
+	spi_transport = transport;
+}
+
+/*
+ * brief     : transmits a buffer over SPI1 using the selected transport 
  * tx_data   : pointer to first byte in tx data buffer 
  * num_bytes : size of buffer in bytes  
  */
 void spi_transmit(uint8_t* tx_data, size_t num_bytes)
 {
-	HAL_SPI_Transmit(&hspi1, tx_data, num_bytes, SPI_WAIT_TIME);
+	spi_transport->transmit(tx_data, num_bytes);
 }
 
 /*
- * brief     : wrapper function for HAL library spi transmit function 
+ * brief     : receives a buffer over SPI1 using the selected transport 
+ * rx_data   : pointer to first byte in rx data buffer 
+ * num_bytes : size of buffer in bytes  
+ */
+void spi_receive(uint8_t* rx_data, size_t num_bytes)
+{
+	spi_transport->receive(rx_data, num_bytes);
+}
+
+/*
+ * brief     : exchanges buffers over SPI1 using the selected transport 
  * tx_data   : pointer to first byte in tx data buffer 
  * rx_data   : pointer to first byte in rx data buffer 
  * num_bytes : size of buffers in bytes  
  */
 void spi_transmit_receive(uint8_t* tx_data, uint8_t* rx_data, size_t num_bytes)
+{
+	spi_transport->transmit_receive(tx_data, rx_data, num_bytes);
+}
+
+/* Polled transport ----------------------------------------------------------*/
+/*
+ * brief : wrapper function for HAL library spi transmit function 
+ */
+static void spi_polled_transmit(uint8_t* tx_data, size_t num_bytes)
+{
+	HAL_SPI_Transmit(&hspi1, tx_data, num_bytes, SPI_WAIT_TIME);
+}
+
+/*
+ * brief : wrapper function for HAL library spi receive function 
+ */
+static void spi_polled_receive(uint8_t* rx_data, size_t num_bytes)
+{
+	HAL_SPI_Receive(&hspi1, rx_data, num_bytes, SPI_WAIT_TIME);
+}
+
+/*
+ * brief : wrapper function for HAL library spi transmit receive function 
+ */
+static void spi_polled_transmit_receive(uint8_t* tx_data, uint8_t* rx_data, size_t num_bytes)
 {
 	HAL_SPI_TransmitReceive(&hspi1, tx_data, rx_data, num_bytes, SPI_WAIT_TIME);	
 }
 
+#if SPI_USE_DMA
+/* DMA transport -------------------------------------------------------------*/
+/*
+ * brief : sleeps until the DMA completion interrupt has fired. Interrupts are 
+ *         masked around the check so the wake up can not be missed, a 
+ *         pending interrupt still ends WFI 
+ */
+static void spi_dma_wait(void)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	while(spi_dma_busy)
+	{
+		__WFI();
+		__enable_irq();
+		__disable_irq();
+	}
+	__set_PRIMASK(primask);
+}
+
+/*
+ * brief : transmits with DMA, short transfers fall back to polling 
+ */
+static void spi_dma_transmit(uint8_t* tx_data, size_t num_bytes)
+{
+	if(num_bytes < SPI_DMA_MIN_BYTES)
+	{
+		spi_polled_transmit(tx_data, num_bytes);
+		return;
+	}
+
+	spi_dma_busy = 1;
+	if(HAL_SPI_Transmit_DMA(&hspi1, tx_data, num_bytes) != HAL_OK)
+	{
+		spi_dma_busy = 0;
+	}
+	spi_dma_wait();
+}
+
+/*
+ * brief : receives with DMA, short transfers fall back to polling 
+ */
+static void spi_dma_receive(uint8_t* rx_data, size_t num_bytes)
+{
+	if(num_bytes < SPI_DMA_MIN_BYTES)
+	{
+		spi_polled_receive(rx_data, num_bytes);
+		return;
+	}
+
+	spi_dma_busy = 1;
+	if(HAL_SPI_Receive_DMA(&hspi1, rx_data, num_bytes) != HAL_OK)
+	{
+		spi_dma_busy = 0;
+	}
+	spi_dma_wait();
+}
+
+/*
+ * brief : exchanges buffers with DMA, short transfers fall back to polling 
+ */
+static void spi_dma_transmit_receive(uint8_t* tx_data, uint8_t* rx_data, size_t num_bytes)
+{
+	if(num_bytes < SPI_DMA_MIN_BYTES)
+	{
+		spi_polled_transmit_receive(tx_data, rx_data, num_bytes);
+		return;
+	}
+
+	spi_dma_busy = 1;
+	if(HAL_SPI_TransmitReceive_DMA(&hspi1, tx_data, rx_data, num_bytes) != HAL_OK)
+	{
+		spi_dma_busy = 0;
+	}
+	spi_dma_wait();
+}
+
+/* DMA completion callbacks, called from the DMA channel interrupts */
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* spiHandle)
+{
+	spi_dma_busy = 0;
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef* spiHandle)
+{
+	spi_dma_busy = 0;
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef* spiHandle)
+{
+	spi_dma_busy = 0;
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* spiHandle)
+{
+	spi_dma_busy = 0;
+}
+#endif /* SPI_USE_DMA */
+
 void HAL_SPI_MspInit(SPI_HandleTypeDef* spiHandle)
 {
 	GPIO_InitTypeDef GPIO_InitStruct;
@@ -104,6 +317,48 @@ void HAL_SPI_MspInit(SPI_HandleTypeDef* spiHandle)
 		GPIO_InitStruct.Alternate = GPIO_AF5_SPI1;
 		HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
+#if SPI_USE_DMA
+		/* SPI1 DMA Init, RX on DMA1 channel 2 and TX on DMA1 channel 3 */
+		__HAL_RCC_DMA1_CLK_ENABLE();
+
+		hdma_spi1_rx.Instance                 = DMA1_Channel2;
+		hdma_spi1_rx.Init.Direction           = DMA_PERIPH_TO_MEMORY;
+		hdma_spi1_rx.Init.PeriphInc           = DMA_PINC_DISABLE;
+		hdma_spi1_rx.Init.MemInc              = DMA_MINC_ENABLE;
+		hdma_spi1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+		hdma_spi1_rx.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+		hdma_spi1_rx.Init.Mode                = DMA_NORMAL;
+		hdma_spi1_rx.Init.Priority            = DMA_PRIORITY_HIGH;
+		if (HAL_DMA_Init(&hdma_spi1_rx) != HAL_OK)
+		{
+			Error_Handler();
+		}
+		__HAL_LINKDMA(spiHandle, hdmarx, hdma_spi1_rx);
+
+		hdma_spi1_tx.Instance                 = DMA1_Channel3;
+		hdma_spi1_tx.Init.Direction           = DMA_MEMORY_TO_PERIPH;
+		hdma_spi1_tx.Init.PeriphInc           = DMA_PINC_DISABLE;
+		hdma_spi1_tx.Init.MemInc              = DMA_MINC_ENABLE;
+		hdma_spi1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+		hdma_spi1_tx.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+		hdma_spi1_tx.Init.Mode                = DMA_NORMAL;
+		hdma_spi1_tx.Init.Priority            = DMA_PRIORITY_HIGH;
+		if (HAL_DMA_Init(&hdma_spi1_tx) != HAL_OK)
+		{
+			Error_Handler();
+		}
+		__HAL_LINKDMA(spiHandle, hdmatx, hdma_spi1_tx);
+
+		/* DMA completion must be able to preempt the DIO0 interrupt, which
+		 * makes SPI transfers and sleeps in spi_dma_wait until they end. 
+		 * Keep these priorities numerically below the EXTI priority set in 
+		 * spi_init, or the FIFO drain waits forever */
+		HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, 0x01, 0);
+		HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+		HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, 0x01, 0);
+		HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+#endif
+
 	/* USER CODE BEGIN SPI1_MspInit 1 */
 
 	/* USER CODE END SPI1_MspInit 1 */
@@ -128,6 +383,13 @@ void HAL_SPI_MspDeInit(SPI_HandleTypeDef* spiHandle)
 		*/
 		HAL_GPIO_DeInit(GPIOA, GPIO_PIN_5|GPIO_PIN_11|GPIO_PIN_12);
 
+#if SPI_USE_DMA
+		/* SPI1 DMA DeInit */
+		HAL_DMA_DeInit(spiHandle->hdmarx);
+		HAL_DMA_DeInit(spiHandle->hdmatx);
+		HAL_NVIC_DisableIRQ(DMA1_Channel2_IRQn);
+		HAL_NVIC_DisableIRQ(DMA1_Channel3_IRQn);
+#endif
 	}
 	/* USER CODE BEGIN SPI1_MspDeInit 1 */
 
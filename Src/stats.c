@@ -0,0 +1,211 @@
+/*
+********************************************************************************
+* @file    stats.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Streaming statistics using Welford's algorithm. Samples are folded
+*          into the accumulator as they arrive, so no sample arrays are kept 
+*          and the running values can be shown at any time. Stored sample 
+*          sets can be processed in one go with the batch functions
+********************************************************************************
+*/
+
+#include "stats.h"
+#include "math.h"
+#if STATS_USE_CMSIS_DSP
+#include "arm_math.h"
+#endif
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief : empties the accumulator
+ */
+void stats_reset(struct stats_acc* acc)
+{
+	acc->count = 0;
+	acc->mean = 0.0f;
+	acc->m2 = 0.0f;
+	acc->min = 0.0f;
+	acc->max = 0.0f;
+}
+
+/*
+ * brief  : adds one sample, updating the mean and the squared differences
+ *          without the cancellation of the naive sum of squares
+ * sample : new sample
+ */
+void stats_add(struct stats_acc* acc, float sample)
+{
+	float delta;
+
+	acc->count++;
+	if(acc->count == 1)
+	{
+		acc->min = sample;
+		acc->max = sample;
+	}
+	else if(sample < acc->min)
+	{
+		acc->min = sample;
+	}
+	else if(sample > acc->max)
+	{
+		acc->max = sample;
+	}
+
+	delta = sample - acc->mean;
+	acc->mean += delta / (float)acc->count;
+	acc->m2 += delta * (sample - acc->mean);
+}
+
+/*
+ * brief  : arithmetic mean of the samples added so far
+ * retval : mean, 0 if there are no samples
+ */
+float stats_mean(const struct stats_acc* acc)
+{
+	return acc->mean;
+}
+
+/*
+ * brief  : sample variance of the samples added so far
+ * retval : variance, 0 for less than two samples
+ */
+float stats_variance(const struct stats_acc* acc)
+{
+	if(acc->count < 2)
+	{
+		return 0.0f;
+	}
+	return acc->m2 / (float)(acc->count - 1);
+}
+
+/*
+ * brief  : sample standard deviation of the samples added so far
+ * retval : standard deviation, 0 for less than two samples
+ */
+float stats_std_dev(const struct stats_acc* acc)
+{
+	return sqrtf(stats_variance(acc));
+}
+
+/*
+ * brief : folds the samples of another accumulator into acc, using Chan's
+ *         pairwise update of the mean and the squared differences
+ */
+void stats_merge(struct stats_acc* acc, const struct stats_acc* other)
+{
+	uint32_t count;
+	float delta;
+
+	if(other->count == 0)
+	{
+		return;
+	}
+	if(acc->count == 0)
+	{
+		*acc = *other;
+		return;
+	}
+
+	count = acc->count + other->count;
+	delta = other->mean - acc->mean;
+	acc->mean += delta * (float)other->count / (float)count;
+	acc->m2 += other->m2 + delta * delta * ((float)acc->count * (float)other->count / (float)count);
+	acc->min = other->min < acc->min ? other->min : acc->min;
+	acc->max = other->max > acc->max ? other->max : acc->max;
+	acc->count = count;
+}
+
+/* Batch statistics ----------------------------------------------------------*/
+/*
+ * brief   : two pass mean and sample variance in double precision, pulls 
+ *           in the soft float library on the Cortex-M3
+ * acc     : receives the result, previous contents are discarded
+ * samples : sample values
+ * n       : number of samples
+ */
+void stats_batch_double(struct stats_acc* acc, const int8_t* samples, uint16_t n)
+{
+	double sum = 0.0;
+	double diff = 0.0;
+	double mean;
+	int8_t min = INT8_MAX;
+	int8_t max = INT8_MIN;
+
+	stats_reset(acc);
+	if(n == 0)
+	{
+		return;
+	}
+
+	for(int i = 0; i < n; i++)
+	{
+		sum += (double)samples[i];
+		min = samples[i] < min ? samples[i] : min;
+		max = samples[i] > max ? samples[i] : max;
+	}
+	mean = sum / (double)n;
+
+	sum = 0.0;
+	for(int i = 0; i < n; i++)
+	{
+		diff = (double)samples[i] - mean;
+		sum += (diff * diff);
+	}
+
+	acc->count = n;
+	acc->mean = (float)mean;
+	acc->m2 = (float)sum;
+	acc->min = min;
+	acc->max = max;
+}
+
+#if STATS_USE_CMSIS_DSP
+/*
+ * brief : mean and sample variance with the CMSIS-DSP q31 kernels. Samples 
+ *         are widened to q31 a chunk at a time so the integer dB values keep 
+ *         their resolution, and the chunks are merged in float
+ */
+void stats_batch_cmsis(struct stats_acc* acc, const int8_t* samples, uint16_t n)
+{
+	q31_t chunk[STATS_BATCH_CHUNK];
+	struct stats_acc part;
+	uint32_t size;
+	q31_t mean;
+	q31_t var;
+	q7_t min;
+	q7_t max;
+	uint32_t index;
+
+	stats_reset(acc);
+	while(n > 0)
+	{
+		size = n < STATS_BATCH_CHUNK ? n : STATS_BATCH_CHUNK;
+
+		/* q7 to q31 shifts left by 24, one bit is taken back so that 
+		 * samples sit at dB << 23. The variance kernel squares them 
+		 * shifted down by 8 and scales the result by 2^-15, leaving 
+		 * dB^2 << 15. The sample variance of int8 values stays below 
+		 * 2^15 dB^2, so the q31 result can not wrap. For a single sample 
+		 * the kernel returns 0 */
+		arm_q7_to_q31((q7_t*)samples, chunk, size);
+		arm_shift_q31(chunk, -STATS_BATCH_HEADROOM, chunk, size);
+		arm_mean_q31(chunk, size, &mean);
+		arm_var_q31(chunk, size, &var);
+		arm_min_q7((q7_t*)samples, size, &min, &index);
+		arm_max_q7((q7_t*)samples, size, &max, &index);
+
+		part.count = size;
+		part.mean = (float)mean / (float)(1UL << (24 - STATS_BATCH_HEADROOM));
+		part.m2 = (float)var / (float)(1UL << (17 - 2 * STATS_BATCH_HEADROOM)) * (float)(size - 1);
+		part.min = min;
+		part.max = max;
+		stats_merge(acc, &part);
+
+		samples += size;
+		n -= size;
+	}
+}
+#endif
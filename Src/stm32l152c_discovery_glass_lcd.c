@@ -36,6 +36,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "stm32l152c_discovery_glass_lcd.h"
+#include <string.h>
 
 /** @addtogroup BSP
   * @{
@@ -54,11 +55,29 @@
 /** @defgroup STM32L152C-Discovery_GLASS_LCD_Private_Defines Private Defines
   * @{
   */
-#define ASCII_CHAR_0                  0x30  /* 0 */
-#define ASCII_CHAR_AT_SYMBOL          0x40  /* @ */
-#define ASCII_CHAR_LEFT_OPEN_BRACKET  0x5B  /* [ */
-#define ASCII_CHAR_APOSTROPHE         0x60  /* ` */
-#define ASCII_CHAR_LEFT_OPEN_BRACE    0x7B  /* ( */
+#define GLYPH_POINT                   0x0002 /* DP segment */
+#define GLYPH_COLON                   0x0020 /* COL segment */
+
+/* Letters display the same in both cases */
+#define GLYPH_LETTER(Upper, Code)     [Upper] = (Code), [(Upper) + ('a' - 'A')] = (Code)
+
+/* LCD RAM word of one glyph nibble: each set bit lights the LCD segment 
+   given for it, bit 0 first */
+#define SPREAD(Nibble, Seg0, Seg1, Seg2, Seg3)                           \
+  ((((Nibble) & 0x1) ? (Seg0) : 0) | (((Nibble) & 0x2) ? (Seg1) : 0) |   \
+   (((Nibble) & 0x4) ? (Seg2) : 0) | (((Nibble) & 0x8) ? (Seg3) : 0))
+
+#define SPREAD_TABLE(Seg0, Seg1, Seg2, Seg3)                             \
+  {                                                                      \
+    SPREAD(0x0, Seg0, Seg1, Seg2, Seg3), SPREAD(0x1, Seg0, Seg1, Seg2, Seg3), \
+    SPREAD(0x2, Seg0, Seg1, Seg2, Seg3), SPREAD(0x3, Seg0, Seg1, Seg2, Seg3), \
+    SPREAD(0x4, Seg0, Seg1, Seg2, Seg3), SPREAD(0x5, Seg0, Seg1, Seg2, Seg3), \
+    SPREAD(0x6, Seg0, Seg1, Seg2, Seg3), SPREAD(0x7, Seg0, Seg1, Seg2, Seg3), \
+    SPREAD(0x8, Seg0, Seg1, Seg2, Seg3), SPREAD(0x9, Seg0, Seg1, Seg2, Seg3), \
+    SPREAD(0xA, Seg0, Seg1, Seg2, Seg3), SPREAD(0xB, Seg0, Seg1, Seg2, Seg3), \
+    SPREAD(0xC, Seg0, Seg1, Seg2, Seg3), SPREAD(0xD, Seg0, Seg1, Seg2, Seg3), \
+    SPREAD(0xE, Seg0, Seg1, Seg2, Seg3), SPREAD(0xF, Seg0, Seg1, Seg2, Seg3)  \
+  }
 /**
   * @}
   */   
@@ -119,25 +138,74 @@ MSB   { 1 , 1 , 0 , 0   }
 
 LCD_HandleTypeDef LCDHandle;
 
-/* Constant table for cap characters 'A' --> 'Z' */
-const uint16_t CapLetterMap[26]=
-    {
-        /* A      B      C      D      E      F      G      H      I  */
-        0xFE00, 0x6714, 0x1D00, 0x4714, 0x9D00, 0x9C00, 0x3F00, 0xFA00, 0x0014,
-        /* J      K      L      M      N      O      P      Q      R  */
-        0x5300, 0x9841, 0x1900, 0x5A48, 0x5A09, 0x5F00, 0xFC00, 0x5F01, 0xFC01,
-        /* S      T      U      V      W      X      Y      Z  */
-        0xAF00, 0x0414, 0x5b00, 0x18C0, 0x5A81, 0x00C9, 0x0058, 0x05C0
-    };
-
-/* Constant table for number '0' --> '9' */
-const uint16_t NumberMap[10]=
-    {
-        /* 0      1      2      3      4      5      6      7      8      9  */
-        0x5F00,0x4200,0xF500,0x6700,0xEa00,0xAF00,0xBF00,0x04600,0xFF00,0xEF00
-    };
+/* Segment code of every character, indexed by its 8-bit code. Characters
+   without a glyph are blank. The code holds COM0 in its top nibble and COM3 
+   in its bottom one, see the mapping above */
+static const uint16_t GlyphMap[256] =
+{
+  [' '] = 0x0000,
+  ['*'] = C_STAR,
+  ['('] = C_OPENPARMAP,
+  [')'] = C_CLOSEPARMAP,
+  ['m'] = C_MMAP,
+  ['n'] = C_NMAP,
+  [(uint8_t)''] = C_UMAP,
+  ['-'] = C_MINUS,
+  ['/'] = C_SLATCH,
+  [(uint8_t)''] = C_PERCENT_1,
+  ['%'] = C_PERCENT_2,
+  [255] = C_FULL,
+
+  ['0'] = 0x5F00, ['1'] = 0x4200, ['2'] = 0xF500, ['3'] = 0x6700, ['4'] = 0xEA00,
+  ['5'] = 0xAF00, ['6'] = 0xBF00, ['7'] = 0x4600, ['8'] = 0xFF00, ['9'] = 0xEF00,
+
+  GLYPH_LETTER('A', 0xFE00), GLYPH_LETTER('B', 0x6714), GLYPH_LETTER('C', 0x1D00),
+  GLYPH_LETTER('D', 0x4714), GLYPH_LETTER('E', 0x9D00), GLYPH_LETTER('F', 0x9C00),
+  GLYPH_LETTER('G', 0x3F00), GLYPH_LETTER('H', 0xFA00), GLYPH_LETTER('I', 0x0014),
+  GLYPH_LETTER('J', 0x5300), GLYPH_LETTER('K', 0x9841), GLYPH_LETTER('L', 0x1900),
+  /* 'm' and 'n' have glyphs of their own */
+  ['M'] = 0x5A48,            ['N'] = 0x5A09,            GLYPH_LETTER('O', 0x5F00),
+  GLYPH_LETTER('P', 0xFC00), GLYPH_LETTER('Q', 0x5F01), GLYPH_LETTER('R', 0xFC01),
+  GLYPH_LETTER('S', 0xAF00), GLYPH_LETTER('T', 0x0414), GLYPH_LETTER('U', 0x5B00),
+  GLYPH_LETTER('V', 0x18C0), GLYPH_LETTER('W', 0x5A81), GLYPH_LETTER('X', 0x00C9),
+  GLYPH_LETTER('Y', 0x0058), GLYPH_LETTER('Z', 0x05C0),
+};
+
+/* LCD RAM bits of each glyph nibble, per digit position. Positions 4 and 5 
+   share their COM registers between two segment pairs */
+static const uint32_t DigitSpread[LCD_DIGIT_MAX_NUMBER][16] =
+{
+  SPREAD_TABLE(LCD_SEG0,  LCD_SEG1,  LCD_SEG22, LCD_SEG23),
+  SPREAD_TABLE(LCD_SEG2,  LCD_SEG3,  LCD_SEG20, LCD_SEG21),
+  SPREAD_TABLE(LCD_SEG4,  LCD_SEG5,  LCD_SEG18, LCD_SEG19),
+  SPREAD_TABLE(LCD_SEG6,  LCD_SEG7,  LCD_SEG16, LCD_SEG17),
+  SPREAD_TABLE(LCD_SEG8,  LCD_SEG9,  LCD_SEG14, LCD_SEG15),
+  SPREAD_TABLE(LCD_SEG10, LCD_SEG11, LCD_SEG12, LCD_SEG13),
+};
+
+/* Bits of the COM registers each digit position leaves untouched */
+static const uint32_t DigitMask[LCD_DIGIT_MAX_NUMBER] =
+{
+  LCD_DIGIT1_COM0_SEG_MASK,
+  LCD_DIGIT2_COM0_SEG_MASK,
+  LCD_DIGIT3_COM0_SEG_MASK,
+  LCD_DIGIT4_COM0_SEG_MASK & LCD_DIGIT4_COM0_1_SEG_MASK,
+  LCD_DIGIT5_COM0_SEG_MASK & LCD_DIGIT5_COM0_1_SEG_MASK,
+  LCD_DIGIT6_COM0_SEG_MASK,
+};
+
+/* LCD RAM register of each COM, shared by all positions */
+static const uint32_t DigitCom[COM_PER_DIGIT_NB] =
+{
+  LCD_COM0, LCD_COM1, LCD_COM2, LCD_COM3
+};
 
-uint32_t Digit[4];     /* Digit frame buffer */
+/* Shadow of the LCD RAM: the frame being composed and the words last 
+   committed to the peripheral. Drawing only touches LCDFrame, the LCD RAM is
+   written and the update request issued once per frame */
+static uint32_t LCDFrame[LCD_RAM_REGISTER15 + 1];
+static uint32_t LCDCommitted[LCD_RAM_REGISTER15 + 1];
+static uint8_t LCDFrameDepth = 0;
 
 /* LCD BAR status: To save the bar setting after writing in LCD RAM memory */
 //uint8_t LCDBar = BATTERYLEVEL_FULL;
@@ -150,9 +218,11 @@ uint8_t LCDBar = BATTERYLEVEL_OFF; // developer hack, turn LCDbar off!
 /** @defgroup STM32L152C-Discovery_LCD_Private_Functions Private Functions
   * @{
   */
-static void Convert(uint8_t* Char, Point_Typedef Point, DoublePoint_Typedef DoublePoint);
 static void LCD_MspInit(LCD_HandleTypeDef *hlcd);
 static void LCD_MspDeInit(LCD_HandleTypeDef *hlcd);
+static void LCD_FrameWrite(uint32_t RAMRegisterIndex, uint32_t RAMRegisterMask, uint32_t Data);
+static void LCD_FrameUpdate(void);
+static void LCD_FrameCommit(void);
 
 /**
   * @}
@@ -184,7 +254,35 @@ void BSP_LCD_GLASS_Init(void)
   LCD_MspInit(&LCDHandle);
   HAL_LCD_Init(&LCDHandle);
 
-  BSP_LCD_GLASS_Clear();
+  /* HAL_LCD_Init leaves the LCD RAM cleared */
+  memset(LCDFrame, 0, sizeof(LCDFrame));
+  memset(LCDCommitted, 0, sizeof(LCDCommitted));
+  LCDFrameDepth = 0;
+}
+
+/**
+  * @brief  Starts composing a frame. Drawing calls made until the matching
+  *         BSP_LCD_GLASS_FrameEnd only change the shadow of the LCD RAM.
+  *         Frames may be nested, the outermost one is committed.
+  * @retval None
+  */
+void BSP_LCD_GLASS_FrameBegin(void)
+{
+  LCDFrameDepth++;
+}
+
+/**
+  * @brief  Ends a frame started by BSP_LCD_GLASS_FrameBegin. The outermost 
+  *         frame writes the changed LCD RAM words and requests one update.
+  * @retval None
+  */
+void BSP_LCD_GLASS_FrameEnd(void)
+{
+  if(LCDFrameDepth > 0)
+  {
+    LCDFrameDepth--;
+  }
+  LCD_FrameUpdate();
 }
 
 /**
@@ -266,25 +364,25 @@ void BSP_LCD_GLASS_DisplayBar(uint32_t BarId)
       /* Bar 0 */
       case LCD_BAR_0:
         /* Set BAR0 */
-        HAL_LCD_Write(&LCDHandle, LCD_BAR0_2_COM, ~(LCD_BAR0_SEG), LCD_BAR0_SEG);
+        LCD_FrameWrite(LCD_BAR0_2_COM, ~(LCD_BAR0_SEG), LCD_BAR0_SEG);
         break;
         
       /* Bar 1 */
       case LCD_BAR_1:
         /* Set BAR1 */
-        HAL_LCD_Write(&LCDHandle, LCD_BAR1_3_COM, ~(LCD_BAR1_SEG), LCD_BAR1_SEG);
+        LCD_FrameWrite(LCD_BAR1_3_COM, ~(LCD_BAR1_SEG), LCD_BAR1_SEG);
         break;
         
       /* Bar 2 */
       case LCD_BAR_2:
         /* Set BAR2 */
-        HAL_LCD_Write(&LCDHandle, LCD_BAR0_2_COM, ~(LCD_BAR2_SEG), LCD_BAR2_SEG);
+        LCD_FrameWrite(LCD_BAR0_2_COM, ~(LCD_BAR2_SEG), LCD_BAR2_SEG);
         break;
         
       /* Bar 3 */
       case LCD_BAR_3:
         /* Set BAR3 */
-        HAL_LCD_Write(&LCDHandle, LCD_BAR1_3_COM, ~(LCD_BAR3_SEG), LCD_BAR3_SEG);
+        LCD_FrameWrite(LCD_BAR1_3_COM, ~(LCD_BAR3_SEG), LCD_BAR3_SEG);
         break;
         
       default:
@@ -294,7 +392,7 @@ void BSP_LCD_GLASS_DisplayBar(uint32_t BarId)
   }
   
   /* Update the LCD display */
-  HAL_LCD_UpdateDisplayRequest(&LCDHandle);
+  LCD_FrameUpdate();
 }
 
 /**
@@ -320,25 +418,25 @@ void BSP_LCD_GLASS_ClearBar(uint32_t BarId)
       /* Bar 0 */
       case LCD_BAR_0:
         /* Set BAR0 */
-        HAL_LCD_Write(&LCDHandle, LCD_BAR0_2_COM, ~(LCD_BAR0_SEG) , 0);
+        LCD_FrameWrite(LCD_BAR0_2_COM, ~(LCD_BAR0_SEG) , 0);
         break;
         
       /* Bar 1 */
       case LCD_BAR_1:
         /* Set BAR1 */
-        HAL_LCD_Write(&LCDHandle, LCD_BAR1_3_COM, ~(LCD_BAR1_SEG), 0);
+        LCD_FrameWrite(LCD_BAR1_3_COM, ~(LCD_BAR1_SEG), 0);
         break;
         
       /* Bar 2 */
       case LCD_BAR_2:
         /* Set BAR2 */
-        HAL_LCD_Write(&LCDHandle, LCD_BAR0_2_COM, ~(LCD_BAR2_SEG), 0);
+        LCD_FrameWrite(LCD_BAR0_2_COM, ~(LCD_BAR2_SEG), 0);
         break;
         
       /* Bar 3 */
       case LCD_BAR_3:
         /* Set BAR3 */
-        HAL_LCD_Write(&LCDHandle, LCD_BAR1_3_COM, ~(LCD_BAR3_SEG), 0);
+        LCD_FrameWrite(LCD_BAR1_3_COM, ~(LCD_BAR3_SEG), 0);
         break;
         
       default:
@@ -348,7 +446,7 @@ void BSP_LCD_GLASS_ClearBar(uint32_t BarId)
   }
   
   /* Update the LCD display */
-  HAL_LCD_UpdateDisplayRequest(&LCDHandle);
+  LCD_FrameUpdate();
 }
 
 /**
@@ -369,45 +467,45 @@ void BSP_LCD_GLASS_BarLevelConfig(uint8_t BarLevel)
   /* BATTERYLEVEL_OFF */
   case BATTERYLEVEL_OFF:
     /* Set BAR0 & BAR2 off */
-    HAL_LCD_Write(&LCDHandle, LCD_BAR0_2_COM, ~(LCD_BAR0_SEG | LCD_BAR2_SEG), 0);
+    LCD_FrameWrite(LCD_BAR0_2_COM, ~(LCD_BAR0_SEG | LCD_BAR2_SEG), 0);
     /* Set BAR1 & BAR3 off */
-    HAL_LCD_Write(&LCDHandle, LCD_BAR1_3_COM, ~(LCD_BAR1_SEG | LCD_BAR3_SEG), 0);
+    LCD_FrameWrite(LCD_BAR1_3_COM, ~(LCD_BAR1_SEG | LCD_BAR3_SEG), 0);
     LCDBar = BATTERYLEVEL_OFF;
     break;
     
   /* BARLEVEL 1/4 */
   case BATTERYLEVEL_1_4:
     /* Set BAR0 on & BAR2 off */
-    HAL_LCD_Write(&LCDHandle, LCD_BAR0_2_COM, ~(LCD_BAR0_SEG | LCD_BAR2_SEG), LCD_BAR0_SEG);
+    LCD_FrameWrite(LCD_BAR0_2_COM, ~(LCD_BAR0_SEG | LCD_BAR2_SEG), LCD_BAR0_SEG);
     /* Set BAR1 & BAR3 off */
-    HAL_LCD_Write(&LCDHandle, LCD_BAR1_3_COM, ~(LCD_BAR1_SEG | LCD_BAR3_SEG), 0);
+    LCD_FrameWrite(LCD_BAR1_3_COM, ~(LCD_BAR1_SEG | LCD_BAR3_SEG), 0);
     LCDBar = BATTERYLEVEL_1_4;
     break;
     
   /* BARLEVEL 1/2 */
   case BATTERYLEVEL_1_2:
     /* Set BAR0 on & BAR2 off */
-    HAL_LCD_Write(&LCDHandle, LCD_BAR0_2_COM, ~(LCD_BAR0_SEG | LCD_BAR2_SEG), LCD_BAR0_SEG);
+    LCD_FrameWrite(LCD_BAR0_2_COM, ~(LCD_BAR0_SEG | LCD_BAR2_SEG), LCD_BAR0_SEG);
     /* Set BAR1 on & BAR3 off */
-    HAL_LCD_Write(&LCDHandle, LCD_BAR1_3_COM, ~(LCD_BAR1_SEG | LCD_BAR3_SEG), LCD_BAR1_SEG);
+    LCD_FrameWrite(LCD_BAR1_3_COM, ~(LCD_BAR1_SEG | LCD_BAR3_SEG), LCD_BAR1_SEG);
     LCDBar = BATTERYLEVEL_1_2;
     break;
     
   /* Battery Level 3/4 */
   case BATTERYLEVEL_3_4:
     /* Set BAR0 & BAR2 on */
-    HAL_LCD_Write(&LCDHandle, LCD_BAR0_2_COM, ~(LCD_BAR0_SEG | LCD_BAR2_SEG), (LCD_BAR0_SEG | LCD_BAR2_SEG));
+    LCD_FrameWrite(LCD_BAR0_2_COM, ~(LCD_BAR0_SEG | LCD_BAR2_SEG), (LCD_BAR0_SEG | LCD_BAR2_SEG));
     /* Set BAR1 on & BAR3 off */
-    HAL_LCD_Write(&LCDHandle, LCD_BAR1_3_COM, ~(LCD_BAR1_SEG | LCD_BAR3_SEG), LCD_BAR1_SEG);
+    LCD_FrameWrite(LCD_BAR1_3_COM, ~(LCD_BAR1_SEG | LCD_BAR3_SEG), LCD_BAR1_SEG);
     LCDBar = BATTERYLEVEL_3_4;
     break;
     
   /* BATTERYLEVEL_FULL */
   case BATTERYLEVEL_FULL:
     /* Set BAR0 & BAR2 on */
-    HAL_LCD_Write(&LCDHandle, LCD_BAR0_2_COM, ~(LCD_BAR0_SEG | LCD_BAR2_SEG), (LCD_BAR0_SEG | LCD_BAR2_SEG));
+    LCD_FrameWrite(LCD_BAR0_2_COM, ~(LCD_BAR0_SEG | LCD_BAR2_SEG), (LCD_BAR0_SEG | LCD_BAR2_SEG));
     /* Set BAR1 on & BAR3 on */
-    HAL_LCD_Write(&LCDHandle, LCD_BAR1_3_COM, ~(LCD_BAR1_SEG | LCD_BAR3_SEG), (LCD_BAR1_SEG | LCD_BAR3_SEG));
+    LCD_FrameWrite(LCD_BAR1_3_COM, ~(LCD_BAR1_SEG | LCD_BAR3_SEG), (LCD_BAR1_SEG | LCD_BAR3_SEG));
     LCDBar = BATTERYLEVEL_FULL;
     break;
     
@@ -416,7 +514,7 @@ void BSP_LCD_GLASS_BarLevelConfig(uint8_t BarLevel)
   }
   
   /* Update the LCD display */
-  HAL_LCD_UpdateDisplayRequest(&LCDHandle);
+  LCD_FrameUpdate();
 }
 
 /**
@@ -434,10 +532,14 @@ void BSP_LCD_GLASS_BarLevelConfig(uint8_t BarLevel)
   */
 void BSP_LCD_GLASS_WriteChar(uint8_t* ch, uint8_t Point, uint8_t Column, uint8_t Position)
 {
+  BSP_LCD_GLASS_FrameBegin();
+
   BSP_LCD_GLASS_DisplayChar(ch, (Point_Typedef)Point, (DoublePoint_Typedef)Column, (DigitPosition_Typedef)Position);
 
   /* Refresh LCD  bar */
   BSP_LCD_GLASS_BarLevelConfig(LCDBar);
+
+  BSP_LCD_GLASS_FrameEnd();
 }
 
 /**
@@ -458,148 +560,36 @@ void BSP_LCD_GLASS_WriteChar(uint8_t* ch, uint8_t Point, uint8_t Column, uint8_t
   */
 void BSP_LCD_GLASS_DisplayChar(uint8_t* ch, Point_Typedef Point, DoublePoint_Typedef Column, DigitPosition_Typedef Position)
 {
-  uint32_t data =0x00;
-  /* To convert displayed character in segment in array digit */
-  Convert(ch, (Point_Typedef)Point, (DoublePoint_Typedef)Column);
+  uint16_t glyph = GlyphMap[*ch];
+  const uint32_t* spread;
+  uint32_t com = 0;
 
-  switch (Position)
+  if ((Position < LCD_DIGIT_POSITION_1) || (Position > LCD_DIGIT_POSITION_6))
   {
-    /* Position 1 on LCD (Digit1)*/
-    case LCD_DIGIT_POSITION_1:
-      data = ((Digit[0] & 0x1) << LCD_SEG0_SHIFT) | (((Digit[0] & 0x2) >> 1) << LCD_SEG1_SHIFT)
-          | (((Digit[0] & 0x4) >> 2) << LCD_SEG22_SHIFT) | (((Digit[0] & 0x8) >> 3) << LCD_SEG23_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT1_COM0, LCD_DIGIT1_COM0_SEG_MASK, data); /* 1G 1B 1M 1E */
-      
-      data = ((Digit[1] & 0x1) << LCD_SEG0_SHIFT) | (((Digit[1] & 0x2) >> 1) << LCD_SEG1_SHIFT)
-          | (((Digit[1] & 0x4) >> 2) << LCD_SEG22_SHIFT) | (((Digit[1] & 0x8) >> 3) << LCD_SEG23_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT1_COM1, LCD_DIGIT1_COM1_SEG_MASK, data) ; /* 1F 1A 1C 1D  */
-      
-      data = ((Digit[2] & 0x1) << LCD_SEG0_SHIFT) | (((Digit[2] & 0x2) >> 1) << LCD_SEG1_SHIFT)
-          | (((Digit[2] & 0x4) >> 2) << LCD_SEG22_SHIFT) | (((Digit[2] & 0x8) >> 3) << LCD_SEG23_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT1_COM2, LCD_DIGIT1_COM2_SEG_MASK, data) ; /* 1Q 1K 1Col 1P  */
-      
-      data = ((Digit[3] & 0x1) << LCD_SEG0_SHIFT) | (((Digit[3] & 0x2) >> 1) << LCD_SEG1_SHIFT)
-          | (((Digit[3] & 0x4) >> 2) << LCD_SEG22_SHIFT) | (((Digit[3] & 0x8) >> 3) << LCD_SEG23_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT1_COM3, LCD_DIGIT1_COM3_SEG_MASK, data) ; /* 1H 1J 1DP 1N  */
-      break;
+    return;
+  }
 
-    /* Position 2 on LCD (Digit2)*/
-    case LCD_DIGIT_POSITION_2:
-      data = ((Digit[0] & 0x1) << LCD_SEG2_SHIFT) | (((Digit[0] & 0x2) >> 1) << LCD_SEG3_SHIFT)
-          | (((Digit[0] & 0x4) >> 2) << LCD_SEG20_SHIFT) | (((Digit[0] & 0x8) >> 3) << LCD_SEG21_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT2_COM0, LCD_DIGIT2_COM0_SEG_MASK, data); /* 2G 2B 2M 2E */
-      
-      data = ((Digit[1] & 0x1) << LCD_SEG2_SHIFT) | (((Digit[1] & 0x2) >> 1) << LCD_SEG3_SHIFT)
-          | (((Digit[1] & 0x4) >> 2) << LCD_SEG20_SHIFT) | (((Digit[1] & 0x8) >> 3) << LCD_SEG21_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT2_COM1, LCD_DIGIT2_COM1_SEG_MASK, data) ; /* 2F 2A 2C 2D  */
-      
-      data = ((Digit[2] & 0x1) << LCD_SEG2_SHIFT) | (((Digit[2] & 0x2) >> 1) << LCD_SEG3_SHIFT)
-          | (((Digit[2] & 0x4) >> 2) << LCD_SEG20_SHIFT) | (((Digit[2] & 0x8) >> 3) << LCD_SEG21_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT2_COM2, LCD_DIGIT2_COM2_SEG_MASK, data) ; /* 2Q 2K 2Col 2P  */
-      
-      data = ((Digit[3] & 0x1) << LCD_SEG2_SHIFT) | (((Digit[3] & 0x2) >> 1) << LCD_SEG3_SHIFT)
-          | (((Digit[3] & 0x4) >> 2) << LCD_SEG20_SHIFT) | (((Digit[3] & 0x8) >> 3) << LCD_SEG21_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT2_COM3, LCD_DIGIT2_COM3_SEG_MASK, data) ; /* 2H 2J 2DP 2N  */
-      break;
-    
-    /* Position 3 on LCD (Digit3)*/
-    case LCD_DIGIT_POSITION_3:
-      data = ((Digit[0] & 0x1) << LCD_SEG4_SHIFT) | (((Digit[0] & 0x2) >> 1) << LCD_SEG5_SHIFT)
-          | (((Digit[0] & 0x4) >> 2) << LCD_SEG18_SHIFT) | (((Digit[0] & 0x8) >> 3) << LCD_SEG19_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT3_COM0, LCD_DIGIT3_COM0_SEG_MASK, data); /* 3G 3B 3M 3E */
-      
-      data = ((Digit[1] & 0x1) << LCD_SEG4_SHIFT) | (((Digit[1] & 0x2) >> 1) << LCD_SEG5_SHIFT)
-          | (((Digit[1] & 0x4) >> 2) << LCD_SEG18_SHIFT) | (((Digit[1] & 0x8) >> 3) << LCD_SEG19_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT3_COM1, LCD_DIGIT3_COM1_SEG_MASK, data) ; /* 3F 3A 3C 3D  */
-      
-      data = ((Digit[2] & 0x1) << LCD_SEG4_SHIFT) | (((Digit[2] & 0x2) >> 1) << LCD_SEG5_SHIFT)
-          | (((Digit[2] & 0x4) >> 2) << LCD_SEG18_SHIFT) | (((Digit[2] & 0x8) >> 3) << LCD_SEG19_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT3_COM2, LCD_DIGIT3_COM2_SEG_MASK, data) ; /* 3Q 3K 3Col 3P  */
-      
-      data = ((Digit[3] & 0x1) << LCD_SEG4_SHIFT) | (((Digit[3] & 0x2) >> 1) << LCD_SEG5_SHIFT)
-          | (((Digit[3] & 0x4) >> 2) << LCD_SEG18_SHIFT) | (((Digit[3] & 0x8) >> 3) << LCD_SEG19_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT3_COM3, LCD_DIGIT3_COM3_SEG_MASK, data) ; /* 3H 3J 3DP 3N  */
-      break;
-    
-    /* Position 4 on LCD (Digit4)*/
-    case LCD_DIGIT_POSITION_4:
-      data = ((Digit[0] & 0x1) << LCD_SEG6_SHIFT) | (((Digit[0] & 0x8) >> 3) << LCD_SEG17_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT4_COM0, LCD_DIGIT4_COM0_SEG_MASK, data); /* 4G 4B 4M 4E */
-      
-      data = (((Digit[0] & 0x2) >> 1) << LCD_SEG7_SHIFT) | (((Digit[0] & 0x4) >> 2) << LCD_SEG16_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT4_COM0_1, LCD_DIGIT4_COM0_1_SEG_MASK, data); /* 4G 4B 4M 4E */
-      
-      data = ((Digit[1] & 0x1) << LCD_SEG6_SHIFT) | (((Digit[1] & 0x8) >> 3) << LCD_SEG17_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT4_COM1, LCD_DIGIT4_COM1_SEG_MASK, data) ; /* 4F 4A 4C 4D  */
-      
-      data = (((Digit[1] & 0x2) >> 1) << LCD_SEG7_SHIFT) | (((Digit[1] & 0x4) >> 2) << LCD_SEG16_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT4_COM1_1, LCD_DIGIT4_COM1_1_SEG_MASK, data) ; /* 4F 4A 4C 4D  */
-      
-      data = ((Digit[2] & 0x1) << LCD_SEG6_SHIFT) | (((Digit[2] & 0x8) >> 3) << LCD_SEG17_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT4_COM2, LCD_DIGIT4_COM2_SEG_MASK, data) ; /* 4Q 4K 4Col 4P  */
-      
-      data = (((Digit[2] & 0x2) >> 1) << LCD_SEG7_SHIFT) | (((Digit[2] & 0x4) >> 2) << LCD_SEG16_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT4_COM2_1, LCD_DIGIT4_COM2_1_SEG_MASK, data) ; /* 4Q 4K 4Col 4P  */
-      
-      data = ((Digit[3] & 0x1) << LCD_SEG6_SHIFT) | (((Digit[3] & 0x8) >> 3) << LCD_SEG17_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT4_COM3, LCD_DIGIT4_COM3_SEG_MASK, data) ; /* 4H 4J 4DP 4N  */
-      
-      data = (((Digit[3] & 0x2) >> 1) << LCD_SEG7_SHIFT) | (((Digit[3] & 0x4) >> 2) << LCD_SEG16_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT4_COM3_1, LCD_DIGIT4_COM3_1_SEG_MASK, data) ; /* 4H 4J 4DP 4N  */
-      break;
-    
-    /* Position 5 on LCD (Digit5)*/
-    case LCD_DIGIT_POSITION_5:
-       data = (((Digit[0] & 0x2) >> 1) << LCD_SEG9_SHIFT) | (((Digit[0] & 0x4) >> 2) << LCD_SEG14_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT5_COM0, LCD_DIGIT5_COM0_SEG_MASK, data); /* 5G 5B 5M 5E */
-      
-      data = ((Digit[0] & 0x1) << LCD_SEG8_SHIFT) | (((Digit[0] & 0x8) >> 3) << LCD_SEG15_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT5_COM0_1, LCD_DIGIT5_COM0_1_SEG_MASK, data); /* 5G 5B 5M 5E */
-      
-      data = (((Digit[1] & 0x2) >> 1) << LCD_SEG9_SHIFT) | (((Digit[1] & 0x4) >> 2) << LCD_SEG14_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT5_COM1, LCD_DIGIT5_COM1_SEG_MASK, data) ; /* 5F 5A 5C 5D */
-      
-       data = ((Digit[1] & 0x1) << LCD_SEG8_SHIFT) | (((Digit[1] & 0x8) >> 3) << LCD_SEG15_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT5_COM1_1, LCD_DIGIT5_COM1_1_SEG_MASK, data) ; /* 5F 5A 5C 5D */
-      
-      data = (((Digit[2] & 0x2) >> 1) << LCD_SEG9_SHIFT) | (((Digit[2] & 0x4) >> 2) << LCD_SEG14_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT5_COM2, LCD_DIGIT5_COM2_SEG_MASK, data) ; /* 5Q 5K 5P */
-      
-      data = ((Digit[2] & 0x1) << LCD_SEG8_SHIFT) | (((Digit[2] & 0x8) >> 3) << LCD_SEG15_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT5_COM2_1, LCD_DIGIT5_COM2_1_SEG_MASK, data) ; /* 5Q 5K 5P */
-      
-      data = (((Digit[3] & 0x2) >> 1) << LCD_SEG9_SHIFT) | (((Digit[3] & 0x4) >> 2) << LCD_SEG14_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT5_COM3, LCD_DIGIT5_COM3_SEG_MASK, data) ; /* 5H 5J 5N */
-      
-      data = ((Digit[3] & 0x1) << LCD_SEG8_SHIFT) | (((Digit[3] & 0x8) >> 3) << LCD_SEG15_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT5_COM3_1, LCD_DIGIT5_COM3_1_SEG_MASK, data) ; /* 5H 5J 5N */
-      break;
-    
-    /* Position 6 on LCD (Digit6)*/
-    case LCD_DIGIT_POSITION_6:
-      data = ((Digit[0] & 0x1) << LCD_SEG10_SHIFT) | (((Digit[0] & 0x2) >> 1) << LCD_SEG11_SHIFT)
-          | (((Digit[0] & 0x4) >> 2) << LCD_SEG12_SHIFT) | (((Digit[0] & 0x8) >> 3) << LCD_SEG13_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT6_COM0, LCD_DIGIT6_COM0_SEG_MASK, data); /* 6G 6B 6M 6E */
-      
-      data = ((Digit[1] & 0x1) << LCD_SEG10_SHIFT) | (((Digit[1] & 0x2) >> 1) << LCD_SEG11_SHIFT)
-          | (((Digit[1] & 0x4) >> 2) << LCD_SEG12_SHIFT) | (((Digit[1] & 0x8) >> 3) << LCD_SEG13_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT6_COM1, LCD_DIGIT6_COM1_SEG_MASK, data) ; /* 6G 6B 6M 6E */
-      
-      data = ((Digit[2] & 0x1) << LCD_SEG10_SHIFT) | (((Digit[2] & 0x2) >> 1) << LCD_SEG11_SHIFT)
-          | (((Digit[2] & 0x4) >> 2) << LCD_SEG12_SHIFT) | (((Digit[2] & 0x8) >> 3) << LCD_SEG13_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT6_COM2, LCD_DIGIT6_COM2_SEG_MASK, data) ; /* 6Q 6K 6P */
-      
-      data = ((Digit[3] & 0x1) << LCD_SEG10_SHIFT) | (((Digit[3] & 0x2) >> 1) << LCD_SEG11_SHIFT)
-          | (((Digit[3] & 0x4) >> 2) << LCD_SEG12_SHIFT) | (((Digit[3] & 0x8) >> 3) << LCD_SEG13_SHIFT);
-      HAL_LCD_Write(&LCDHandle, LCD_DIGIT6_COM3, LCD_DIGIT6_COM3_SEG_MASK, data) ; /* 6Q 6K 6P */
-      break;
-    
-     default:
-      break;
+  /* Set the digital point can be displayed if the point is on */
+  if (Point == POINT_ON)
+  {
+    glyph |= GLYPH_POINT;
+  }
+
+  /* Set the "COL" segment in the character that can be displayed if the column is on */
+  if (Column == DOUBLEPOINT_ON)
+  {
+    glyph |= GLYPH_COLON;
+  }
+
+  /* One masked store per COM, the nibble for COM0 is the most significant */
+  spread = DigitSpread[Position - 1];
+  for (com = 0; com < COM_PER_DIGIT_NB; com++)
+  {
+    LCD_FrameWrite(DigitCom[com], DigitMask[Position - 1], spread[(glyph >> (12 - 4 * com)) & 0x0F]);
   }
 
   /* Update the LCD display */
-  HAL_LCD_UpdateDisplayRequest(&LCDHandle);
+  LCD_FrameUpdate();
 }
 
 /**
@@ -611,6 +601,8 @@ void BSP_LCD_GLASS_DisplayString(uint8_t* ptr)
 {
   DigitPosition_Typedef position = LCD_DIGIT_POSITION_1;
 
+  BSP_LCD_GLASS_FrameBegin();
+
   /* Send the string character by character on lCD */
   while ((*ptr != 0) & (position <= LCD_DIGIT_POSITION_6))
   {
@@ -623,6 +615,8 @@ void BSP_LCD_GLASS_DisplayString(uint8_t* ptr)
     /* Increment the character counter */
     position++;
   }
+
+  BSP_LCD_GLASS_FrameEnd();
 }
 
 /**
@@ -636,6 +630,8 @@ void BSP_LCD_GLASS_DisplayStrDeci(uint16_t* ptr)
   DigitPosition_Typedef index = LCD_DIGIT_POSITION_1;
   uint8_t tmpchar = 0;
   
+  BSP_LCD_GLASS_FrameBegin();
+
   /* Send the string character by character on lCD */
   while((*ptr != 0) & (index <= LCD_DIGIT_POSITION_6))
   {      
@@ -660,6 +656,8 @@ void BSP_LCD_GLASS_DisplayStrDeci(uint16_t* ptr)
     /* Increment the character counter */
     index++;
   }
+
+  BSP_LCD_GLASS_FrameEnd();
 }
 
 /**
@@ -668,7 +666,10 @@ void BSP_LCD_GLASS_DisplayStrDeci(uint16_t* ptr)
   */
 void BSP_LCD_GLASS_Clear(void)
 {
-  HAL_LCD_Clear(&LCDHandle); 
+  memset(LCDFrame, 0, sizeof(LCDFrame));
+
+  /* Update the LCD display */
+  LCD_FrameUpdate();
 }
 
 /**
@@ -711,8 +712,10 @@ void BSP_LCD_GLASS_ScrollSentence(uint8_t* ptr, uint16_t nScroll, uint16_t Scrol
       *(str+3) =* (ptr1+((nbrchar+4)%sizestr));
       *(str+4) =* (ptr1+((nbrchar+5)%sizestr));
       *(str+5) =* (ptr1+((nbrchar+6)%sizestr));
+      BSP_LCD_GLASS_FrameBegin();
       BSP_LCD_GLASS_Clear();
       BSP_LCD_GLASS_DisplayString(str);
+      BSP_LCD_GLASS_FrameEnd();
       
       /* user button pressed stop the scrolling sentence */
       if(bLCDGlass_KeyPressed)
@@ -826,110 +829,71 @@ static void LCD_MspDeInit(LCD_HandleTypeDef *hlcd)
 }
 
 /**
-  * @brief  Converts an ascii char to the a LCD digit.
-  * @param  Char: a char to display.
-  * @param  Point: a point to add in front of char
-  *         This parameter can be: POINT_OFF or POINT_ON
-  * @param  DoublePoint : flag indicating if a column has to be add in front
-  *         of displayed character.
-  *         This parameter can be: DOUBLEPOINT_OFF or DOUBLEPOINT_ON.
+  * @brief  Writes a word of the frame shadow, same arguments as HAL_LCD_Write.
+  * @param  RAMRegisterIndex: LCD RAM register to modify
+  * @param  RAMRegisterMask: bits of the register to keep
+  * @param  Data: bits to set
   * @retval None
   */
-static void Convert(uint8_t* Char, Point_Typedef Point, DoublePoint_Typedef DoublePoint)
+static void LCD_FrameWrite(uint32_t RAMRegisterIndex, uint32_t RAMRegisterMask, uint32_t Data)
 {
-  uint16_t ch = 0 ;
-  uint8_t loop = 0, index = 0;
-  
-  switch (*Char)
-    {
-    case ' ' :
-      ch = 0x00;
-      break;
-
-    case '*':
-      ch = C_STAR;
-      break;
-
-    case '(' :
-      ch = C_OPENPARMAP;
-      break;
+  LCDFrame[RAMRegisterIndex] = (LCDFrame[RAMRegisterIndex] & RAMRegisterMask) | Data;
+}
 
-    case ')' :
-      ch = C_CLOSEPARMAP;
-      break;
-      
-    case 'm' :
-      ch = C_MMAP;
-      break;
-    
-    case 'n' :
-      ch = C_NMAP;
-      break;
+/**
+  * @brief  Commits the frame shadow unless a frame is being composed.
+  * @retval None
+  */
+static void LCD_FrameUpdate(void)
+{
+  if(LCDFrameDepth == 0)
+  {
+    LCD_FrameCommit();
+  }
+}
 
-    case '' :
-      ch = C_UMAP;
-      break;
+/**
+  * @brief  Copies the changed words of the frame shadow to the LCD RAM and
+  *         requests a display update. The request is not waited for, the LCD
+  *         RAM is write protected until the update is done so only the next
+  *         commit within the same LCD frame period has to wait.
+  * @retval None
+  */
+static void LCD_FrameCommit(void)
+{
+  uint32_t tickstart = 0;
+  uint32_t counter = 0;
+  uint8_t changed = 0;
 
-    case '-' :
-      ch = C_MINUS;
-      break;
+  for(counter = LCD_RAM_REGISTER0; counter <= LCD_RAM_REGISTER15; counter++)
+  {
+    if(LCDFrame[counter] == LCDCommitted[counter])
+    {
+      continue;
+    }
 
-    case '/' :
-      ch = C_SLATCH;
-      break;  
-      
-    case '' :
-      ch = C_PERCENT_1;
-      break;  
-    case '%' :
-      ch = C_PERCENT_2; 
-      break;
-    case 255 :
-      ch = C_FULL;
-      break ;
-    
-    case '0':
-    case '1':
-    case '2':
-    case '3':
-    case '4':
-    case '5':
-    case '6':
-    case '7':
-    case '8':
-    case '9':      
-      ch = NumberMap[*Char - ASCII_CHAR_0];    
-      break;
-          
-    default:
-      /* The character Char is one letter in upper case*/
-      if ( (*Char < ASCII_CHAR_LEFT_OPEN_BRACKET) && (*Char > ASCII_CHAR_AT_SYMBOL) )
-      {
-        ch = CapLetterMap[*Char - 'A'];
-      }
-      /* The character Char is one letter in lower case*/
-      if ( (*Char < ASCII_CHAR_LEFT_OPEN_BRACE) && ( *Char > ASCII_CHAR_APOSTROPHE) )
+    if(changed == 0)
+    {
+      /* Wait until the previous update request is done */
+      tickstart = HAL_GetTick();
+      while(__HAL_LCD_GET_FLAG(&LCDHandle, LCD_FLAG_UDR) != RESET)
       {
-        ch = CapLetterMap[*Char - 'a'];
+        if((HAL_GetTick() - tickstart) > LCD_UPDATE_TIMEOUT)
+        {
+          return;
+        }
       }
-      break;
-  }
-       
-  /* Set the digital point can be displayed if the point is on */
-  if (Point == POINT_ON)
-  {
-    ch |= 0x0002;
-  }
+      changed = 1;
+    }
 
-  /* Set the "COL" segment in the character that can be displayed if the column is on */
-  if (DoublePoint == DOUBLEPOINT_ON)
-  {
-    ch |= 0x0020;
-  }    
+    LCDHandle.Instance->RAM[counter] = LCDFrame[counter];
+    LCDCommitted[counter] = LCDFrame[counter];
+  }
 
-  for (loop = 12,index=0 ;index < 4; loop -= 4,index++)
+  if(changed)
   {
-    Digit[index] = (ch >> loop) & 0x0f; /*To isolate the less signifiant dibit */
+    __HAL_LCD_CLEAR_FLAG(&LCDHandle, LCD_FLAG_UDD);
+    LCDHandle.Instance->SR |= LCD_SR_UDR;
   }
 }
 
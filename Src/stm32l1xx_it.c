@@ -34,6 +34,13 @@
 #include "stm32l1xx_hal.h"
 #include "stm32l1xx.h"
 #include "stm32l1xx_it.h"
+#include "lora.h"
+#include "spi.h"
+#include "uart.h"
+#include "power.h"
+#include "button.h"
+#include "sched.h"
+#include "stm32l152c_discovery.h"
 
 /* USER CODE BEGIN 0 */
 
@@ -56,6 +63,7 @@ void SysTick_Handler(void)
   HAL_IncTick();
   HAL_SYSTICK_IRQHandler();
   /* USER CODE BEGIN SysTick_IRQn 1 */
+  button_tick();
 
   /* USER CODE END SysTick_IRQn 1 */
 }
@@ -67,6 +75,83 @@ void SysTick_Handler(void)
 /* please refer to the startup file (startup_stm32l1xx.s).                    */
 /******************************************************************************/
 
+#if SPI_USE_DMA
+/**
+* @brief This function handles DMA1 channel2 global interrupt (SPI1 RX).
+*/
+void DMA1_Channel2_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_spi1_rx);
+}
+
+/**
+* @brief This function handles DMA1 channel3 global interrupt (SPI1 TX).
+*/
+void DMA1_Channel3_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_spi1_tx);
+}
+#endif
+
+/**
+* @brief This function handles DMA1 channel4 global interrupt (USART1 TX).
+*/
+void DMA1_Channel4_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_usart1_tx);
+}
+
+/**
+* @brief This function handles USART1 global interrupt.
+*/
+void USART1_IRQHandler(void)
+{
+  HAL_UART_IRQHandler(&huart1);
+}
+
+/**
+* @brief This function handles RTC wakeup timer interrupt through EXTI line 20.
+*/
+void RTC_WKUP_IRQHandler(void)
+{
+  HAL_RTCEx_WakeUpTimerIRQHandler(&hrtc);
+}
+
+/**
+* @brief This function handles EXTI line0 interrupt (user button).
+*/
+void EXTI0_IRQHandler(void)
+{
+  HAL_GPIO_EXTI_IRQHandler(USER_BUTTON_PIN);
+}
+
+/**
+* @brief This function handles EXTI line[9:5] interrupts (RFM96 DIO0).
+*/
+void EXTI9_5_IRQHandler(void)
+{
+  HAL_GPIO_EXTI_IRQHandler(RFM96_DIO0_PIN);
+}
+
+/**
+* @brief EXTI line detection callback, dispatches to the pin owners.
+*/
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  /* Every pin event may have work for the main loop */
+  power_wake();
+
+  if(GPIO_Pin == RFM96_DIO0_PIN)
+  {
+    rfm96_dio0_irq_handler();
+    sched_publish(SCHED_EVENT_RADIO);
+  }
+  else if(GPIO_Pin == USER_BUTTON_PIN)
+  {
+    button_exti_irq_handler();
+  }
+}
+
 /* USER CODE BEGIN 1 */
 
 /* USER CODE END 1 */
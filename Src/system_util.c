@@ -9,6 +9,9 @@ void system_init(void)
 
 	/* Configure the system clock to 32 MHz */
 	SystemClock_Config();
+
+	/* Software timers, serviced from the main loop */
+	timer_wheel_init();
 	
 	/* SPI, NSS-pin and reset-pin initialization */
 	spi_init();
@@ -16,8 +19,11 @@ void system_init(void)
 	/* LCD display initialization */
 	BSP_LCD_GLASS_Init();
 
-	/* Blue push button initialization */
-	BSP_PB_Init(BUTTON_USER, BUTTON_MODE_GPIO);
+	/* RTC for waking up from STOP mode, runs on the LSE started for the LCD */
+	power_init();
+
+	/* Blue push button, pushes are classified in the background */
+	button_init();
 
 	/* Initialize LEDs */
 	BSP_LED_Init(LED3);
@@ -94,60 +100,43 @@ void Error_Handler(void)
 	/* USER CODE END Error_Handler */ 
 }
 
-/* Statistics ----------------------------------------------------------------*/
-double mean(int8_t a[], uint8_t n)
-{
-	double sum = 0.0;
-	for(int i = 0; i < n; i++)
-	{
-		sum += (double)a[i] / (double)n;
-	}
-	return sum;
-}
-
-/* Calculates sample variance */
-double variance(int8_t a[], uint8_t n, double mean) 
-{
-	double sum = 0.0;
-	double diff = 0.0;
-	for(int i = 0; i < n; i++)
-	{
-		diff = (double)a[i] - mean;
-		sum += (diff * diff);
-	}
-	sum /= (double)(n - 1);
-	return sum;
-}
-
-/* Calculates sample standard deviation */
-double std_dev(int8_t a[], uint8_t n, double mean) 
+/* Cycle counter -------------------------------------------------------------*/
+/*
+ * brief : starts the DWT cycle counter, used for benchmarks and latency 
+ *         measurements
+ */
+void cycle_counter_init(void)
 {
-	return sqrt(variance(a, n, mean));
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
 
-/* Button pushing ------------------------------------------------------------*/
-
 /*
- * brief : small helper function that polls the user button for a press 
+ * brief  : reads the DWT cycle counter, differences of two reads are valid
+ *          across wrap arounds
+ * retval : core clock cycles since cycle_counter_init
  */
-void wait_for_user_button(void)
+uint32_t cycle_counter_read(void)
 {
-	while(BSP_PB_GetState(BUTTON_USER) != 0);
-	while(BSP_PB_GetState(BUTTON_USER) != 1);
+	return DWT->CYCCNT;
 }
 
+/* Button pushing ------------------------------------------------------------*/
+
 /*
- * brief  : small helper function that polls the user button for a press 
- * retval : time in sysclock ticks that the button was held (should be ms) 
+ * brief  : small helper function that waits for the next push of the user 
+ *          button, stopped or sleeping in between
+ * retval : BUTTON_SHORT, BUTTON_LONG or BUTTON_DOUBLE
  */
-uint32_t wait_for_user_button_timed(void)
+enum button_event wait_for_user_button(void)
 {
-	uint32_t tickstart;
-
-	while(BSP_PB_GetState(BUTTON_USER) != 0); // make sure button wasn't held 
-	while(BSP_PB_GetState(BUTTON_USER) != 1); // wait for button push
-	tickstart = HAL_GetTick(); // check how long button is held 
-	while(BSP_PB_GetState(BUTTON_USER) != 0); // wait for button release 
+	enum button_event event;
 
-	return (HAL_GetTick() - tickstart); // return how long button was held 
+	button_clear();
+	while((event = button_get_event()) == BUTTON_NONE)
+	{
+		power_wait(POWER_WAIT_FOREVER);
+	}
+	return event;
 }
\ No newline at end of file
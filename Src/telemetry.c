@@ -0,0 +1,163 @@
+/*
+********************************************************************************
+* @file    telemetry.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Binary telemetry frames for streaming packet metadata to a host. 
+*          Records are serialized little endian, followed by a CRC-16-CCITT
+*          and COBS encoded so a 0 byte only ever marks the end of a frame. 
+*          Plain C, the host decoder builds this file as well
+********************************************************************************
+*/
+
+#include "telemetry.h"
+#include "crc.h"
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t* put_le(uint8_t* dst, uint32_t value, uint8_t size);
+static uint32_t get_le(const uint8_t* src, uint8_t size);
+
+/* Function definitions ------------------------------------------------------*/
+/*
+ * brief  : builds a complete frame, delimiter included
+ * frame  : at least TELEMETRY_FRAME_MAX bytes
+ * retval : frame size in bytes
+ */
+size_t telemetry_encode(const struct telemetry_record* record, uint8_t* frame)
+{
+	uint8_t raw[TELEMETRY_RECORD_SIZE + TELEMETRY_CRC_SIZE];
+	uint8_t* p = raw;
+	uint16_t crc;
+	size_t size;
+
+	p = put_le(p, record->type, 1);
+	p = put_le(p, record->session, 1);
+	p = put_le(p, record->seq, 2);
+	p = put_le(p, record->tick, 4);
+	p = put_le(p, (uint32_t)record->freq_error, 4);
+	p = put_le(p, (uint16_t)record->rssi, 2);
+	p = put_le(p, (uint8_t)record->snr, 1);
+	crc = crc16_ccitt(CRC16_CCITT_INIT, raw, TELEMETRY_RECORD_SIZE);
+	put_le(p, crc, 2);
+
+	size = cobs_encode(raw, sizeof(raw), frame);
+	frame[size++] = TELEMETRY_DELIMITER;
+
+	return size;
+}
+
+/*
+ * brief  : checks and parses a frame
+ * frame  : frame contents without the delimiter
+ * size   : frame size in bytes
+ * retval : 1 if the frame was valid, else 0
+ */
+uint8_t telemetry_decode(const uint8_t* frame, size_t size, struct telemetry_record* record)
+{
+	uint8_t raw[TELEMETRY_FRAME_MAX];
+	const uint8_t* p = raw;
+
+	if(size > TELEMETRY_FRAME_MAX
+		|| cobs_decode(frame, size, raw) != TELEMETRY_RECORD_SIZE + TELEMETRY_CRC_SIZE
+		|| crc16_ccitt(CRC16_CCITT_INIT, raw, TELEMETRY_RECORD_SIZE) != get_le(raw + TELEMETRY_RECORD_SIZE, 2))
+	{
+		return 0;
+	}
+
+	record->type = (uint8_t)get_le(p, 1);             p += 1;
+	record->session = (uint8_t)get_le(p, 1);          p += 1;
+	record->seq = (uint16_t)get_le(p, 2);             p += 2;
+	record->tick = get_le(p, 4);                      p += 4;
+	record->freq_error = (int32_t)get_le(p, 4);       p += 4;
+	record->rssi = (int16_t)(uint16_t)get_le(p, 2);   p += 2;
+	record->snr = (int8_t)(uint8_t)get_le(p, 1);
+
+	return 1;
+}
+
+/*
+ * brief  : consistent overhead byte stuffing, replaces every 0 byte with 
+ *          the distance to the next one
+ * dst    : at least size + size / 254 + 1 bytes
+ * retval : encoded size in bytes
+ */
+size_t cobs_encode(const uint8_t* src, size_t size, uint8_t* dst)
+{
+	size_t code_index = 0;
+	size_t out = 1;
+	uint8_t code = 1;
+
+	for(size_t i = 0; i < size; i++)
+	{
+		if(src[i] != 0)
+		{
+			dst[out++] = src[i];
+			code++;
+		}
+		if(src[i] == 0 || code == 0xFF)
+		{
+			dst[code_index] = code;
+			code_index = out++;
+			code = 1;
+		}
+	}
+	dst[code_index] = code;
+
+	return out;
+}
+
+/*
+ * brief  : reverses cobs_encode
+ * dst    : at least size bytes
+ * retval : decoded size in bytes, 0 if src holds a 0 byte or is truncated
+ */
+size_t cobs_decode(const uint8_t* src, size_t size, uint8_t* dst)
+{
+	size_t in = 0;
+	size_t out = 0;
+	uint8_t code;
+
+	while(in < size)
+	{
+		code = src[in++];
+		if(code == 0 || in + code - 1 > size)
+		{
+			return 0;
+		}
+		for(uint8_t i = 1; i < code; i++)
+		{
+			if(src[in] == 0)
+			{
+				return 0;
+			}
+			dst[out++] = src[in++];
+		}
+		if(code != 0xFF && in < size)
+		{
+			dst[out++] = 0;
+		}
+	}
+
+	return out;
+}
+
+/* Private function definitions ----------------------------------------------*/
+static uint8_t* put_le(uint8_t* dst, uint32_t value, uint8_t size)
+{
+	for(uint8_t i = 0; i < size; i++)
+	{
+		*dst++ = (uint8_t)(value >> (8 * i));
+	}
+	return dst;
+}
+
+static uint32_t get_le(const uint8_t* src, uint8_t size)
+{
+	uint32_t value = 0;
+	for(uint8_t i = 0; i < size; i++)
+	{
+		value |= (uint32_t)src[i] << (8 * i);
+	}
+	return value;
+}
@@ -0,0 +1,256 @@
+/*
+********************************************************************************
+* @file    timer_wheel.c
+* @author  Rasmus Källqvist
+* @version V1.0.0
+* @date    08-May-2018
+* @brief   Software timers on a hierarchical timer wheel. Each level has
+*          TIMER_WHEEL_SLOTS lists of timers, level 0 one per ms and every
+*          level above covering a whole turn of the one below, so starting and
+*          stopping a timer is O(1). Timers far out are moved down a level as
+*          their slot comes up. Callbacks run from timer_wheel_process in the
+*          main loop, nothing here is interrupt safe
+********************************************************************************
+*/
+
+#include "timer_wheel.h"
+
+/* Private defines -----------------------------------------------------------*/
+#define SLOT_MASK              (TIMER_WHEEL_SLOTS - 1)
+#define LEVEL_SHIFT(level)     ((level) * TIMER_WHEEL_BITS)
+#define WHEEL_REACH            (1UL << LEVEL_SHIFT(TIMER_WHEEL_LEVELS))
+
+/* Private variables ---------------------------------------------------------*/
+static struct timer* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+static uint32_t current;   // next tick to process
+static uint32_t armed;     // timers in the wheel
+
+/* Private function prototypes -----------------------------------------------*/
+static void timer_link(struct timer* timer);
+static void timer_unlink(struct timer* timer);
+static void timer_cascade(uint8_t level);
+
+/* Function definitions ------------------------------------------------------*/
+void timer_wheel_init(void)
+{
+	for(uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++)
+	{
+		for(uint8_t slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+		{
+			slots[level][slot] = 0;
+		}
+	}
+	current = HAL_GetTick();
+	armed = 0;
+}
+
+/*
+ * brief : runs the callbacks of every timer that has expired since the last
+ *         call. Ticks passed in STOP mode are caught up here, a periodic 
+ *         timer fires once for all the periods it missed
+ */
+void timer_wheel_process(void)
+{
+	uint32_t now = HAL_GetTick();
+	struct timer* list;
+	struct timer* timer;
+	uint8_t level;
+
+	/* Nothing armed, skip ahead rather than walk the empty slots */
+	if(armed == 0)
+	{
+		current = now + 1;
+		return;
+	}
+
+	while((int32_t)(now - current) >= 0)
+	{
+		/* Move the timers of the slots coming up on the higher levels down */
+		for(level = 1; level < TIMER_WHEEL_LEVELS
+			&& (current & ((1UL << LEVEL_SHIFT(level)) - 1)) == 0; level++)
+		{
+			timer_cascade(level);
+		}
+
+		/* Detach the expired slot, timers started by the callbacks for
+		 * this tick go in the next one */
+		list = slots[0][current & SLOT_MASK];
+		slots[0][current & SLOT_MASK] = 0;
+		if(list != 0)
+		{
+			list->pprev = &list;
+		}
+		current++;
+
+		while(list != 0)
+		{
+			timer = list;
+			timer_unlink(timer);
+			if(timer->period != 0)
+			{
+				/* Periods missed in STOP mode are skipped, not run back to
+				 * back, the timer keeps its phase */
+				timer->expires += timer->period;
+				if((int32_t)(now - timer->expires) >= 0)
+				{
+					timer->expires += ((now - timer->expires) / timer->period + 1) * timer->period;
+				}
+				timer_link(timer);
+			}
+			timer->callback(timer->arg);
+		}
+	}
+}
+
+/*
+ * brief  : time until timer_wheel_process has work, for sleeping in between.
+ *          Timers on the higher levels count from when their slot is moved
+ *          down, so this may wake up early but never late
+ * retval : ms, 0 if a timer is due now, TIMER_NO_DEADLINE if none is armed
+ */
+uint32_t timer_wheel_time_left(void)
+{
+	uint32_t now = HAL_GetTick();
+	uint32_t best = TIMER_NO_DEADLINE;
+	uint32_t first;
+	uint32_t tick;
+	uint8_t shift;
+
+	if(armed == 0)
+	{
+		return TIMER_NO_DEADLINE;
+	}
+
+	for(uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++)
+	{
+		/* First slot boundary of this level not yet processed */
+		shift = LEVEL_SHIFT(level);
+		first = (current + (1UL << shift) - 1) >> shift;
+		for(uint8_t i = 0; i < TIMER_WHEEL_SLOTS; i++)
+		{
+			if(slots[level][(first + i) & SLOT_MASK] != 0)
+			{
+				tick = (first + i) << shift;
+				if(tick - current < best)
+				{
+					best = tick - current;
+				}
+				break;
+			}
+		}
+	}
+
+	tick = current + best;
+	return (int32_t)(tick - now) <= 0 ? 0 : tick - now;
+}
+
+void timer_init(struct timer* timer, timer_callback callback, void* arg)
+{
+	timer->next = 0;
+	timer->pprev = 0;
+	timer->period = 0;
+	timer->callback = callback;
+	timer->arg = arg;
+}
+
+/*
+ * brief  : (re)starts a timer
+ * delay  : ms until the first expiry
+ * period : ms between later expiries, 0 for a one-shot timer
+ */
+void timer_start(struct timer* timer, uint32_t delay, uint32_t period)
+{
+	if(timer->pprev != 0)
+	{
+		timer_unlink(timer);
+	}
+	timer->expires = HAL_GetTick() + delay;
+	timer->period = period;
+	timer_link(timer);
+}
+
+/*
+ * brief : stops a timer, stopping one that is not running is harmless
+ */
+void timer_stop(struct timer* timer)
+{
+	if(timer->pprev != 0)
+	{
+		timer_unlink(timer);
+	}
+}
+
+uint8_t timer_active(const struct timer* timer)
+{
+	return timer->pprev != 0;
+}
+
+/* Private function definitions ----------------------------------------------*/
+/*
+ * brief : puts a timer in the slot of the lowest level that reaches its
+ *         expiry. Expiries already passed go in the next slot to process
+ */
+static void timer_link(struct timer* timer)
+{
+	uint32_t at = timer->expires;
+	uint32_t delta;
+	uint8_t level;
+	struct timer** slot;
+
+	if((int32_t)(at - current) < 0)
+	{
+		at = current;
+	}
+	delta = at - current;
+	if(delta >= WHEEL_REACH)
+	{
+		/* Parked in the farthest slot, moved again when it comes up */
+		at = current + WHEEL_REACH - 1;
+		delta = WHEEL_REACH - 1;
+	}
+
+	for(level = 0; level < TIMER_WHEEL_LEVELS - 1
+		&& delta >= (1UL << LEVEL_SHIFT(level + 1)); level++);
+
+	slot = &slots[level][(at >> LEVEL_SHIFT(level)) & SLOT_MASK];
+	timer->next = *slot;
+	if(*slot != 0)
+	{
+		(*slot)->pprev = &timer->next;
+	}
+	*slot = timer;
+	timer->pprev = slot;
+	armed++;
+}
+
+static void timer_unlink(struct timer* timer)
+{
+	*timer->pprev = timer->next;
+	if(timer->next != 0)
+	{
+		timer->next->pprev = timer->pprev;
+	}
+	timer->next = 0;
+	timer->pprev = 0;
+	armed--;
+}
+
+/*
+ * brief : relinks the timers of the level's slot that starts at the current
+ *         tick, they all land on lower levels
+ */
+static void timer_cascade(uint8_t level)
+{
+	struct timer** slot = &slots[level][(current >> LEVEL_SHIFT(level)) & SLOT_MASK];
+	struct timer* list = *slot;
+	struct timer* timer;
+
+	*slot = 0;
+	while(list != 0)
+	{
+		timer = list;
+		list = timer->next;
+		armed--;
+		timer_link(timer);
+	}
+}
@@ -0,0 +1,212 @@
+/*
+********************************************************************************
+* File Name          : UART.c
+* Description        : This file provides code for the configuration
+*                      of the USART1 instance used for telemetry. Data is 
+*                      queued in a ring buffer and sent by DMA in the 
+*                      background, TX only on PB6
+********************************************************************************
+*/
+
+/* Includes ------------------------------------------------------------------*/
+#include "uart.h"
+#include "power.h"
+
+UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_usart1_tx;
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t tx_buffer[UART_TX_BUFFER_SIZE];
+static volatile uint32_t tx_head;     // written by uart_write
+static volatile uint32_t tx_tail;     // advanced when a DMA transfer is done
+static volatile uint32_t tx_dma_size; // bytes in the running transfer, 0 if idle
+
+/* Private function prototypes -----------------------------------------------*/
+static void uart_start_dma(void);
+
+/* USART1 init function */
+void uart_init(void)
+{
+	huart1.Instance          = USART1;
+	huart1.Init.BaudRate     = UART_BAUD_RATE;
+	huart1.Init.WordLength   = UART_WORDLENGTH_8B;
+	huart1.Init.StopBits     = UART_STOPBITS_1;
+	huart1.Init.Parity       = UART_PARITY_NONE;
+	huart1.Init.Mode         = UART_MODE_TX;
+	huart1.Init.HwFlowCtl    = UART_HWCONTROL_NONE;
+	huart1.Init.OverSampling = UART_OVERSAMPLING_16;
+
+	if (HAL_UART_Init(&huart1) != HAL_OK)
+	{
+		Error_Handler();
+	}
+
+	tx_head = 0;
+	tx_tail = 0;
+	tx_dma_size = 0;
+}
+
+/*
+ * brief : queues bytes for transmission, waiting for room in the buffer
+ *         if it is full. Call from the main loop only
+ */
+void uart_write(const uint8_t* data, size_t size)
+{
+	uint32_t primask;
+	uint32_t room;
+
+	while(size > 0)
+	{
+		/* Sleep until the DMA has made room */
+		while((room = UART_TX_BUFFER_SIZE - (tx_head - tx_tail)) == 0)
+		{
+			__WFI();
+		}
+		if(room > size)
+		{
+			room = size;
+		}
+
+		for(uint32_t i = 0; i < room; i++)
+		{
+			tx_buffer[(tx_head + i) & (UART_TX_BUFFER_SIZE - 1)] = data[i];
+		}
+		__DMB();
+		tx_head += room;
+		data += room;
+		size -= room;
+
+		/* Start sending unless a transfer is running, its completion will
+		 * pick up the new bytes */
+		primask = __get_PRIMASK();
+		__disable_irq();
+		uart_start_dma();
+		__set_PRIMASK(primask);
+	}
+}
+
+/*
+ * brief : waits until all queued bytes have been sent
+ */
+void uart_flush(void)
+{
+	while(tx_head != tx_tail)
+	{
+		__WFI();
+	}
+}
+
+/*
+ * brief : sends the queued bytes up to the end of the buffer, called with 
+ *         interrupts disabled or from the transfer complete interrupt
+ */
+static void uart_start_dma(void)
+{
+	uint32_t start;
+	uint32_t size;
+
+	if(tx_dma_size != 0 || tx_head == tx_tail)
+	{
+		return;
+	}
+
+	start = tx_tail & (UART_TX_BUFFER_SIZE - 1);
+	size = tx_head - tx_tail;
+	if(size > UART_TX_BUFFER_SIZE - start)
+	{
+		size = UART_TX_BUFFER_SIZE - start;
+	}
+
+	tx_dma_size = size;
+	if(HAL_UART_Transmit_DMA(&huart1, &tx_buffer[start], size) != HAL_OK)
+	{
+		tx_dma_size = 0;
+		return;
+	}
+
+	/* The USART is clocked from the PLL, stay out of STOP until it is done */
+	power_stop_lock();
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* uartHandle)
+{
+	tx_tail += tx_dma_size;
+	tx_dma_size = 0;
+	power_stop_unlock();
+	uart_start_dma();
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef* uartHandle)
+{
+	/* Drop the failed transfer rather than stalling the queue */
+	if(tx_dma_size != 0)
+	{
+		tx_tail += tx_dma_size;
+		tx_dma_size = 0;
+		power_stop_unlock();
+	}
+	uart_start_dma();
+}
+
+void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
+{
+	GPIO_InitTypeDef GPIO_InitStruct;
+	if(uartHandle->Instance==USART1)
+	{
+		/* Peripheral clock enable */
+		__HAL_RCC_USART1_CLK_ENABLE();
+		__HAL_RCC_GPIOB_CLK_ENABLE();
+
+		/**USART1 GPIO Configuration, shared with the blue LED    
+		PB6     ------> USART1_TX
+		*/
+		GPIO_InitStruct.Pin = GPIO_PIN_6;
+		GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+		GPIO_InitStruct.Pull = GPIO_PULLUP;
+		GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+		GPIO_InitStruct.Alternate = GPIO_AF7_USART1;
+		HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+		/* USART1 DMA Init, TX on DMA1 channel 4 */
+		__HAL_RCC_DMA1_CLK_ENABLE();
+
+		hdma_usart1_tx.Instance                 = DMA1_Channel4;
+		hdma_usart1_tx.Init.Direction           = DMA_MEMORY_TO_PERIPH;
+		hdma_usart1_tx.Init.PeriphInc           = DMA_PINC_DISABLE;
+		hdma_usart1_tx.Init.MemInc              = DMA_MINC_ENABLE;
+		hdma_usart1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+		hdma_usart1_tx.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+		hdma_usart1_tx.Init.Mode                = DMA_NORMAL;
+		hdma_usart1_tx.Init.Priority            = DMA_PRIORITY_LOW;
+		if (HAL_DMA_Init(&hdma_usart1_tx) != HAL_OK)
+		{
+			Error_Handler();
+		}
+		__HAL_LINKDMA(uartHandle, hdmatx, hdma_usart1_tx);
+
+		/* Telemetry is the least urgent, below the radio interrupts */
+		HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 0x03, 0);
+		HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+		HAL_NVIC_SetPriority(USART1_IRQn, 0x03, 0);
+		HAL_NVIC_EnableIRQ(USART1_IRQn);
+	}
+}
+
+void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
+{
+	if(uartHandle->Instance==USART1)
+	{
+		/* Peripheral clock disable */
+		__HAL_RCC_USART1_CLK_DISABLE();
+
+		/**USART1 GPIO Configuration    
+		PB6     ------> USART1_TX
+		*/
+		HAL_GPIO_DeInit(GPIOB, GPIO_PIN_6);
+
+		/* USART1 DMA DeInit */
+		HAL_DMA_DeInit(uartHandle->hdmatx);
+		HAL_NVIC_DisableIRQ(DMA1_Channel4_IRQn);
+		HAL_NVIC_DisableIRQ(USART1_IRQn);
+	}
+}